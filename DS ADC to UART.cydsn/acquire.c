@@ -0,0 +1,837 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stddef.h>
+#include "acquire.h"
+#include "hal.h"
+#include "tsframe.h"
+#include "tspack.h"
+#include "uart_tx.h"
+#include "timebase.h"
+#include "decimate.h"
+#include "burst.h"
+#include "profile.h"
+#include "textfmt.h"
+#include "rx.h"
+#include "calstore.h"
+#include "command.h"
+#include "activity.h"
+#include "history.h"
+
+// filter delay in timebase counts, to stamp each output with the time of
+// the input it is centred on
+#define FILTER_DELAY ((uint32_t)(((uint64_t)TIMEBASE_HZ * DECIMATE_DELAY) / HAL_ADC_HZ))
+
+// of the transmit ring that frames sent again leave to the live stream, and
+// a burst being sent leaves to them
+#define RESEND_RESERVE (UART_TX_RING_SIZE / 4u)
+
+uint16_t frame_seq = 0; // numbers every frame the board sends
+
+static frame_t frame;
+static frame_t hello;
+static uint16_t frames = 0;
+static decimate_t filter; // replaces averaging every 46 samples, see decimate_taps.h
+static rx_frame_t request;
+static frame_t reply;
+static history_t history; // the sample frames sent lately, for the host to ask for again
+#if PROFILE_ENABLE
+static frame_t telemetry;
+static uint16_t report_blocks = 0;
+#endif
+
+#if OUTPUT_BURST && HAL_CHANNELS > 1
+#error "burst capture works on a single input"
+#endif
+#if OUTPUT_BINARY && OUTPUT_PACKED && (OUTPUT_BURST || HAL_CHANNELS > 1)
+#error "packed frames carry the stream of a single input"
+#endif
+
+static void make_hello(frame_t *f)
+{
+    frame_Hello(f, TIMEBASE_MICROS_HZ, (calstore.flags & CALSTORE_NEWTONS) ? FRAME_HELLO_NEWTONS : 0u,
+                calstore.board_id);
+}
+
+// What goes out for a load cell reading: counts, or milli-newtons once the
+// host has asked for them (calstore.h).
+static int32_t load_units(int32_t reading)
+{
+    return (calstore.flags & CALSTORE_NEWTONS) ? calstore_Newtons(reading) : reading;
+}
+
+static uint8_t text_mode(void)
+{
+    return command_Value[COMMAND_FORMAT] == COMMAND_FORMAT_TEXT;
+}
+
+// Sends a finished frame of samples, or one the host needs to read them,
+// and keeps it for the host to ask for again. It is kept even when the
+// transmit ring turns it away, so a saturated link costs a resend, not the
+// samples.
+static uint8_t send_kept(const frame_t *f)
+{
+    history_Put(&history, f->buf, f->size);
+    return uart_tx_Write(f->buf, f->size);
+}
+
+#if OUTPUT_BURST
+static burst_t burst; // too big for the stack
+static uint16_t burst_next = 0; // samples of the ready window queued so far
+static uint64_t burst_t0 = 0;   // timebase count of its trigger
+
+// Sends as much of a ready burst as fits in the transmit ring, short of
+// RESEND_RESERVE so that frames the host missed can go out again ahead of
+// the rest, and re-arms the capture once all of it is queued.
+static void send_burst(void)
+{
+    uint16_t count = burst_Count(&burst);
+    uint64_t ticks;
+    int32_t reading;
+    uint32_t t0;
+
+    if(burst_next == 0u){
+        if(uart_tx_Free() < 2u * FRAME_MAX_SIZE){
+            return;
+        }
+        make_hello(&frame);
+        uart_tx_Write(frame.buf, frame.size);
+        frame_Burst(&frame, (uint32_t)timebase_Micros(burst_t0), count, burst.pre, burst.stride);
+        send_kept(&frame);
+        frame_BeginSamples(&frame);
+    }
+    while(burst_next < count && uart_tx_Free() >= FRAME_MAX_SIZE + RESEND_RESERVE){
+        ticks = (uint64_t)((int64_t)burst_t0 + burst_Offset(&burst, burst_next));
+        reading = load_units(burst_Get(&burst, burst_next));
+        burst_next++;
+        if(frame_AddSample(&frame, (uint32_t)timebase_Micros(ticks), reading) ||
+           burst_next == count){
+            t0 = profile_Start();
+            frame_Finish(&frame);
+            send_kept(&frame);
+            frame_BeginSamples(&frame);
+            profile_Stop(PROFILE_SEND, t0);
+        }
+    }
+    if(burst_next == count){
+        burst_next = 0u;
+        burst_Arm(&burst);
+    }
+}
+
+// Starts the capture over with the trigger and stride in force, unless a
+// window is still being sent.
+static uint8_t rearm_burst(void)
+{
+    if(burst.state == BURST_READY){
+        return COMMAND_BUSY;
+    }
+    burst_Init(&burst, BURST_PRE, BURST_POST, (uint16_t)command_Value[COMMAND_RATE],
+               command_Value[COMMAND_TRIGGER_LEVEL],
+               command_Value[COMMAND_TRIGGER_EDGE] ? BURST_FALLING : BURST_RISING);
+    burst_Arm(&burst);
+    return COMMAND_OK;
+}
+
+static void burst_block(const int16_t *block, const uint32_t *times)
+{
+    uint8_t was_ready = (burst.state == BURST_READY);
+    uint64_t ticks;
+
+    burst_Push(&burst, block, times, HAL_BLOCK_SIZE);
+    // keep the 64 bit timebase moving whether or not anything triggered
+    ticks = timebase_Extend(times[HAL_BLOCK_SIZE - 1u]);
+    if(burst.state == BURST_READY && !was_ready){
+        burst_t0 = ticks - (uint32_t)(times[HAL_BLOCK_SIZE - 1u] - burst.t_trigger);
+    }
+}
+#else
+
+static uint8_t restarted = 0u;  // the adc was restarted at restart_tick
+static uint32_t restart_tick = 0u;
+
+static void restart(uint32_t t); // of the output path below
+
+// Working through a block takes longer than either FIFO lasts: both hold 4
+// bytes, 350 us of line at 115200 baud. The block loops empty and refill
+// them every 16 conversions. To keep up with the adc the loop gets through
+// those in under their 145 us at 110 ksps, well inside the 350 us. Servicing
+// TX only between blocks left the line idle while a block was filtered.
+static void service_fifos(void)
+{
+    rx_Service();
+    (void)uart_tx_Service();
+}
+
+// Conversions from before an adc restart are dropped, and the first one
+// after it starts the outputs over as at reset.
+static uint8_t before_restart(uint32_t t)
+{
+    if(restarted == 0u){
+        return 0u;
+    }
+    if((int32_t)(t - restart_tick) < 0){
+        return 1u;
+    }
+    restarted = 0u;
+    restart(t);
+    return 0u;
+}
+
+#if HAL_CHANNELS > 1
+
+// One output sample per COMMAND_RATE visits of the mux to an input: the
+// mean of their HAL_DWELL conversions each, stamped at the middle of the
+// span. Each input gets its own frames.
+typedef struct {
+    frame_t frame;
+    int32_t sum;
+    uint16_t n;
+    uint8_t visits;
+    uint32_t t_first;
+    uint32_t t_last;
+} channel_t;
+
+static channel_t channels[HAL_CHANNELS];
+static uint8_t current = HAL_SETTLING; // input of the visit being summed
+
+// Drops what has been summed towards the next sample of every input.
+static void drop_partial(void)
+{
+    uint8_t i;
+
+    for(i=0; i<HAL_CHANNELS; i++){
+        channels[i].sum = 0;
+        channels[i].n = 0;
+        channels[i].visits = 0;
+    }
+}
+
+static void begin_frames(void)
+{
+    uint8_t i;
+
+    for(i=0; i<HAL_CHANNELS; i++){
+        frame_BeginChannel(&channels[i].frame, i);
+    }
+}
+
+static void restart(uint32_t t)
+{
+    (void)t; // capture.c lets the new input settle as after any switch
+    drop_partial();
+}
+
+static void end_visit(void)
+{
+    channel_t *c;
+    int32_t reading;
+    uint64_t t;
+    uint32_t t0;
+    char text[TEXTFMT_LINE_MAX + 4u];
+    uint8_t n;
+
+    if(current == HAL_SETTLING){
+        return;
+    }
+    c = &channels[current];
+    if(c->n == 0u || ++c->visits < (uint8_t)command_Value[COMMAND_RATE]){
+        current = HAL_SETTLING;
+        return;
+    }
+    reading = c->sum / (int32_t)c->n; // hardware divide, once per sample
+    t = timebase_Micros(timebase_Extend(c->t_first + (c->t_last - c->t_first) / 2u));
+    c->sum = 0;
+    c->n = 0;
+    c->visits = 0;
+
+    t0 = profile_Start();
+    if(text_mode()){
+        // "millis:reading:input"
+        n = (uint8_t)(textfmt_Line(text, textfmt_Millis(t), reading) - 2u);
+        text[n++] = ':';
+        n += textfmt_U32(&text[n], current);
+        text[n++] = '\r';
+        text[n++] = '\n';
+        uart_tx_Write((uint8_t *)text, n);
+    }else if(frame_AddSample(&c->frame, (uint32_t)t, current == 0u ? load_units(reading) : reading)){
+        frame_Finish(&c->frame);
+        send_kept(&c->frame);
+        frame_BeginChannel(&c->frame, current);
+        if(++frames == HELLO_EVERY){
+            frames = 0;
+            make_hello(&hello);
+            uart_tx_Write(hello.buf, hello.size);
+        }
+    }
+    profile_Stop(PROFILE_SEND, t0);
+    current = HAL_SETTLING;
+}
+
+static void channel_block(const int16_t *block, const uint32_t *times, const uint8_t *tags)
+{
+    unsigned int i;
+    channel_t *c;
+
+    for(i=0; i<HAL_BLOCK_SIZE; i++){
+        if((i & 15u) == 0u){
+            service_fifos();
+        }
+        if(before_restart(times[i])){
+            continue;
+        }
+        if(tags[i] != current){
+            end_visit();
+            current = tags[i];
+        }
+        if(current == HAL_SETTLING){
+            continue;
+        }
+        c = &channels[current];
+        if(c->n == 0u){
+            c->t_first = times[i];
+        }
+        c->sum += block[i];
+        c->n++;
+        c->t_last = times[i];
+    }
+}
+
+#else
+
+// COMMAND_RATE filtered samples are averaged into each one sent
+static int32_t divide_sum = 0;
+static uint8_t divide_n = 0;
+static uint64_t divide_first = 0; // timebase count of the first of them
+static uint64_t settled = FILTER_DELAY; // earlier outputs are the filter's start-up transient
+static pack_t pack; // COMMAND_FORMAT_PACKED's frame
+
+// While the stand is idle (activity.h), COMMAND_IDLE_RATE of those
+// averages are averaged again into each one sent. They are held until
+// then, so the ones still waiting when activity starts go out at the full
+// rate instead.
+static activity_t activity;
+static uint64_t idle_t[OUTPUT_IDLE_RATE_MAX]; // microseconds
+static int32_t idle_reading[OUTPUT_IDLE_RATE_MAX];
+static uint8_t idle_n = 0;
+static frame_t marker;
+static uint8_t marker_unsent = 0u; // found the transmit ring full
+
+static void drop_partial(void)
+{
+    divide_sum = 0;
+    divide_n = 0;
+    idle_n = 0;
+}
+
+static uint8_t packed_mode(void)
+{
+    return command_Value[COMMAND_FORMAT] == COMMAND_FORMAT_PACKED;
+}
+
+// Microseconds between full rate samples, in 24.8 fixed point.
+static uint32_t full_period(void)
+{
+    uint64_t conversions = (uint64_t)DECIMATE_RATIO * (uint32_t)command_Value[COMMAND_RATE];
+
+    return (uint32_t)((conversions * TIMEBASE_MICROS_HZ * 256u + HAL_ADC_HZ / 2u) / HAL_ADC_HZ);
+}
+
+// Full rate samples averaged into each one sent while idle: COMMAND_IDLE_RATE,
+// cut so that the samples stay under 65 ms apart, the most a sample
+// record's dt holds. 1 means the rate never changes.
+static uint8_t idle_factor(void)
+{
+    uint32_t most = (0xFFFFul << 8) / full_period();
+    uint8_t factor = (uint8_t)command_Value[COMMAND_IDLE_RATE];
+
+    if(factor > most){
+        factor = (uint8_t)most;
+    }
+    return (factor > 1u) ? factor : 1u;
+}
+
+static uint8_t idle(void)
+{
+    return idle_factor() > 1u && activity.active == 0u;
+}
+
+// Microseconds between the samples sent, in 24.8 fixed point, from which
+// packed frames predict their timestamps.
+static uint32_t sample_period(void)
+{
+    return full_period() * (idle() ? idle_factor() : 1u);
+}
+
+static void begin_frames(void)
+{
+    frame_BeginSamples(&frame);
+    pack_Restart(&pack, sample_period());
+}
+
+// The board time, in microseconds, of the filter output due now; a change
+// of setting applies from there.
+static uint64_t now_micros(void)
+{
+    uint64_t ticks = timebase_At(hal_Ticks());
+
+    return (ticks > FILTER_DELAY) ? timebase_Micros(ticks - FILTER_DELAY) : 0u;
+}
+
+// Tells the host the spacing of the samples from microsecond t on.
+static void put_rate(uint64_t t)
+{
+    if(text_mode()){
+        return;
+    }
+    frame_Begin(&marker, FRAME_TYPE_RATE);
+    frame_Put(&marker, (uint32_t)t, 4u);
+    frame_Put(&marker, sample_period(), 4u);
+    frame_Put(&marker, (uint32_t)command_Value[COMMAND_RATE] * (idle() ? idle_factor() : 1u), 2u);
+    frame_Put(&marker, idle() ? FRAME_RATE_IDLE : 0u, 1u);
+    frame_Finish(&marker);
+    marker_unsent = (send_kept(&marker) == 0u);
+}
+
+// Sends the sample frame just filled, in the format set, and starts the
+// next.
+static void send_frame(void)
+{
+    if(marker_unsent){
+        // without it the host would misread the spacing of what follows.
+        // Frames have gone out since it was numbered, so it takes the next
+        // seq; the one it had is a gap the host may ask about.
+        marker.size -= FRAME_CRC_SIZE;
+        frame_Finish(&marker);
+        marker_unsent = (send_kept(&marker) == 0u);
+    }
+    if(packed_mode()){
+        (void)pack_Finish(&pack);
+        send_kept(&pack.frame);
+        pack_Begin(&pack, pack.period);
+    }else{
+        frame_Finish(&frame);
+        send_kept(&frame);
+        frame_BeginSamples(&frame);
+    }
+    if(++frames == HELLO_EVERY){
+        frames = 0;
+        make_hello(&hello);
+        uart_tx_Write(hello.buf, hello.size);
+        put_rate(now_micros()); // for hosts that connect late, as the hello
+    }
+}
+
+// Changes the spacing of the samples sent from microsecond t on. The frame
+// in progress goes out first, so the rate frame sits between the last
+// sample at the old spacing and the first at the new.
+static void send_rate(uint64_t t)
+{
+    if(packed_mode() ? pack.count > 0u : frame.count > 0u){
+        send_frame();
+    }
+    pack_Restart(&pack, sample_period());
+    put_rate(t);
+}
+
+static void restart(uint32_t t)
+{
+    uint8_t was_idle = idle();
+
+    decimate_Init(&filter);
+    settled = timebase_Extend(t) + FILTER_DELAY;
+    drop_partial();
+    activity_Init(&activity); // the new adc configuration may read differently
+    if(idle() != was_idle){
+        send_rate(timebase_Micros(settled - FILTER_DELAY));
+    }
+}
+
+static void send_sample(uint64_t t, int32_t reading)
+{
+    uint32_t t0;
+    char text[TEXTFMT_LINE_MAX];
+    uint8_t n;
+
+    if(text_mode()){
+        t0 = profile_Start();
+        n = textfmt_Line(text, textfmt_Millis(t), reading);
+        uart_tx_Write((uint8_t *)text, n);
+        profile_Stop(PROFILE_SEND, t0);
+    }else if(packed_mode() ? pack_Add(&pack, (uint32_t)t, load_units(reading))
+                           : frame_AddSample(&frame, (uint32_t)t, load_units(reading))){
+        t0 = profile_Start();
+        send_frame();
+        profile_Stop(PROFILE_SEND, t0);
+    }
+}
+
+// Takes a full rate sample: sends it, or while idle, holds it towards the
+// next average.
+static void take_sample(uint64_t t, int32_t reading)
+{
+    uint8_t factor = idle_factor();
+    int32_t sum = 0;
+    uint8_t i;
+
+    if(factor > 1u){
+        switch(activity_Push(&activity, reading)){
+        case ACTIVITY_START:
+            send_rate(idle_n > 0u ? idle_t[0] : t);
+            for(i=0; i<idle_n; i++){
+                send_sample(idle_t[i], idle_reading[i]);
+            }
+            idle_n = 0;
+            break;
+        case ACTIVITY_END:
+            send_rate(t);
+            break;
+        default:
+            break;
+        }
+    }
+    if(idle() == 0u){
+        send_sample(t, reading);
+        return;
+    }
+    idle_t[idle_n] = t;
+    idle_reading[idle_n] = reading;
+    if(++idle_n < factor){
+        return;
+    }
+    for(i=0; i<idle_n; i++){
+        sum += idle_reading[i];
+    }
+    // stamped at the middle of the samples averaged
+    send_sample(idle_t[0] + (idle_t[idle_n - 1u] - idle_t[0]) / 2u, sum / (int32_t)idle_n);
+    idle_n = 0;
+}
+
+static void stream_block(const int16_t *block, const uint32_t *times)
+{
+    unsigned int i;
+    int32_t reading;
+    uint64_t ticks;
+
+    for(i=0; i<HAL_BLOCK_SIZE; i++){
+        if((i & 15u) == 0u){
+            service_fifos();
+        }
+        if(before_restart(times[i])){
+            continue;
+        }
+        if(decimate_Push(&filter, block[i], &reading) == 0u){
+            continue;
+        }
+        ticks = timebase_Extend(times[i]);
+        if(ticks < settled){
+            continue; // still the start-up transient
+        }
+        if(divide_n == 0u){
+            divide_first = ticks;
+        }
+        divide_sum += reading;
+        if(++divide_n < (uint8_t)command_Value[COMMAND_RATE]){
+            continue;
+        }
+        reading = divide_sum / (int32_t)divide_n;
+        ticks = divide_first + (ticks - divide_first) / 2u;
+        divide_sum = 0;
+        divide_n = 0;
+        take_sample(timebase_Micros(ticks - FILTER_DELAY), reading);
+    }
+}
+#endif /* HAL_CHANNELS */
+#endif /* OUTPUT_BURST */
+
+void acquire_Start(void)
+{
+    hal_Start();
+    decimate_Init(&filter);
+    calstore_Start();
+    command_Start();
+#if OUTPUT_BURST
+    (void)rearm_burst();
+#else
+    begin_frames();
+#endif
+    if(!text_mode()){
+        make_hello(&hello);
+        uart_tx_Write(hello.buf, hello.size);
+#if !OUTPUT_BURST && HAL_CHANNELS == 1
+        put_rate(0u);
+#endif
+    }
+}
+
+#if PROFILE_ENABLE
+// Queues a telemetry frame every PROFILE_REPORT_BLOCKS blocks. Telemetry
+// only goes out as frames; text mode just keeps the counts.
+static void report(void)
+{
+    uint32_t t0;
+
+    if(++report_blocks < PROFILE_REPORT_BLOCKS){
+        return;
+    }
+    report_blocks = 0;
+    t0 = profile_Start();
+    profile_Report(&telemetry, uart_tx_overflowCount, uart_tx_droppedBytes);
+    if(!text_mode()){
+        uart_tx_Write(telemetry.buf, telemetry.size);
+    }
+    profile_Stop(PROFILE_REPORT, t0);
+}
+#endif
+
+static uint32_t get32(const uint8_t *p)
+{
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Stores the calibration the host sent, if any, and answers with the one
+// in force. The hello that follows tells the host the new units.
+static void handle_cal(void)
+{
+    calstore_t c;
+    uint8_t status = CALSTORE_OK;
+
+    if(request.len >= 11u){
+        c.board_id = (uint16_t)(request.payload[0] | (request.payload[1] << 8));
+        c.gain = (int32_t)get32(&request.payload[2]);
+        c.offset = (int32_t)get32(&request.payload[6]);
+        c.flags = request.payload[10];
+        status = calstore_Save(&c);
+    }else if(calstore.seq == 0u){
+        status = CALSTORE_BLANK;
+    }
+    frame_Begin(&reply, FRAME_TYPE_CAL);
+    frame_Put(&reply, calstore.seq, 2u);
+    frame_Put(&reply, calstore.board_id, 2u);
+    frame_Put(&reply, (uint32_t)calstore.gain, 4u);
+    frame_Put(&reply, (uint32_t)calstore.offset, 4u);
+    frame_Put(&reply, calstore.flags, 1u);
+    frame_Put(&reply, status, 1u);
+    frame_Finish(&reply);
+    uart_tx_Write(reply.buf, reply.size);
+    make_hello(&hello);
+    uart_tx_Write(hello.buf, hello.size);
+}
+
+// Puts a setting just changed in command_Value into effect. Returns a
+// COMMAND_ status; the caller restores the old value unless it is OK.
+static uint8_t apply(uint8_t k)
+{
+    if(k == COMMAND_ADC_CONFIG){
+#if OUTPUT_BURST
+        if(burst.state == BURST_READY){
+            return COMMAND_BUSY;
+        }
+#endif
+        if(hal_AdcConfig((uint8_t)command_Value[k]) == 0u){
+            return COMMAND_UNSUPPORTED;
+        }
+#if OUTPUT_BURST
+        burst_Arm(&burst);
+#else
+        restart_tick = hal_Ticks();
+        restarted = 1u;
+#endif
+        return COMMAND_OK;
+    }
+#if OUTPUT_BURST
+    if(k == COMMAND_FORMAT || k == COMMAND_IDLE_RATE){
+        return COMMAND_UNSUPPORTED; // bursts always go out as frames, at one rate
+    }
+    return rearm_burst();
+#else
+    if(k == COMMAND_IDLE_RATE && HAL_CHANNELS > 1){
+        return COMMAND_UNSUPPORTED; // the inputs of the mux are not watched for activity
+    }
+    if(k == COMMAND_RATE || k == COMMAND_IDLE_RATE){
+        drop_partial();
+#if HAL_CHANNELS == 1
+        send_rate(now_micros());
+#endif
+        return COMMAND_OK;
+    }
+    if(k == COMMAND_FORMAT){
+#if HAL_CHANNELS > 1
+        if(command_Value[k] == COMMAND_FORMAT_PACKED){
+            return COMMAND_UNSUPPORTED; // packed frames carry a single input
+        }
+#endif
+        begin_frames(); // a frame half filled before a switch of format goes
+        return COMMAND_OK;
+    }
+    return COMMAND_UNSUPPORTED; // the trigger is for burst builds
+#endif
+}
+
+// Sets or reports one setting. The reply is a frame even in text mode; a
+// host switching to text gets it before the first line.
+static void handle_command(void)
+{
+    uint8_t k;
+    uint8_t status = COMMAND_OK;
+    int32_t old;
+
+    if(request.len < 1u){
+        return;
+    }
+    k = command_Find(request.payload[0]);
+    if(k == COMMAND_COUNT){
+        status = COMMAND_UNKNOWN;
+    }else if(request.len >= 5u){
+        old = command_Value[k];
+        command_Value[k] = (int32_t)get32(&request.payload[1]);
+        if(command_Value[k] < command_Info[k].min || command_Value[k] > command_Info[k].max){
+            status = COMMAND_RANGE;
+        }else{
+            status = apply(k);
+        }
+        if(status != COMMAND_OK){
+            command_Value[k] = old;
+        }
+    }
+    frame_Begin(&reply, FRAME_TYPE_COMMAND);
+    frame_Put(&reply, request.payload[0], 1u);
+    frame_Put(&reply, (uint32_t)(k < COMMAND_COUNT ? command_Value[k] : 0), 4u);
+    frame_Put(&reply, status, 1u);
+    frame_Finish(&reply);
+    uart_tx_Write(reply.buf, reply.size);
+    if(k == COMMAND_FORMAT && status == COMMAND_OK && !text_mode()){
+        make_hello(&hello);
+        uart_tx_Write(hello.buf, hello.size);
+#if !OUTPUT_BURST && HAL_CHANNELS == 1
+        put_rate(now_micros());
+#endif
+    }
+}
+
+// Tells the host that the count frames from first on are no longer kept.
+static void send_gone(uint16_t first, uint16_t count)
+{
+    frame_Begin(&reply, FRAME_TYPE_NACK);
+    frame_Put(&reply, first, 2u);
+    frame_Put(&reply, count, 2u);
+    frame_Finish(&reply);
+    uart_tx_Write(reply.buf, reply.size);
+}
+
+// Sends again the frames the host asks for that are still kept, while
+// leaving RESEND_RESERVE of the transmit ring to the live stream; the host
+// asks again for any that did not fit. Each run of them no longer kept is
+// named in a NACK of the board's own, so the host stops asking. A request
+// for more than FRAME_NACK_MAX_RUN is cut short, so a corrupt count cannot
+// hold up the acquisition loop for 65535 lookups.
+static void handle_nack(void)
+{
+    uint16_t seq;
+    uint16_t count;
+    uint16_t size = 0;
+    uint16_t gone = 0;
+    uint8_t *f;
+
+    if(request.len < FRAME_NACK_SIZE || text_mode()){
+        return;
+    }
+    seq = frame_Get16(request.payload);
+    count = frame_Get16(&request.payload[2]);
+    if(count > FRAME_NACK_MAX_RUN){
+        count = FRAME_NACK_MAX_RUN;
+    }
+    for(; count > 0u; count--, seq++){
+        f = history_Find(&history, seq, &size);
+        if(f == NULL){
+            gone++;
+            continue;
+        }
+        if(gone > 0u){
+            send_gone((uint16_t)(seq - gone), gone);
+            gone = 0;
+        }
+        if(uart_tx_Free() < (uint16_t)(size + RESEND_RESERVE)){
+            return;
+        }
+        frame_MarkResent(f);
+        uart_tx_Write(f, size);
+    }
+    if(gone > 0u){
+        send_gone((uint16_t)(seq - gone), gone);
+    }
+}
+
+// Answers the host. A sync request gets the board time its first byte
+// arrived; the reply waits in the transmit ring behind the samples already
+// queued, which the host allows for (see host/clock_sync.hpp).
+static void handle_request(void)
+{
+    if(request.type == FRAME_TYPE_CAL){
+        handle_cal();
+    }
+    if(request.type == FRAME_TYPE_COMMAND){
+        handle_command();
+    }
+    if(request.type == FRAME_TYPE_NACK){
+        handle_nack();
+    }
+    if(request.type == FRAME_TYPE_SYNC && request.len >= 4u){
+        frame_Begin(&reply, FRAME_TYPE_SYNC);
+        frame_Put(&reply, get32(request.payload), 4u);
+        frame_Put(&reply, (uint32_t)timebase_Micros(timebase_At(request.t_sync)), 4u);
+        frame_Finish(&reply);
+        uart_tx_Write(reply.buf, reply.size);
+    }
+}
+
+uint8_t acquire_Poll(void)
+{
+    const int16_t *block;
+    const uint32_t *times;
+    uint32_t t0;
+
+    t0 = profile_Start();
+    if(uart_tx_Service() != 0u){
+        profile_Stop(PROFILE_SERVICE, t0); // idle polls would swamp the histogram
+    }
+    if(rx_Poll(&request)){
+        handle_request();
+    }
+    block = hal_GetBlock();
+    if(block == NULL){
+        return 0u;
+    }
+    times = hal_GetTimes();
+    t0 = profile_Start();
+    profile_Add(PROFILE_LATENCY, t0 - times[HAL_BLOCK_SIZE - 1u]);
+
+#if OUTPUT_BURST
+    burst_block(block, times);
+    hal_ReleaseBlock();
+    if(burst.state == BURST_READY){
+        send_burst();
+    }
+#elif HAL_CHANNELS > 1
+    channel_block(block, times, hal_GetChannels());
+    hal_ReleaseBlock();
+#else
+    stream_block(block, times);
+    hal_ReleaseBlock();
+#endif
+    profile_Stop(PROFILE_BLOCK, t0);
+#if PROFILE_ENABLE
+    report();
+#endif
+    return 1u;
+}
+
+/* [] END OF FILE */
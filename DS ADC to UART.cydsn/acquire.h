@@ -0,0 +1,57 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// The acquisition loop: blocks of conversions in, frames (or text lines)
+// out over the UART. The board's main() is just acquire_Start and then
+// acquire_Poll forever; host/fwsim runs the same file against the simulated
+// backend of hal.h.
+#ifndef ACQUIRE_H
+#define ACQUIRE_H
+
+#include <stdint.h>
+
+// The format at reset; the host can switch it, and change the other
+// settings below, with command frames (command.h).
+#ifndef OUTPUT_BINARY
+#define OUTPUT_BINARY 1 // 0 sends the old "millis:reading" text lines instead of frames
+#endif
+#ifndef OUTPUT_PACKED
+#define OUTPUT_PACKED 0 // 1 with OUTPUT_BINARY sends packed frames, about a byte a sample (tspack.h)
+#endif
+#define HELLO_EVERY 256u // sample frames between repeated hellos, for hosts that connect late
+
+// While the stand is idle (activity.h), one sample is sent for every
+// OUTPUT_IDLE_RATE there would be, until load comes on; rate frames tell
+// the host where the spacing changes. 1 keeps the full rate throughout.
+#ifndef OUTPUT_IDLE_RATE
+#define OUTPUT_IDLE_RATE 32u
+#endif
+#define OUTPUT_IDLE_RATE_MAX 64u
+
+// 1 replaces the continuous filtered stream with triggered bursts: raw
+// conversions around a crossing of BURST_LEVEL are held in SRAM and sent
+// once captured, see burst.h
+#ifndef OUTPUT_BURST
+#define OUTPUT_BURST 0
+#endif
+#define BURST_LEVEL 4000 // adc counts
+#define BURST_STRIDE 8u // conversions per kept sample; 8 gives ~0.6 s of 110 ksps around the trigger
+#define BURST_PRE 2048u
+#define BURST_POST 6144u
+
+void acquire_Start(void);
+
+// One pass of the main loop: keeps the UART busy and handles the next block
+// of conversions if there is one. Returns 1 if it handled a block.
+uint8_t acquire_Poll(void);
+
+#endif /* ACQUIRE_H */
+/* [] END OF FILE */
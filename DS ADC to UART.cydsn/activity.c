@@ -0,0 +1,94 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "activity.h"
+
+void activity_Init(activity_t *a)
+{
+    a->n = 0u;
+    a->have_baseline = 0u;
+    a->active = 0u;
+    a->run = 0u;
+}
+
+static uint64_t square(int32_t d)
+{
+    return (uint64_t)((int64_t)d * d);
+}
+
+// Adds a quiet sample to the window, and makes the window the baseline
+// once it is full.
+static void learn(activity_t *a, int32_t x)
+{
+    int32_t d;
+    int32_t mean_d;
+
+    if(a->n == 0u){
+        a->ref = x;
+        a->sum = 0;
+        a->sum_sq = 0u;
+    }
+    d = x - a->ref;
+    a->sum += d;
+    a->sum_sq += square(d);
+    if(++a->n < ACTIVITY_WINDOW){
+        return;
+    }
+    mean_d = (int32_t)(a->sum / (int32_t)ACTIVITY_WINDOW);
+    a->mean = a->ref + mean_d;
+    a->var = a->sum_sq / ACTIVITY_WINDOW;
+    a->var = (a->var > square(mean_d)) ? a->var - square(mean_d) : 0u;
+    a->have_baseline = 1u;
+    a->n = 0u;
+}
+
+uint8_t activity_Push(activity_t *a, int32_t x)
+{
+    int32_t d = x - a->mean;
+    uint64_t d2 = square(d);
+    uint8_t quiet;
+
+    if(a->have_baseline == 0u){
+        learn(a, x);
+        return ACTIVITY_NONE;
+    }
+    quiet = (d2 <= (uint64_t)(ACTIVITY_END_SIGMAS * ACTIVITY_END_SIGMAS) * a->var) ||
+            (d2 < square(ACTIVITY_MIN_RISE / 2));
+    if(a->active == 0u){
+        if(d2 > (uint64_t)(ACTIVITY_START_SIGMAS * ACTIVITY_START_SIGMAS) * a->var &&
+           d2 >= square(ACTIVITY_MIN_RISE)){
+            if(++a->run >= ACTIVITY_START_HOLD){
+                a->active = 1u;
+                a->run = 0u;
+                a->n = 0u; // the window in progress may hold the start
+                return ACTIVITY_START;
+            }
+            return ACTIVITY_NONE;
+        }
+        a->run = 0u;
+        if(quiet){
+            learn(a, x);
+        }
+        return ACTIVITY_NONE;
+    }
+    if(quiet == 0u){
+        a->run = 0u;
+        return ACTIVITY_NONE;
+    }
+    if(++a->run >= ACTIVITY_END_HOLD){
+        a->active = 0u;
+        a->run = 0u;
+        return ACTIVITY_END;
+    }
+    return ACTIVITY_NONE;
+}
+
+/* [] END OF FILE */
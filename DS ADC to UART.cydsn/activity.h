@@ -0,0 +1,66 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Activity detection for the adaptive output rate: decides, sample by
+// sample, whether the stand is idle or under load, so acquire.c can send a
+// heavily averaged stream while nothing happens and the full rate while
+// something does.
+//
+// The detector learns the idle baseline, the mean and variance of windows
+// of ACTIVITY_WINDOW quiet samples, so it follows slow drift. It goes
+// active once ACTIVITY_START_HOLD samples in a row are more than
+// ACTIVITY_START_SIGMAS standard deviations, and at least ACTIVITY_MIN_RISE
+// counts, from the mean, either way. It goes idle again once
+// ACTIVITY_END_HOLD samples in a row are back within ACTIVITY_END_SIGMAS
+// standard deviations or half of ACTIVITY_MIN_RISE. The gap between the two
+// thresholds, and the long end hold, are the hysteresis that keeps a noisy
+// tail from flapping between rates. host/burn_detector.hpp does the same on
+// the host, in floating point.
+//
+// Only uses stdint types, so the host tools can build and exercise it.
+#ifndef ACTIVITY_H
+#define ACTIVITY_H
+
+#include <stdint.h>
+
+#define ACTIVITY_WINDOW             (256u)  // samples per baseline estimate
+#define ACTIVITY_START_SIGMAS       (8)
+#define ACTIVITY_END_SIGMAS         (4)
+#define ACTIVITY_MIN_RISE           (40)    // adc counts
+#define ACTIVITY_START_HOLD         (8u)
+#define ACTIVITY_END_HOLD           (2048u) // about a second at the full rate
+
+#define ACTIVITY_NONE               (0u)
+#define ACTIVITY_START              (1u)
+#define ACTIVITY_END                (2u)
+
+typedef struct {
+    int32_t  ref;           // first sample of the window; sums are taken from it
+    int64_t  sum;
+    uint64_t sum_sq;
+    uint16_t n;             // samples in the window so far
+    uint8_t  have_baseline;
+    uint8_t  active;
+    int32_t  mean;
+    uint64_t var;           // of the last window, counts squared
+    uint16_t run;           // samples in a row that point to a change
+} activity_t;
+
+// Forgets the baseline and starts idle; nothing goes active until a window
+// has been learned. A zeroed activity_t is in the same state.
+void activity_Init(activity_t *a);
+
+// Takes a sample in adc counts. Returns ACTIVITY_START or ACTIVITY_END on
+// the sample that changes the state, ACTIVITY_NONE otherwise.
+uint8_t activity_Push(activity_t *a, int32_t x);
+
+#endif /* ACTIVITY_H */
+/* [] END OF FILE */
@@ -0,0 +1,101 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "burst.h"
+
+void burst_Init(burst_t *b, uint16_t pre, uint16_t post, uint16_t stride,
+                int32_t level, int8_t direction)
+{
+    if(post < 2u){
+        post = 2u; // the trigger and one more, to measure the sample period
+    }
+    if(post > BURST_CAPACITY){
+        post = BURST_CAPACITY;
+    }
+    if(pre > BURST_CAPACITY - post){
+        pre = (uint16_t)(BURST_CAPACITY - post);
+    }
+    b->pre = pre;
+    b->post = post;
+    b->stride = (stride == 0u) ? 1u : stride;
+    b->level = level;
+    b->direction = (direction < 0) ? BURST_FALLING : BURST_RISING;
+    b->state = BURST_IDLE;
+}
+
+void burst_Arm(burst_t *b)
+{
+    b->head = 0u;
+    b->filled = 0u;
+    b->skip = 0u;
+    b->idle_side = 0u;
+    b->state = BURST_ARMED;
+}
+
+uint16_t burst_Push(burst_t *b, const int16_t x[], const uint32_t t[], uint16_t n)
+{
+    uint16_t i;
+    uint8_t past;
+
+    if(b->state != BURST_ARMED && b->state != BURST_TRIGGERED){
+        return n;
+    }
+    for(i = 0u; i < n; i++){
+        if(b->skip != 0u){
+            b->skip--;
+            continue;
+        }
+        b->skip = (uint16_t)(b->stride - 1u);
+
+        b->ring[b->head] = x[i];
+        b->head = (uint16_t)((b->head + 1u) & BURST_MASK);
+        if(b->filled < BURST_CAPACITY){
+            b->filled++;
+        }
+
+        if(b->state == BURST_TRIGGERED){
+            if(--b->remaining == 0u){
+                b->t_last = t[i];
+                b->state = BURST_READY;
+                return (uint16_t)(i + 1u);
+            }
+            continue;
+        }
+
+        past = (((int32_t)x[i] - b->level) * b->direction >= 0);
+        if(past && b->idle_side && b->filled > b->pre){
+            b->t_trigger = t[i];
+            b->remaining = (uint16_t)(b->post - 1u);
+            b->state = BURST_TRIGGERED;
+        }
+        b->idle_side = !past;
+    }
+    return n;
+}
+
+uint16_t burst_Count(const burst_t *b)
+{
+    return (b->state == BURST_READY) ? (uint16_t)(b->pre + b->post) : 0u;
+}
+
+int16_t burst_Get(const burst_t *b, uint16_t i)
+{
+    return b->ring[(uint16_t)(b->head - b->pre - b->post + i) & BURST_MASK];
+}
+
+int32_t burst_Offset(const burst_t *b, uint16_t i)
+{
+    // post - 1 sample periods between the trigger and the last sample
+    uint32_t span = b->t_last - b->t_trigger;
+    return (int32_t)(((int64_t)i - b->pre) * span / (int64_t)(b->post - 1u));
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,82 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Triggered burst capture: keeps the raw conversions around a threshold
+// crossing in an SRAM ring so they can be sent after the fact at whatever
+// rate the UART allows.
+//
+// While armed, every stride'th conversion goes into the ring. Once the ring
+// holds the pre-trigger window, a crossing of the level in the configured
+// direction triggers the capture; the crossing only counts if the previous
+// kept conversion was on the idle side, so a signal already past the level
+// when arming does not trigger straight away. After post more conversions
+// the window (pre + post samples, trigger sample first of the post part)
+// is ready, the ring stops filling, and burst_Get / burst_Offset read it
+// back until burst_Arm starts over.
+//
+// Conversion times are timebase counts and only the trigger and the last
+// sample's are kept; sample times in between are interpolated, which is
+// exact enough for a free-running ADC.
+//
+// Only uses stdint types, so the host tools can build and exercise it.
+#ifndef BURST_H
+#define BURST_H
+
+#include <stdint.h>
+
+#define BURST_CAPACITY              (8192u) // samples, power of two; 16 KB of SRAM
+#define BURST_MASK                  (BURST_CAPACITY - 1u)
+
+#define BURST_IDLE                  (0u)
+#define BURST_ARMED                 (1u)
+#define BURST_TRIGGERED             (2u)
+#define BURST_READY                 (3u)
+
+#define BURST_RISING                (1)
+#define BURST_FALLING               (-1)
+
+typedef struct {
+    int16_t  ring[BURST_CAPACITY];
+    uint16_t head;          // ring slot for the next sample
+    uint16_t filled;        // samples in the ring, up to BURST_CAPACITY
+    uint16_t pre;
+    uint16_t post;
+    uint16_t remaining;     // post-trigger samples still to take
+    uint16_t stride;        // keep one conversion in stride
+    uint16_t skip;          // conversions to drop before the next kept one
+    int32_t  level;
+    int8_t   direction;     // BURST_RISING or BURST_FALLING
+    uint8_t  state;
+    uint8_t  idle_side;     // last kept sample was short of the level
+    uint32_t t_trigger;     // timebase counts of the trigger sample
+    uint32_t t_last;        // and of the last sample of the window
+} burst_t;
+
+// pre + post must not exceed BURST_CAPACITY; stride of 0 counts as 1.
+// Leaves the capture idle, call burst_Arm to start.
+void burst_Init(burst_t *b, uint16_t pre, uint16_t post, uint16_t stride,
+                int32_t level, int8_t direction);
+void burst_Arm(burst_t *b);
+
+// Feeds n conversions and their timebase counts. Returns how many were
+// used: fewer than n only when the window completed part way through, in
+// which case the state is BURST_READY and the rest are for the caller.
+uint16_t burst_Push(burst_t *b, const int16_t x[], const uint32_t t[], uint16_t n);
+
+// The ready window, oldest sample first: i runs from 0 to pre + post - 1
+// and the trigger sample is i == pre.
+uint16_t burst_Count(const burst_t *b);
+int16_t burst_Get(const burst_t *b, uint16_t i);
+// Timebase counts from the trigger to sample i (negative before it).
+int32_t burst_Offset(const burst_t *b, uint16_t i);
+
+#endif /* BURST_H */
+/* [] END OF FILE */
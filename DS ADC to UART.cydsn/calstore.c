@@ -0,0 +1,119 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "calstore.h"
+#include "hal.h"
+#include "tsframe.h"
+
+#define RECORD_SIZE                 (14u) // without the crc
+#define MILLI_NEWTONS_MAX           (0x7FFFFF)
+
+#if HAL_EEPROM_ROW < RECORD_SIZE + 2u
+#error "a calibration record needs a 16 byte EEPROM row"
+#endif
+
+calstore_t calstore = {0u, 0u, 0u, 0x10000, 0};
+static uint8_t slot = 1u; // row of the record in force; the first save goes to row 0
+
+static int32_t get32(const uint8_t *p)
+{
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static void put32(uint8_t *p, int32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)((uint32_t)v >> 8);
+    p[2] = (uint8_t)((uint32_t)v >> 16);
+    p[3] = (uint8_t)((uint32_t)v >> 24);
+}
+
+// Returns 1 with the record in c if row holds a valid one.
+static uint8_t load(uint16_t row, calstore_t *c)
+{
+    const uint8_t *p = hal_EepromRow(row);
+
+    if(p[0] != CALSTORE_VERSION ||
+       frame_Crc16(0xFFFFu, p, RECORD_SIZE) != (uint16_t)(p[RECORD_SIZE] | (p[RECORD_SIZE + 1u] << 8))){
+        return 0u;
+    }
+    c->flags = p[1];
+    c->seq = (uint16_t)(p[2] | (p[3] << 8));
+    c->board_id = (uint16_t)(p[4] | (p[5] << 8));
+    c->gain = get32(&p[6]);
+    c->offset = get32(&p[10]);
+    return 1u;
+}
+
+uint8_t calstore_Start(void)
+{
+    calstore_t a, b;
+    uint8_t have_a = load(CALSTORE_ROW, &a);
+    uint8_t have_b = load(CALSTORE_ROW + 1u, &b);
+
+    if(have_a && (!have_b || (int16_t)(a.seq - b.seq) > 0)){
+        calstore = a;
+        slot = 0u;
+    }else if(have_b){
+        calstore = b;
+        slot = 1u;
+    }else{
+        return CALSTORE_BLANK;
+    }
+    return CALSTORE_OK;
+}
+
+uint8_t calstore_Save(const calstore_t *c)
+{
+    uint8_t row[HAL_EEPROM_ROW];
+    uint16_t crc;
+    calstore_t check;
+    uint8_t i;
+
+    for(i = 0; i < HAL_EEPROM_ROW; i++){
+        row[i] = 0;
+    }
+    row[0] = CALSTORE_VERSION;
+    row[1] = c->flags;
+    row[2] = (uint8_t)(calstore.seq + 1u);
+    row[3] = (uint8_t)((uint16_t)(calstore.seq + 1u) >> 8);
+    row[4] = (uint8_t)c->board_id;
+    row[5] = (uint8_t)(c->board_id >> 8);
+    put32(&row[6], c->gain);
+    put32(&row[10], c->offset);
+    crc = frame_Crc16(0xFFFFu, row, RECORD_SIZE);
+    row[RECORD_SIZE] = (uint8_t)crc;
+    row[RECORD_SIZE + 1u] = (uint8_t)(crc >> 8);
+
+    if(hal_EepromWrite((uint16_t)(CALSTORE_ROW + (slot ^ 1u)), row) == 0u ||
+       load((uint16_t)(CALSTORE_ROW + (slot ^ 1u)), &check) == 0u){
+        return CALSTORE_FAILED;
+    }
+    calstore = check;
+    slot ^= 1u;
+    return CALSTORE_OK;
+}
+
+int32_t calstore_Newtons(int32_t reading)
+{
+    // one 32x32->64 multiply (smull) and a shift; no floating point on the M3
+    int64_t mn = ((int64_t)(reading - calstore.offset) * calstore.gain + 0x8000) >> 16;
+
+    if(mn > MILLI_NEWTONS_MAX){
+        return MILLI_NEWTONS_MAX;
+    }
+    if(mn < -MILLI_NEWTONS_MAX){
+        return -MILLI_NEWTONS_MAX;
+    }
+    return (int32_t)mn;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,64 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// The board's calibration, kept in EEPROM: the load cell's gain and zero,
+// the board ID and a sequence number, so the board can send newtons
+// itself and a host can tell which calibration it used.
+//
+// A record is one 16 byte EEPROM row with its own CRC:
+//
+//   version (1) | flags (1) | seq (2) | board ID (2) | gain (4) | offset (4) | crc16 (2)
+//
+// Two rows take turns. calstore_Start uses the valid one with the later
+// sequence number and calstore_Save always writes the other, so a reset in
+// the middle of a write leaves the previous record in force.
+//
+// With CALSTORE_NEWTONS set, the load cell's readings go out as
+// (reading - offset) * gain, in signed 24 bit milli-newtons (+-8388 N),
+// and the hello frame says so (FRAME_HELLO_NEWTONS). Other inputs of a
+// multiplexed board stay in counts, and the text stream is always counts.
+#ifndef CALSTORE_H
+#define CALSTORE_H
+
+#include <stdint.h>
+
+#define CALSTORE_VERSION            (1u)
+#define CALSTORE_ROW                (0u) // first of the two EEPROM rows used
+#define CALSTORE_NEWTONS            (0x01u) // flags: send milli-newtons
+
+// calstore_Save and calstore_Start results, as sent in FRAME_TYPE_CAL
+#define CALSTORE_OK                 (0u)
+#define CALSTORE_FAILED             (1u) // the write did not read back
+#define CALSTORE_BLANK              (2u) // no record yet, defaults in use
+
+typedef struct {
+    uint8_t  flags;
+    uint16_t seq;
+    uint16_t board_id;
+    int32_t  gain;      // milli-newtons per count, 16.16 fixed point
+    int32_t  offset;    // counts at zero load
+} calstore_t;
+
+extern calstore_t calstore; // in force; 1 mN per count from 0 until one is saved
+
+// Loads the newest valid record. Returns CALSTORE_OK or CALSTORE_BLANK.
+uint8_t calstore_Start(void);
+
+// Saves c under the next sequence number and puts it in force. Blocks for
+// the EEPROM write, up to 20 ms on the PSoC, during which the loop does
+// not run. Returns CALSTORE_OK or CALSTORE_FAILED.
+uint8_t calstore_Save(const calstore_t *c);
+
+// A load cell reading in milli-newtons, clamped to 24 bits.
+int32_t calstore_Newtons(int32_t reading);
+
+#endif /* CALSTORE_H */
+/* [] END OF FILE */
@@ -0,0 +1,246 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "project.h"
+#include "capture.h"
+#include "timebase.h"
+
+#if defined(DMA_ADC__DRQ_NUMBER) && defined(DMA_TIME__DRQ_NUMBER)
+#define CAPTURE_DMA 1
+#else
+#define CAPTURE_DMA 0
+#endif
+
+#if CAPTURE_DMA
+// each pair aligned to its own size so it can never straddle the 0x20000000
+// boundary, a DMA channel only gets one upper address for all its transfers
+static int16 blocks[2][CAPTURE_BLOCK_SIZE] CY_ALIGN(2u * 2u * CAPTURE_BLOCK_SIZE);
+static uint32 times[2][CAPTURE_BLOCK_SIZE] CY_ALIGN(2u * 4u * CAPTURE_BLOCK_SIZE);
+#else
+static int16 blocks[2][CAPTURE_BLOCK_SIZE];
+static uint32 times[2][CAPTURE_BLOCK_SIZE];
+#endif
+static uint8 next = 0;  // block the main loop gets next
+static uint8 held = 0;  // main loop is still working on blocks[next]
+
+volatile uint32 capture_overrunCount = 0;
+
+#if CAPTURE_DMA
+
+#if defined(amux_CHANNELS)
+#error "amux needs the adc interrupt to step it; remove DMA_ADC and DMA_TIME"
+#endif
+
+#include "DMA_ADC_dma.h"
+#include "DMA_TIME_dma.h"
+
+static uint8 adc_channel;
+static uint8 time_channel;
+static uint8 adc_td[2];
+static uint8 time_td[2];
+static uint32 base;          // hal_Ticks() + the ticks count, which runs down
+static uint32 last_t;         // time of the last conversion handed out
+static uint8 have_last = 0u;
+static uint32 restart_tick;   // hal_Ticks() when the adc last started again
+static uint8 restarted = 0u;  // and no block handed out since began after it
+
+// Two TDs that move size bytes from the same register per request into
+// the two blocks at to0 and to1, each leading to the other.
+static void chain(uint8 channel, uint8 td[2], uint16 size, uint16 from, uint16 to0, uint16 to1)
+{
+    uint8 i;
+
+    td[0] = CyDmaTdAllocate();
+    td[1] = CyDmaTdAllocate();
+    for(i = 0; i < 2u; i++){
+        CyDmaTdSetConfiguration(td[i], CAPTURE_BLOCK_SIZE * size, td[i ^ 1u], TD_INC_DST_ADR);
+        CyDmaTdSetAddress(td[i], from, (i == 0u) ? to0 : to1);
+    }
+    CyDmaChSetInitialTd(channel, td[0]);
+    CyDmaChEnable(channel, 1u); // each TD starts over from its own address
+}
+
+void capture_Start(void)
+{
+    ticks_Start();
+    // ticks counts BUS_CLK down and hal_Ticks counts it up
+    base = hal_Ticks() + ticks_ReadCounter();
+    adc_channel = DMA_ADC_DmaInitialize(2u, 1u, HI16(CYDEV_PERIPH_BASE), HI16((uint32)blocks));
+    chain(adc_channel, adc_td, 2u, LO16((uint32)adc_DEC_SAMP_16B_PTR),
+          LO16((uint32)blocks[0]), LO16((uint32)blocks[1]));
+    time_channel = DMA_TIME_DmaInitialize(4u, 1u, HI16(CYDEV_PERIPH_BASE), HI16((uint32)times));
+    chain(time_channel, time_td, 4u, LO16((uint32)ticks_CAPTURE_LSB_PTR),
+          LO16((uint32)times[0]), LO16((uint32)times[1]));
+    adc_IRQ_Disable();
+}
+
+void capture_Restarted(void)
+{
+    restart_tick = hal_Ticks();
+    restarted = 1u;
+}
+
+const int16 *capture_GetBlock(void)
+{
+    uint8 adc_current;
+    uint8 time_current;
+    uint32 period;
+    uint32 gap;
+    uint16 i;
+
+    // a block is full once both channels have moved on to the other one
+    (void)CyDmaChStatus(adc_channel, &adc_current, NULL);
+    (void)CyDmaChStatus(time_channel, &time_current, NULL);
+    if(held != 0u || adc_current == adc_td[next] || time_current == time_td[next]){
+        return NULL;
+    }
+    for(i = 0; i < CAPTURE_BLOCK_SIZE; i++){
+        times[next][i] = base - times[next][i];
+    }
+    // A main loop more than a block behind finds the DMA went on without
+    // it: the block holds conversions from a lap later than the last, and
+    // the ones between are lost. The pause of an adc restart between the
+    // two is not a loss.
+    gap = times[next][0] - last_t;
+    if(restarted != 0u && (int32)(times[next][0] - restart_tick) >= 0){
+        restarted = 0u;
+        if((int32)(last_t - restart_tick) < 0){
+            gap = 0u;
+        }
+    }
+    if(have_last != 0u){
+        period = (times[next][CAPTURE_BLOCK_SIZE - 1u] - times[next][0]) / (CAPTURE_BLOCK_SIZE - 1u);
+        if(period != 0u && gap > period + period / 2u){
+            capture_overrunCount += (gap + period / 2u) / period - 1u;
+        }
+    }
+    last_t = times[next][CAPTURE_BLOCK_SIZE - 1u];
+    have_last = 1u;
+    held = 1u;
+    return blocks[next];
+}
+
+void adc_ISR1_EntryCallback(void)
+{
+}
+
+const uint8 *capture_GetChannels(void)
+{
+    return NULL;
+}
+
+#else
+
+static uint8 fill = 0;     // block the interrupt is writing
+static uint16 pos = 0;
+static volatile uint8 full[2] = {0, 0};
+
+#if defined(amux_CHANNELS)
+
+static uint8 tags[2][CAPTURE_BLOCK_SIZE];
+static uint8 input = 0;  // mux setting
+static uint16 dwell = 0; // conversions since it was made
+
+// Tag for the conversion just read. Moves the mux on once the input has
+// had its settling and dwell conversions; the conversion already under way
+// at that moment is the first of the next input's settling ones.
+static uint8 sequence(void)
+{
+    uint8 tag = (dwell < HAL_SETTLE) ? HAL_SETTLING : input;
+
+    if(++dwell == HAL_SETTLE + HAL_DWELL){
+        dwell = 0;
+        if(++input == amux_CHANNELS){
+            input = 0;
+        }
+        amux_FastSelect(input);
+    }
+    return tag;
+}
+
+void capture_Start(void)
+{
+    amux_Start();
+    amux_FastSelect(0u);
+}
+
+const uint8 *capture_GetChannels(void)
+{
+    return tags[next];
+}
+
+#else
+
+void capture_Start(void)
+{
+}
+
+const uint8 *capture_GetChannels(void)
+{
+    return NULL;
+}
+
+#endif /* amux_CHANNELS */
+
+void adc_ISR1_EntryCallback(void)
+{
+#if defined(amux_CHANNELS)
+    uint8 tag = sequence(); // the mux keeps stepping through overruns
+#endif
+
+    if(full[fill] != 0u){
+        // main loop has not handed this block back yet
+        (void)adc_GetResult16();
+        capture_overrunCount++;
+        return;
+    }
+#if defined(amux_CHANNELS)
+    tags[fill][pos] = tag;
+#endif
+    times[fill][pos] = hal_Ticks();
+    blocks[fill][pos++] = adc_GetResult16();
+    if(pos == CAPTURE_BLOCK_SIZE){
+        full[fill] = 1u;
+        fill ^= 1u;
+        pos = 0;
+    }
+}
+
+void capture_Restarted(void)
+{
+}
+
+const int16 *capture_GetBlock(void)
+{
+    if(held == 0u && full[next] != 0u){
+        held = 1u;
+        return blocks[next];
+    }
+    return NULL;
+}
+
+#endif /* CAPTURE_DMA */
+
+const uint32 *capture_GetTimes(void)
+{
+    return times[next];
+}
+
+void capture_ReleaseBlock(void)
+{
+#if !CAPTURE_DMA
+    full[next] = 0u;
+#endif
+    held = 0u;
+    next ^= 1u;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,66 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Ping-pong capture of decimator results into two SRAM blocks.
+//
+// With the DMA parts below in the schematic, two DMA channels fill the
+// blocks and the CPU never touches a single conversion, which frees it to
+// run the adc at its full rate. Without them, the adc end of conversion
+// interrupt fills them instead (adc_ISR1_EntryCallback, hooked in through
+// cyapicallbacks.h), one interrupt per conversion. Either way every
+// conversion's time is latched as it happens and the main loop only sees
+// whole blocks:
+//
+//     const int16 *block = capture_GetBlock();
+//     if(block != 0){
+//         const uint32 *times = capture_GetTimes();
+//         ...use CAPTURE_BLOCK_SIZE samples and their timebase counts...
+//         capture_ReleaseBlock();
+//     }
+//
+// The DMA path needs, all driven by the adc's eoc terminal:
+//  - ticks: a 32 bit UDB Timer clocked from BUS_CLK, free running, with
+//    eoc on its capture input and its interrupt output set to capture only
+//  - DMA_ADC: a DMA component whose drq is eoc; it moves each result
+//  - DMA_TIME: a DMA component whose drq is ticks' interrupt; it moves each
+//    captured count
+// Each channel runs two chained TDs, one per block, that lead to each other
+// so neither ever stops. The DMA cannot tell that the main loop has fallen
+// a block behind, so overruns are found afterwards from a jump in the
+// latched times.
+//
+// If the schematic has an analog mux named amux between the input pins and
+// the adc, the interrupt steps it through its inputs as described in hal.h
+// and tags every conversion with the input it came from. The DMA cannot do
+// that, so the mux needs the interrupt path.
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "cytypes.h"
+
+#define CAPTURE_BLOCK_SIZE          (256u) // samples per block, ~2.3ms at 110 ksps
+
+extern volatile uint32 capture_overrunCount; // conversions lost because both blocks were full
+
+void capture_Start(void);
+// The adc stopped and started again (hal_AdcConfig); the gap in the times
+// that follows is not an overrun.
+void capture_Restarted(void);
+const int16 *capture_GetBlock(void);
+// Raw timebase counts for the block returned by capture_GetBlock, latched
+// per conversion.
+const uint32 *capture_GetTimes(void);
+void capture_ReleaseBlock(void);
+// Input tags for the block, or NULL without a mux.
+const uint8 *capture_GetChannels(void);
+
+#endif /* CAPTURE_H */
+/* [] END OF FILE */
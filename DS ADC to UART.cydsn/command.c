@@ -0,0 +1,43 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "command.h"
+
+#define COMMAND_INFO(name, id, min, max, initial, help) {id, min, max, initial},
+const command_info_t command_Info[COMMAND_COUNT] = {
+    COMMAND_LIST(COMMAND_INFO)
+};
+#undef COMMAND_INFO
+
+int32_t command_Value[COMMAND_COUNT];
+
+void command_Start(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < COMMAND_COUNT; i++){
+        command_Value[i] = command_Info[i].initial;
+    }
+}
+
+uint8_t command_Find(uint8_t id)
+{
+    uint8_t i;
+
+    for(i = 0; i < COMMAND_COUNT; i++){
+        if(command_Info[i].id == id){
+            break;
+        }
+    }
+    return i;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,77 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Settings the host can change while the board runs, instead of editing
+// acquire.h and reflashing. COMMAND_LIST is the one definition of them:
+// the firmware builds its table from it and the host tools (host/command.hpp)
+// build theirs, so the IDs, limits and names cannot drift apart.
+//
+// A FRAME_TYPE_COMMAND frame to the board holds a setting's ID (1) and a
+// value (4, signed) to set it to, or just the ID to ask for it. The board
+// answers with the ID (1), the value in force (4) and a status (1). A
+// change takes effect from the next block of conversions; samples already
+// summed towards the next one sent under the old setting are dropped.
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdint.h>
+#include "acquire.h"
+
+#define COMMAND_FORMAT_FRAMES       (0)
+#define COMMAND_FORMAT_TEXT         (1) // "millis:reading" lines, as OUTPUT_BINARY 0
+#define COMMAND_FORMAT_PACKED       (2) // packed frames, as OUTPUT_PACKED 1
+
+// X(name, id, min, max, initial, help)
+#define COMMAND_LIST(X) \
+    X(RATE, 0x01u, 1, 64, (OUTPUT_BURST ? (int32_t)BURST_STRIDE : 1), \
+      "filtered samples averaged into each one sent; in a burst build, conversions per kept sample") \
+    X(ADC_CONFIG, 0x02u, 1, 4, 1, \
+      "adc configuration from the schematic, as adc_SelectConfiguration takes it") \
+    X(FORMAT, 0x03u, 0, 2, \
+      (OUTPUT_BINARY ? (OUTPUT_PACKED ? COMMAND_FORMAT_PACKED : COMMAND_FORMAT_FRAMES) : COMMAND_FORMAT_TEXT), \
+      "0 for frames, 1 for millis:reading text lines, 2 for packed frames (single input stream only)") \
+    X(TRIGGER_LEVEL, 0x04u, -32768, 32767, BURST_LEVEL, \
+      "burst trigger level in adc counts") \
+    X(TRIGGER_EDGE, 0x05u, 0, 1, 0, \
+      "burst trigger on a rising (0) or falling (1) crossing") \
+    X(IDLE_RATE, 0x06u, 1, (int32_t)OUTPUT_IDLE_RATE_MAX, (int32_t)OUTPUT_IDLE_RATE, \
+      "samples averaged into each one sent while the stand is idle; 1 keeps the full rate")
+
+// COMMAND_RATE and so on, indices into command_Info and command_Value
+#define COMMAND_INDEX(name, id, min, max, initial, help) COMMAND_##name,
+enum { COMMAND_LIST(COMMAND_INDEX) COMMAND_COUNT };
+#undef COMMAND_INDEX
+
+// statuses of a reply
+#define COMMAND_OK                  (0u)
+#define COMMAND_UNKNOWN             (1u) // no setting with that ID
+#define COMMAND_RANGE               (2u) // value outside min to max
+#define COMMAND_UNSUPPORTED         (3u) // not in this build or on this hardware
+#define COMMAND_BUSY                (4u) // not now; ask again
+
+typedef struct {
+    uint8_t id;
+    int32_t min;
+    int32_t max;
+    int32_t initial;
+} command_info_t;
+
+extern const command_info_t command_Info[COMMAND_COUNT];
+extern int32_t command_Value[COMMAND_COUNT]; // in force
+
+// Puts every setting at its initial value.
+void command_Start(void);
+
+// Index of the setting with ID id, or COMMAND_COUNT if there is none.
+uint8_t command_Find(uint8_t id);
+
+#endif /* COMMAND_H */
+/* [] END OF FILE */
@@ -15,5 +15,9 @@
     /*Define your macro callbacks here */
     /*For more information, refer to the Macro Callbacks topic in the PSoC Creator Help.*/
     
+    /* capture.c: store each conversion into the ping-pong blocks */
+    #define adc_ISR1_ENTRY_CALLBACK
+    void adc_ISR1_EntryCallback(void);
+    
 #endif /* CYAPICALLBACKS_H */   
 /* [] */
@@ -0,0 +1,81 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <string.h>
+#include "decimate.h"
+
+#define FIR_SHIFT   (15u + 4u) // Q15 taps on Q4 input
+
+static const int32_t fir[DECIMATE_FIR_TAPS] = DECIMATE_FIR_COEFFS;
+
+void decimate_Init(decimate_t *d)
+{
+    memset(d, 0, sizeof(*d));
+}
+
+static int32_t cic_output(decimate_t *d)
+{
+    uint32_t v = d->integ[DECIMATE_CIC_ORDER - 1u];
+    uint32_t prev;
+    uint8_t i;
+
+    for(i = 0; i < DECIMATE_CIC_ORDER; i++){
+        prev = d->comb[i];
+        d->comb[i] = v;
+        v -= prev;
+    }
+    // the true output fits in 32 bits, so the wrapped value is exact
+    return (int32_t)(((int64_t)(int32_t)v * DECIMATE_CIC_RECIP) >> DECIMATE_CIC_SHIFT);
+}
+
+static int32_t fir_output(const decimate_t *d)
+{
+    int64_t acc = 0;
+    uint8_t pos = d->hist_pos; // oldest sample
+    uint8_t i;
+
+    for(i = 0; i < DECIMATE_FIR_TAPS; i++){
+        acc += (int64_t)fir[i] * d->hist[pos];
+        if(++pos == DECIMATE_FIR_TAPS){
+            pos = 0;
+        }
+    }
+    return (int32_t)((acc + (1 << (FIR_SHIFT - 1u))) >> FIR_SHIFT);
+}
+
+uint8_t decimate_Push(decimate_t *d, int32_t x, int32_t *out)
+{
+    uint32_t v = (uint32_t)x;
+    uint8_t i;
+
+    for(i = 0; i < DECIMATE_CIC_ORDER; i++){
+        d->integ[i] += v;
+        v = d->integ[i];
+    }
+    if(++d->cic_phase < DECIMATE_CIC_RATIO){
+        return 0u;
+    }
+    d->cic_phase = 0;
+
+    d->hist[d->hist_pos] = cic_output(d);
+    if(++d->hist_pos == DECIMATE_FIR_TAPS){
+        d->hist_pos = 0;
+    }
+    if(++d->fir_phase < DECIMATE_FIR_RATIO){
+        return 0u;
+    }
+    d->fir_phase = 0;
+
+    *out = fir_output(d);
+    return 1u;
+}
+
+/* [] END OF FILE */
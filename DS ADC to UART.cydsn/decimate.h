@@ -0,0 +1,39 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Fixed point decimation filter: CIC integrator/comb followed by a droop
+// compensating FIR (see decimate_taps.h for the configuration).
+//
+// Only uses stdint types and plain integer arithmetic so the host tools can
+// compile this same file and check the firmware's output bit for bit.
+#ifndef DECIMATE_H
+#define DECIMATE_H
+
+#include <stdint.h>
+#include "decimate_taps.h"
+
+typedef struct {
+    uint32_t integ[DECIMATE_CIC_ORDER]; // wrap around on purpose
+    uint32_t comb[DECIMATE_CIC_ORDER];
+    uint16_t cic_phase;
+    int32_t  hist[DECIMATE_FIR_TAPS];   // CIC outputs, Q4 counts
+    uint8_t  hist_pos;
+    uint8_t  fir_phase;
+} decimate_t;
+
+void decimate_Init(decimate_t *d);
+
+// Feeds one ADC result. Returns 1 and writes *out once every
+// DECIMATE_RATIO inputs, 0 otherwise.
+uint8_t decimate_Push(decimate_t *d, int32_t x, int32_t *out);
+
+#endif /* DECIMATE_H */
+/* [] END OF FILE */
@@ -0,0 +1,52 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Decimation chain configuration, 110 ksps in, ~2.4 ksps out (same output
+// rate as the old 46 sample average).
+//
+// CIC: order 3, decimate by 23 -> 4783 Hz
+// FIR: 33 taps, decimate by 2 -> 2391 Hz. Hamming windowed design of
+//      1/|CIC(f)| up to 0.4 * 2391 Hz, so the passband is flat to within
+//      0.02 dB up to 700 Hz and -3.3 dB at 900 Hz. From the output Nyquist
+//      frequency (1195 Hz) up the chain is below -45 dB except for 3775 to
+//      4060 Hz, peaking at -41.3 dB at 3900 Hz (tsfilter --response). That is
+//      the FIR's image around 4783 Hz, held down only by the CIC's first
+//      sidelobe, and it folds onto 720 to 1010 Hz. Coefficients are Q15 and
+//      sum to exactly 32768 so DC gain is 1.
+//
+// Changing R or N means recomputing the FIR and DECIMATE_CIC_RECIP.
+#ifndef DECIMATE_TAPS_H
+#define DECIMATE_TAPS_H
+
+#define DECIMATE_CIC_ORDER          (3u)
+#define DECIMATE_CIC_RATIO          (23u)
+// 2^DECIMATE_CIC_SHIFT / 23^3, scales the CIC output to Q4 ADC counts
+#define DECIMATE_CIC_SHIFT          (32u)
+#define DECIMATE_CIC_RECIP          (5648021)
+
+#define DECIMATE_FIR_TAPS           (33u)
+#define DECIMATE_FIR_RATIO          (2u)
+
+#define DECIMATE_RATIO              (DECIMATE_CIC_RATIO * DECIMATE_FIR_RATIO)
+// delay from input to output, in input samples
+#define DECIMATE_DELAY              (DECIMATE_CIC_ORDER * (DECIMATE_CIC_RATIO - 1u) / 2u + \
+                                     (DECIMATE_FIR_TAPS - 1u) / 2u * DECIMATE_CIC_RATIO)
+
+#define DECIMATE_FIR_COEFFS { \
+       61,      2,    -98,    -93,    128,    314,     15,   -594, \
+     -528,    625,   1451,    125,  -2490,  -2517,   2681,  10313, \
+    13978, \
+    10313,   2681,  -2517,  -2490,    125,   1451,    625,   -528, \
+     -594,     15,    314,    128,    -93,    -98,      2,     61  \
+}
+
+#endif /* DECIMATE_TAPS_H */
+/* [] END OF FILE */
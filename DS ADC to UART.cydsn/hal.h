@@ -0,0 +1,115 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Hardware abstraction for the acquisition loop (acquire.c).
+//
+// Everything acquire.c, uart_tx.c and timebase.c need from the board goes
+// through here, so those files build unchanged for two backends:
+//
+//   hal_psoc.c          the generated PSoC components; the calls made for
+//                       every byte or sample are macros below, so they cost
+//                       nothing over calling the component APIs directly
+//   host/hal_sim.cpp    a Linux stand-in (build with -DHAL_SIM) that feeds
+//                       a recorded or synthetic ADC stream on a simulated
+//                       clock and models the UART's byte timing; see fwsim
+//
+// A board can sample several inputs through one adc. HAL_CHANNELS inputs
+// are visited round-robin: the mux moves on, the next HAL_SETTLE
+// conversions still mix in the old input (the decimator's sinc filter
+// spans several conversions) and are tagged HAL_SETTLING, then HAL_DWELL
+// conversions of the new input follow. Dwelling that long on each input
+// keeps the settling cost to a few percent of the conversions instead of
+// losing most of them to switching on every sample.
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+#define HAL_BLOCK_SIZE              (256u) // conversions per hal_GetBlock
+#define HAL_SETTLE                  (4u)
+#define HAL_DWELL                   (46u)
+#define HAL_SETTLING                (0xFFu)
+
+#if defined(HAL_SIM)
+
+#ifndef HAL_CHANNELS
+#define HAL_CHANNELS                (1u) // fwsim builds with -DHAL_CHANNELS=3 for the mux
+#endif
+
+#define HAL_TICK_HZ                 (24000000u)
+#define HAL_ADC_HZ                  (110000u)
+#define HAL_EEPROM_ROW              (16u)
+#define HAL_ADC_CONFIGS             (2u) // the second drops the low 4 bits, like a 12 bit configuration
+
+const uint8_t *hal_EepromRow(uint16_t row);
+
+uint32_t hal_Ticks(void);
+uint8_t hal_UartReady(void);
+void hal_UartPut(uint8_t b);
+uint8_t hal_UartRxReady(void);
+uint8_t hal_UartGet(void);
+
+#else
+
+#include "project.h"
+
+#define HAL_TICK_HZ                 (BCLK__BUS_CLK__HZ)
+#define HAL_ADC_HZ                  (adc_CFG1_SRATE)
+#define HAL_EEPROM_ROW              (CYDEV_EEPROM_ROW_SIZE)
+#define HAL_ADC_CONFIGS             (adc_DEFAULT_NUM_CONFIGS)
+
+// an analog mux named amux in front of the adc, see capture.h
+#if defined(amux_CHANNELS)
+#define HAL_CHANNELS                (amux_CHANNELS)
+#else
+#define HAL_CHANNELS                (1u)
+#endif
+
+// DWT cycle counter: cheap enough to latch in every adc interrupt
+#define hal_Ticks()                 (DWT->CYCCNT)
+#define hal_UartReady()             ((UART_ReadTxStatus() & UART_TX_STS_FIFO_FULL) == 0u)
+#define hal_UartPut(b)              UART_WriteTxData(b)
+#define hal_UartRxReady()           ((UART_ReadRxStatus() & UART_RX_STS_FIFO_NOTEMPTY) != 0u)
+#define hal_UartGet()               UART_ReadRxData()
+// the EEPROM reads like memory
+#define hal_EepromRow(row)          ((const uint8_t *)(uintptr_t)(CYDEV_EE_BASE + (uint32_t)(row) * CYDEV_EEPROM_ROW_SIZE))
+
+#endif /* HAL_SIM */
+
+// Starts the timebase, UART and ADC; conversions start arriving in blocks.
+void hal_Start(void);
+
+// Blocks of HAL_BLOCK_SIZE conversions and the hal_Ticks count latched for
+// each. hal_GetBlock returns NULL until a block is full; the caller hands
+// each block back with hal_ReleaseBlock before asking for the next.
+const int16_t *hal_GetBlock(void);
+const uint32_t *hal_GetTimes(void);
+void hal_ReleaseBlock(void);
+// Input of each conversion in the block, or HAL_SETTLING; NULL when
+// HAL_CHANNELS is 1.
+const uint8_t *hal_GetChannels(void);
+
+// Conversions lost so far because both blocks were still held.
+uint32_t hal_Overruns(void);
+
+// Erases and programs one HAL_EEPROM_ROW byte row of EEPROM, which
+// hal_EepromRow then reads back. Blocks until it is done, up to 20 ms on
+// the PSoC. Returns 1 on success.
+uint8_t hal_EepromWrite(uint16_t row, const uint8_t *data);
+
+// Restarts the adc in configuration 1 to HAL_ADC_CONFIGS. Conversion times
+// and the filter delay assume HAL_ADC_HZ, so configurations should differ
+// in resolution or range, not rate. Returns 0 for a configuration the
+// schematic does not have.
+uint8_t hal_AdcConfig(uint8_t config);
+
+#endif /* HAL_H */
+/* [] END OF FILE */
@@ -0,0 +1,80 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// PSoC backend of hal.h, on top of the generated components and capture.c.
+#include "hal.h"
+#include "capture.h"
+
+#if CAPTURE_BLOCK_SIZE != HAL_BLOCK_SIZE
+#error "capture.h and hal.h disagree on the block size"
+#endif
+
+void hal_Start(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0u;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    CyEEPROM_Start();
+    UART_Start();
+    adc_Start();
+    capture_Start();
+    adc_StartConvert();
+}
+
+const int16_t *hal_GetBlock(void)
+{
+    return capture_GetBlock();
+}
+
+const uint32_t *hal_GetTimes(void)
+{
+    // cytypes' uint32 is unsigned long, the same 32 bits as uint32_t here
+    return (const uint32_t *)capture_GetTimes();
+}
+
+const uint8_t *hal_GetChannels(void)
+{
+    return capture_GetChannels();
+}
+
+void hal_ReleaseBlock(void)
+{
+    capture_ReleaseBlock();
+}
+
+uint32_t hal_Overruns(void)
+{
+    return capture_overrunCount;
+}
+
+uint8_t hal_EepromWrite(uint16_t row, const uint8_t *data)
+{
+    // the SPC needs the die temperature to time the write
+    if(CySetTemp() != CYRET_SUCCESS){
+        return 0u;
+    }
+    return CyWriteRowData(CY_SPC_FIRST_EE_ARRAYID, row, data) == CYRET_SUCCESS;
+}
+
+uint8_t hal_AdcConfig(uint8_t config)
+{
+    if(config == 0u || config > HAL_ADC_CONFIGS){
+        return 0u;
+    }
+    // stops the modulator, loads the configuration and its gain trim and
+    // starts converting again; the capture interrupt or DMA carries on
+    adc_SelectConfiguration(config, 1u);
+    capture_Restarted();
+    return 1u;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,47 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include <stddef.h>
+#include "history.h"
+#include "tsframe.h"
+
+void history_Put(history_t *h, const uint8_t *frame, uint16_t size)
+{
+    uint16_t at = (uint16_t)(h->head & (HISTORY_SIZE - 1u));
+    uint16_t i;
+
+    if((uint32_t)at + size > HISTORY_SIZE){
+        h->head += HISTORY_SIZE - at;
+        at = 0u;
+    }
+    for(i=0; i<size; i++){
+        h->ring[at + i] = frame[i];
+    }
+    h->start[frame_Seq(frame) & (HISTORY_FRAMES - 1u)] = h->head;
+    h->head += size;
+}
+
+uint8_t *history_Find(history_t *h, uint16_t seq, uint16_t *size)
+{
+    uint32_t start = h->start[seq & (HISTORY_FRAMES - 1u)];
+    uint8_t *f = &h->ring[start & (HISTORY_SIZE - 1u)];
+
+    // the bytes from start on are intact until the head is a ring past it,
+    // and the slot may hold an older frame than the one asked for
+    if(h->head - start > HISTORY_SIZE || f[0] != FRAME_SYNC0 || f[1] != FRAME_SYNC1 ||
+       frame_Seq(f) != seq){
+        return NULL;
+    }
+    *size = (uint16_t)(FRAME_HEADER_SIZE + frame_Len(f) + FRAME_CRC_SIZE);
+    return f;
+}
+
+/* [] END OF FILE */
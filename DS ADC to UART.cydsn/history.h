@@ -0,0 +1,47 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// The frames sent lately, kept so that the host can ask for the ones it
+// missed (FRAME_TYPE_NACK in tsframe.h) while the stream goes on.
+//
+// Frames are copied whole, as sent, into a byte ring and found again by
+// sequence number through an index of where each one starts. A frame that
+// would run past the end of the ring starts over at the front, so each one
+// is contiguous and goes out again with a single uart_tx_Write. A frame is
+// gone once HISTORY_SIZE bytes have been kept after it or its index slot
+// has been reused; with 52 byte sample frames at the full rate that is
+// about a second, with packed frames several.
+//
+// A zeroed history_t, as a static is, holds nothing. Only uses stdint
+// types and tsframe.h, so the host tools can build it.
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+
+#define HISTORY_SIZE                (16384u) // bytes, power of two
+#define HISTORY_FRAMES              (512u)   // index slots, power of two
+
+typedef struct {
+    uint8_t  ring[HISTORY_SIZE];
+    uint32_t start[HISTORY_FRAMES]; // where the frame with seq % HISTORY_FRAMES begins
+    uint32_t head;                  // bytes kept so far, counting the ends skipped
+} history_t;
+
+// Keeps a copy of a finished frame of size bytes.
+void history_Put(history_t *h, const uint8_t *frame, uint16_t size);
+
+// The kept frame with sequence number seq and its size, or NULL if it is
+// gone or was never kept.
+uint8_t *history_Find(history_t *h, uint16_t seq, uint16_t *size);
+
+#endif /* HISTORY_H */
+/* [] END OF FILE */
@@ -0,0 +1,80 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "profile.h"
+
+#if PROFILE_ENABLE
+
+static profile_stage_t stages[PROFILE_STAGES];
+
+void profile_Add(uint8_t stage, uint32_t cycles)
+{
+    profile_stage_t *s = &stages[stage];
+    uint32_t scaled = cycles >> PROFILE_SHIFT;
+    uint8_t bucket = 0u;
+
+    if(scaled != 0u){
+        // CLZ is one instruction on the Cortex-M3
+        bucket = (uint8_t)(32 - __builtin_clz(scaled));
+        if(bucket >= PROFILE_BUCKETS){
+            bucket = PROFILE_BUCKETS - 1u;
+        }
+    }
+    if(s->hist[bucket] != 0xFFFFu){
+        s->hist[bucket]++;
+    }
+    s->count++;
+    s->total += cycles;
+    if(cycles > s->longest){
+        s->longest = cycles;
+    }
+}
+
+void profile_Stop(uint8_t stage, uint32_t start)
+{
+    profile_Add(stage, hal_Ticks() - start);
+}
+
+const profile_stage_t *profile_Stage(uint8_t stage)
+{
+    return &stages[stage];
+}
+
+void profile_Report(frame_t *f, uint32_t tx_rejected, uint32_t tx_dropped)
+{
+    profile_stage_t *s;
+    uint8_t i, k;
+
+    frame_Begin(f, FRAME_TYPE_TELEMETRY);
+    frame_Put(f, hal_Overruns(), 4u);
+    frame_Put(f, tx_rejected, 4u);
+    frame_Put(f, tx_dropped, 4u);
+    frame_Put(f, PROFILE_STAGES, 1u);
+    frame_Put(f, PROFILE_BUCKETS, 1u);
+    for(i=0; i<PROFILE_STAGES; i++){
+        s = &stages[i];
+        frame_Put(f, s->count, 4u);
+        frame_Put(f, s->count ? (uint32_t)(s->total / s->count) : 0u, 4u);
+        frame_Put(f, s->longest, 4u);
+        for(k=0; k<PROFILE_BUCKETS; k++){
+            frame_Put(f, s->hist[k], 2u);
+            s->hist[k] = 0u;
+        }
+        s->count = 0u;
+        s->total = 0u;
+        s->longest = 0u;
+    }
+    frame_Finish(f);
+}
+
+#endif /* PROFILE_ENABLE */
+
+/* [] END OF FILE */
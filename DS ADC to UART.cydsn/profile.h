@@ -0,0 +1,80 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Where the acquisition loop spends its cycles.
+//
+// Each stage of acquire.c is bracketed with profile_Start / profile_Stop,
+// which read hal_Ticks (the DWT cycle counter on the board, the simulated
+// clock under fwsim) and add the elapsed count to that stage's histogram.
+// Bucket k counts intervals of [16 << (k - 1), 16 << k) cycles, bucket 0
+// those under 16, and the last bucket everything longer.
+//
+// profile_Report sends the histograms since the previous report as one
+// telemetry frame, together with the running loss counters, and starts new
+// ones. Payload (little-endian):
+//
+//   conversions lost (4), frames rejected by the transmit ring (4), bytes in
+//   them (4), stages (1), buckets (1), then per stage: intervals (4), mean
+//   cycles (4), longest (4), one count per bucket (2, saturating)
+//
+// Building with PROFILE_ENABLE 0 turns the calls into nothing.
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "tsframe.h"
+
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE 1
+#endif
+#define PROFILE_REPORT_BLOCKS 430u // blocks between telemetry frames, ~1 s at 110 ksps
+
+#define PROFILE_BUCKETS             (16u)
+#define PROFILE_SHIFT               (4u) // cycles in bucket 0 are below 1 << PROFILE_SHIFT
+
+enum {
+    PROFILE_SERVICE,    // uart_tx_Service: moving queued bytes into the FIFO
+    PROFILE_BLOCK,      // one block of conversions: filter, or trigger and ring
+    PROFILE_SEND,       // finishing and queueing frames, inside PROFILE_BLOCK
+    PROFILE_LATENCY,    // from the block's last conversion until the loop takes it
+    PROFILE_REPORT,     // building and queueing the previous telemetry frame
+    PROFILE_STAGES
+};
+
+typedef struct {
+    uint32_t count;
+    uint64_t total;
+    uint32_t longest;
+    uint16_t hist[PROFILE_BUCKETS];
+} profile_stage_t;
+
+#if PROFILE_ENABLE
+
+#define profile_Start() hal_Ticks()
+void profile_Stop(uint8_t stage, uint32_t start);
+// Adds an interval measured some other way, in cycles.
+void profile_Add(uint8_t stage, uint32_t cycles);
+
+// Builds the telemetry frame in f and clears the histograms.
+void profile_Report(frame_t *f, uint32_t tx_rejected, uint32_t tx_dropped);
+const profile_stage_t *profile_Stage(uint8_t stage);
+
+#else
+
+#define profile_Start() (0u)
+#define profile_Stop(stage, start) ((void)(start))
+#define profile_Add(stage, cycles) ((void)(cycles))
+
+#endif /* PROFILE_ENABLE */
+
+#endif /* PROFILE_H */
+/* [] END OF FILE */
@@ -0,0 +1,67 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "rx.h"
+#include "hal.h"
+#include "tsframe.h"
+
+static uint8_t buf[FRAME_HEADER_SIZE + RX_MAX_PAYLOAD + FRAME_CRC_SIZE];
+static frame_decoder_t decoder = {buf, RX_MAX_PAYLOAD, 0u, 0u, 0u};
+static uint32_t t_sync = 0;
+static rx_frame_t done;
+static uint8_t ready = 0;
+static uint32_t late = 0;
+
+void rx_Service(void)
+{
+    uint8_t b;
+    uint8_t i;
+
+    while(hal_UartRxReady()){
+        b = hal_UartGet();
+        if(decoder.have == 0u && b == FRAME_SYNC0){
+            t_sync = hal_Ticks();
+        }
+        if(frame_Push(&decoder, b) == 0u){
+            continue;
+        }
+        if(ready){
+            late++;
+            continue;
+        }
+        done.type = frame_Type(buf);
+        done.seq = frame_Seq(buf);
+        done.len = frame_Len(buf);
+        for(i = 0; i < done.len; i++){
+            done.payload[i] = buf[FRAME_HEADER_SIZE + i];
+        }
+        done.t_sync = t_sync;
+        ready = 1u;
+    }
+}
+
+uint32_t rx_BadFrames(void)
+{
+    return decoder.bad + late;
+}
+
+uint8_t rx_Poll(rx_frame_t *f)
+{
+    rx_Service();
+    if(ready == 0u){
+        return 0u;
+    }
+    *f = done;
+    ready = 0u;
+    return 1u;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,46 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Frames from the host, in the same format the board sends (tsframe.h).
+//
+// The UART has no RX interrupt and a 4 byte FIFO, so something has to
+// empty it at least every few byte times while the host is talking. The
+// main loop calls rx_Poll on every pass, and work that holds the loop up
+// for longer, like filtering a block, calls rx_Service as it goes. A frame
+// the FIFO overflowed on fails its CRC and is dropped; the host repeats
+// what matters.
+#ifndef RX_H
+#define RX_H
+
+#include <stdint.h>
+
+#define RX_MAX_PAYLOAD              (32u) // longer frames are skipped
+
+typedef struct {
+    uint8_t  type;
+    uint16_t seq;
+    uint8_t  len;
+    uint8_t  payload[RX_MAX_PAYLOAD];
+    uint32_t t_sync;    // hal_Ticks when its first byte came out of the FIFO
+} rx_frame_t;
+
+// CRC failures, oversized frames and ones not polled in time
+uint32_t rx_BadFrames(void);
+
+// Moves whatever the FIFO holds into the frame being assembled, keeping
+// the last complete frame until rx_Poll takes it.
+void rx_Service(void);
+
+// Services the FIFO, then returns 1 with the waiting frame in f, if any.
+uint8_t rx_Poll(rx_frame_t *f);
+
+#endif /* RX_H */
+/* [] END OF FILE */
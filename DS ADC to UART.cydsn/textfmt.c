@@ -0,0 +1,92 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "textfmt.h"
+
+static const char pairs[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint32_t powers[10] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u
+};
+
+static uint8_t digits(uint32_t v)
+{
+    // bits * log10(2), then one compare to fix it up; setting the low bit
+    // makes 0 a one digit number and never moves v across a power of ten
+    uint32_t w = v | 1u;
+    uint32_t guess = ((32u - (uint32_t)__builtin_clz(w)) * 1233u) >> 12;
+
+    return (uint8_t)(guess + 1u - (w < powers[guess]));
+}
+
+uint8_t textfmt_U32(char *out, uint32_t v)
+{
+    uint8_t len = digits(v);
+    char *p = out + len;
+    uint32_t q, r;
+
+    while(v >= 100u){
+        q = (uint32_t)(((uint64_t)v * 0x51EB851Fu) >> 37); // v / 100, exact for 32 bits
+        r = 2u * (v - q * 100u);
+        p -= 2;
+        p[0] = pairs[r];
+        p[1] = pairs[r + 1u];
+        v = q;
+    }
+    if(v >= 10u){
+        p[-1] = pairs[2u * v + 1u];
+        p[-2] = pairs[2u * v];
+    }else{
+        p[-1] = (char)('0' + v);
+    }
+    return len;
+}
+
+uint8_t textfmt_I32(char *out, int32_t v)
+{
+    if(v < 0){
+        out[0] = '-';
+        return (uint8_t)(1u + textfmt_U32(out + 1, 0u - (uint32_t)v));
+    }
+    return textfmt_U32(out, (uint32_t)v);
+}
+
+uint8_t textfmt_Line(char *out, uint32_t millis, int32_t reading)
+{
+    uint8_t n = textfmt_U32(out, millis);
+
+    out[n++] = ':';
+    n += textfmt_I32(out + n, reading);
+    out[n++] = '\r';
+    out[n++] = '\n';
+    return n;
+}
+
+uint32_t textfmt_Millis(uint64_t us)
+{
+    if(us < ((uint64_t)1u << 35)){
+        // (us / 8) / 125, the second step as a multiply-high
+        return (uint32_t)(((us >> 3) * 0x10624DD3u) >> 35);
+    }
+    return (uint32_t)(us / 1000u);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,36 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Decimal formatting for the text stream ("millis:reading" lines).
+//
+// snprintf drags in newlib's printf and takes thousands of cycles a line;
+// these write the digits two at a time from a table and divide by 100 with
+// a multiply-high, so a line costs a few dozen multiplies and no calls into
+// the C library. Output is what "%lu" / "%ld" would print, without the
+// terminating NUL. host/tsfmt checks that against snprintf.
+#ifndef TEXTFMT_H
+#define TEXTFMT_H
+
+#include <stdint.h>
+
+#define TEXTFMT_LINE_MAX            (24u) // "4294967295:-2147483648\r\n"
+
+// Each returns the number of characters written.
+uint8_t textfmt_U32(char *out, uint32_t v);
+uint8_t textfmt_I32(char *out, int32_t v);
+// "millis:reading\r\n"
+uint8_t textfmt_Line(char *out, uint32_t millis, int32_t reading);
+
+// us / 1000 with a multiply for the first 2^35 us (about 9.5 hours).
+uint32_t textfmt_Millis(uint64_t us);
+
+#endif /* TEXTFMT_H */
+/* [] END OF FILE */
@@ -0,0 +1,35 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "timebase.h"
+
+// the counter starts from 0 in hal_Start
+static uint64_t last = 0;
+
+uint64_t timebase_Extend(uint32_t raw)
+{
+    // the difference from the low word is the time since the last call,
+    // even across a wrap
+    last += (uint32_t)(raw - (uint32_t)last);
+    return last;
+}
+
+uint64_t timebase_At(uint32_t raw)
+{
+    return last + (uint64_t)(int64_t)(int32_t)(raw - (uint32_t)last);
+}
+
+uint64_t timebase_Micros(uint64_t ticks)
+{
+    return ticks / (TIMEBASE_HZ / TIMEBASE_MICROS_HZ);
+}
+
+/* [] END OF FILE */
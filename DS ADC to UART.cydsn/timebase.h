@@ -0,0 +1,37 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// Sample timebase built on the Cortex-M3 DWT cycle counter (hal_Ticks).
+//
+// CYCCNT runs at the bus clock (24 MHz here) and wraps every ~179 s, so it
+// is cheap enough to latch in every adc interrupt. The main loop turns the
+// latched values into a 64 bit count with timebase_Extend and into
+// microseconds with timebase_Micros; that is the unit the frames carry.
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include "hal.h"
+
+#define TIMEBASE_HZ                 (HAL_TICK_HZ)
+#define TIMEBASE_MICROS_HZ          (1000000u)
+
+// Extends a latched 32 bit count to 64 bits. Counts must be passed in
+// order and less than one wrap apart; only call this from the main loop.
+uint64_t timebase_Extend(uint32_t raw);
+// Extends a count within half a wrap of the last one passed to
+// timebase_Extend, on either side, without moving the timebase on; for
+// counts latched outside the ordered stream of conversion times.
+uint64_t timebase_At(uint32_t raw);
+uint64_t timebase_Micros(uint64_t ticks);
+
+#endif /* TIMEBASE_H */
+/* [] END OF FILE */
@@ -0,0 +1,57 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "hal.h"
+#include "uart_tx.h"
+
+#define RING_MASK (UART_TX_RING_SIZE - 1u)
+
+static uint8_t ring[UART_TX_RING_SIZE];
+static uint16_t head = 0; // next byte written
+static uint16_t tail = 0; // next byte sent
+
+volatile uint32_t uart_tx_overflowCount = 0;
+volatile uint32_t uart_tx_droppedBytes = 0;
+
+uint16_t uart_tx_Free(void)
+{
+    return (uint16_t)(UART_TX_RING_SIZE - 1u - ((head - tail) & RING_MASK));
+}
+
+uint8_t uart_tx_Write(const uint8_t data[], uint16_t len)
+{
+    uint16_t i;
+
+    if(len > uart_tx_Free()){
+        uart_tx_overflowCount++;
+        uart_tx_droppedBytes += len;
+        return 0u;
+    }
+    for(i = 0; i < len; i++){
+        ring[head] = data[i];
+        head = (head + 1u) & RING_MASK;
+    }
+    return 1u;
+}
+
+uint16_t uart_tx_Service(void)
+{
+    uint16_t moved = 0u;
+
+    while(tail != head && hal_UartReady()){
+        hal_UartPut(ring[tail]);
+        tail = (tail + 1u) & RING_MASK;
+        moved++;
+    }
+    return moved;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,38 @@
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+// RAM transmit queue in front of the UART.
+//
+// The UART component is built with a 4 byte hardware FIFO and no TX
+// interrupt, so UART_PutArray spins until every byte is out. uart_tx_Write
+// only copies into the ring and returns; uart_tx_Service moves whatever fits
+// into the FIFO and must be called at least every 350 us at 115200 baud to
+// keep the line busy. acquire.c calls it on every poll and every 16
+// conversions inside the block loops. The FIFO is reached through hal.h.
+#ifndef UART_TX_H
+#define UART_TX_H
+
+#include <stdint.h>
+
+#define UART_TX_RING_SIZE           (8192u) // must be a power of two
+
+extern volatile uint32_t uart_tx_overflowCount;  // writes rejected because the ring was full
+extern volatile uint32_t uart_tx_droppedBytes;   // bytes in those writes
+
+// Queues all len bytes or none of them, so frames are never cut in half.
+// Returns 1 if queued, 0 if the ring did not have room.
+uint8_t uart_tx_Write(const uint8_t data[], uint16_t len);
+uint16_t uart_tx_Free(void);
+// Returns the number of bytes moved into the FIFO.
+uint16_t uart_tx_Service(void);
+
+#endif /* UART_TX_H */
+/* [] END OF FILE */
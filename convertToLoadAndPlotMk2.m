@@ -61,26 +61,30 @@ for p=length(holder):-1:1
     end
 end    
 
-fifthElementTime = median(holder(1,1:10));
-timeStep=mean(diff(holder(1,1:100)));
-firstElementTime = fifthElementTime - (4*timeStep);
-secondElementTime = fifthElementTime - (3*timeStep);
-if(abs(holder(1,1)-firstElementTime)>fifthElementTime)
-    holder(1,1)=firstElementTime;
-end
-if(abs(holder(1,2)-secondElementTime)>fifthElementTime)
-    holder(1,2)=secondElementTime;
-end
-for c=3:length(holder)-1
-    if (holder(1,c)<holder(1,c-1))
-        holder(1,c)=((holder(1,c-1)-holder(1,c-2))/2)+holder(1,c-1);
-    elseif(holder(1,c)>holder(1,c+1))
-        holder(1,c)=((holder(1,c-1)-holder(1,c-2))/2)+holder(1,c-1);
+%Only streams stamped by the old millisecond counter need their timestamps
+%repaired, the microsecond timebase is already monotonic
+if(any(diff(holder(1,:))<0))
+    fifthElementTime = median(holder(1,1:10));
+    timeStep=mean(diff(holder(1,1:100)));
+    firstElementTime = fifthElementTime - (4*timeStep);
+    secondElementTime = fifthElementTime - (3*timeStep);
+    if(abs(holder(1,1)-firstElementTime)>fifthElementTime)
+        holder(1,1)=firstElementTime;
     end
-    if (mod(p,round(pPrime/1000))==0)
-            clc
-            disp('... reviewing and removing faulty data ...')
-            disp([num2str(round(25*p/length(holder),2)+25),'% reviewed'])
+    if(abs(holder(1,2)-secondElementTime)>fifthElementTime)
+        holder(1,2)=secondElementTime;
+    end
+    for c=3:length(holder)-1
+        if (holder(1,c)<holder(1,c-1))
+            holder(1,c)=((holder(1,c-1)-holder(1,c-2))/2)+holder(1,c-1);
+        elseif(holder(1,c)>holder(1,c+1))
+            holder(1,c)=((holder(1,c-1)-holder(1,c-2))/2)+holder(1,c-1);
+        end
+        if (mod(p,round(pPrime/1000))==0)
+                clc
+                disp('... reviewing and removing faulty data ...')
+                disp([num2str(round(25*p/length(holder),2)+25),'% reviewed'])
+        end
     end
 end
 
@@ -0,0 +1,107 @@
+// This file is part of the code for the SEDS test stand.
+#include "burn_detector.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tsstand {
+
+BurnDetector::BurnDetector(const BurnDetectorConfig& config)
+    : cfg_(config)
+{
+    cfg_.hold = std::max<size_t>(cfg_.hold, 1);
+    cfg_.baseline_window = std::max<size_t>(cfg_.baseline_window, 2);
+    ring_keep_ = cfg_.pre + cfg_.hold;
+    size_t size = 1;
+    while (size < ring_keep_)
+        size <<= 1;
+    ring_.resize(size);
+    ring_mask_ = size - 1;
+}
+
+void BurnDetector::learn(int32_t value)
+{
+    n_++;
+    double d = value - w_mean_;
+    w_mean_ += d / n_;
+    w_m2_ += d * (value - w_mean_);
+    if (n_ < cfg_.baseline_window)
+        return;
+
+    double sd = std::sqrt(w_m2_ / (n_ - 1));
+    mean_ = w_mean_;
+    start_level_ = std::max(cfg_.start_sigmas * sd, cfg_.min_rise);
+    end_level_ = std::min(cfg_.end_sigmas * sd, start_level_);
+    info_.baseline_mean = mean_;
+    info_.baseline_sd = sd;
+    have_baseline_ = true;
+    n_ = 0;
+    w_mean_ = w_m2_ = 0;
+}
+
+BurnDetector::Action BurnDetector::update(const Sample& s)
+{
+    double d = deviation(s.value);
+    switch (state_) {
+    case State::Idle:
+        ring_[ring_next_++ & ring_mask_] = s;
+        ring_count_ = std::min(ring_count_ + 1, ring_keep_);
+        if (!have_baseline_ || !(d > start_level_)) {
+            run_ = 0;
+            learn(s.value);
+            return Action::Drop;
+        }
+        if (run_++ == 0)
+            run_t_ = s.t;
+        if (run_ < cfg_.hold)
+            return Action::Drop;
+        state_ = State::Burning;
+        run_ = 0;
+        info_.start_t = run_t_;
+        info_.end_t = 0;
+        info_.kept = 0;
+        info_.peak = s.value;
+        return Action::Start;
+
+    case State::Burning:
+        if (deviation(s.value) > deviation(info_.peak))
+            info_.peak = s.value;
+        if (d < end_level_) {
+            if (run_++ == 0)
+                run_t_ = s.t;
+            if (run_ >= cfg_.hold) {
+                state_ = State::Tail;
+                run_ = 0;
+                tail_ = 0;
+                info_.end_t = run_t_;
+            }
+        } else {
+            run_ = 0;
+        }
+        return Action::Keep;
+
+    case State::Tail:
+        // a motor that picks up again during the tail is the same burn
+        if (d > start_level_) {
+            if (++run_ >= cfg_.hold) {
+                state_ = State::Burning;
+                run_ = 0;
+                return Action::Keep;
+            }
+        } else {
+            run_ = 0;
+        }
+        if (++tail_ < cfg_.post)
+            return Action::Keep;
+        state_ = State::Idle;
+        run_ = 0;
+        ring_count_ = 0;
+        // the next baseline comes from after the burn
+        n_ = 0;
+        w_mean_ = w_m2_ = 0;
+        return Action::End;
+    }
+    return Action::Drop;
+}
+
+} // namespace tsstand
@@ -0,0 +1,111 @@
+// Streaming burn detection for the acquisition path: decides, sample by
+// sample, which parts of a run are worth keeping at full rate.
+// This file is part of the code for the SEDS test stand.
+//
+// The detector learns the quiet baseline (mean and standard deviation, by
+// Welford's method over consecutive windows of idle samples, so it follows
+// slow drift) and fires a start event once the reading stays more than
+// start_sigmas above it for hold samples. The burn ends once the reading
+// has stayed under the lower end_sigmas threshold for hold samples; the
+// gap between the two thresholds is the hysteresis that stops a noisy tail
+// from ending and restarting the burn. The pre samples before the start are
+// kept in a ring and released with the start event, and post samples are
+// kept after the end before the end event fires.
+#pragma once
+
+#include "frame_decoder.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tsstand {
+
+struct BurnDetectorConfig {
+    size_t baseline_window = 2400; // samples per baseline estimate
+    double start_sigmas = 8;
+    double end_sigmas = 4;
+    double min_rise = 0; // counts; the start threshold is at least this far up
+    size_t hold = 8;
+    size_t pre = 2400;
+    size_t post = 2400;
+    int polarity = 1; // -1 if thrust makes the reading go down
+};
+
+enum class BurnEvent { Start, End };
+
+struct BurnInfo {
+    int64_t start_t = 0; // first sample over the start threshold
+    int64_t end_t = 0;   // first of the hold samples back under the end threshold
+    uint64_t kept = 0;   // samples handed to keep() for this burn, pre and post included
+    int32_t peak = 0;
+    double baseline_mean = 0;
+    double baseline_sd = 0;
+};
+
+class BurnDetector {
+public:
+    explicit BurnDetector(const BurnDetectorConfig& config);
+
+    // keep(const Sample&) receives every sample that belongs to a burn
+    // window, in order; on_event(BurnEvent, const BurnInfo&) is called
+    // before the first sample of a burn and after its last.
+    template <class Keep, class OnEvent>
+    void push(const Sample& s, Keep&& keep, OnEvent&& on_event)
+    {
+        switch (update(s)) {
+        case Action::Drop:
+            break;
+        case Action::Keep:
+            info_.kept++;
+            keep(s);
+            break;
+        case Action::Start:
+            on_event(BurnEvent::Start, static_cast<const BurnInfo&>(info_));
+            for (size_t i = ring_count_; i > 0; i--) {
+                info_.kept++;
+                keep(ring_[(ring_next_ - i) & ring_mask_]);
+            }
+            ring_count_ = 0;
+            break;
+        case Action::End:
+            info_.kept++;
+            keep(s);
+            on_event(BurnEvent::End, static_cast<const BurnInfo&>(info_));
+            break;
+        }
+    }
+
+    bool in_burn() const { return state_ == State::Burning || state_ == State::Tail; }
+    bool ready() const { return have_baseline_; }
+
+private:
+    enum class State { Idle, Burning, Tail };
+    enum class Action { Drop, Keep, Start, End };
+
+    Action update(const Sample& s);
+    void learn(int32_t value);
+    double deviation(int32_t value) const { return cfg_.polarity * (value - mean_); }
+
+    BurnDetectorConfig cfg_;
+    State state_ = State::Idle;
+    BurnInfo info_;
+
+    // baseline in use, and the Welford sums for the window being collected
+    bool have_baseline_ = false;
+    double mean_ = 0, start_level_ = 0, end_level_ = 0;
+    size_t n_ = 0;
+    double w_mean_ = 0, w_m2_ = 0;
+
+    size_t run_ = 0;  // samples in a row on the far side of the threshold
+    size_t tail_ = 0; // samples kept since the end condition was met
+    int64_t run_t_ = 0;
+
+    std::vector<Sample> ring_;
+    size_t ring_mask_ = 0;
+    size_t ring_next_ = 0;
+    size_t ring_count_ = 0;
+    size_t ring_keep_ = 0; // how many samples the start event releases at most
+};
+
+} // namespace tsstand
@@ -0,0 +1,299 @@
+// This file is part of the code for the SEDS test stand.
+#include "calibration.hpp"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
+
+namespace tsstand {
+
+static void fail(const std::string& what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+Calibration load_calibration(const std::string& path)
+{
+    FILE* in = std::fopen(path.c_str(), "r");
+    if (!in)
+        fail(path);
+    Calibration cal;
+    unsigned version = 0;
+    bool have_gain = false, have_offset = false;
+    char line[256];
+    if (!std::fgets(line, sizeof line, in) || std::sscanf(line, "tscal %u", &version) != 1) {
+        std::fclose(in);
+        throw std::runtime_error(path + ": not a calibration record");
+    }
+    if (version > kCalVersion) {
+        std::fclose(in);
+        throw std::runtime_error(path + ": calibration record version " + std::to_string(version) +
+                                 " is newer than this tool");
+    }
+    while (std::fgets(line, sizeof line, in)) {
+        line[std::strcspn(line, "\r\n")] = 0;
+        char* value = std::strchr(line, ' ');
+        if (!value)
+            continue;
+        *value++ = 0;
+        double v = std::strtod(value, nullptr);
+        if (!std::strcmp(line, "gain")) {
+            cal.gain = v;
+            have_gain = true;
+        } else if (!std::strcmp(line, "offset")) {
+            cal.offset = v;
+            have_offset = true;
+        } else if (!std::strcmp(line, "square")) {
+            cal.square = v;
+        } else if (!std::strcmp(line, "cube")) {
+            cal.cube = v;
+        } else if (!std::strcmp(line, "temp_input")) {
+            cal.temp_input = static_cast<int>(v);
+        } else if (!std::strcmp(line, "temp_gain")) {
+            cal.temp_gain = v;
+        } else if (!std::strcmp(line, "temp_ref")) {
+            cal.temp_ref = v;
+        } else if (!std::strcmp(line, "board_id")) {
+            cal.board_id = static_cast<uint32_t>(v);
+        } else if (!std::strcmp(line, "made")) {
+            cal.made_unix = std::strtoll(value, nullptr, 10);
+        } else if (!std::strcmp(line, "points")) {
+            cal.points = static_cast<uint32_t>(v);
+        } else if (!std::strcmp(line, "rms")) {
+            cal.rms = v;
+        } else if (!std::strcmp(line, "note")) {
+            cal.note = value;
+        }
+    }
+    bool bad = std::ferror(in);
+    std::fclose(in);
+    if (bad)
+        fail(path);
+    if (!have_gain || !have_offset)
+        throw std::runtime_error(path + ": calibration record has no gain or offset");
+    if (cal.temp_input < 0)
+        cal.temp_gain = 0;
+    return cal;
+}
+
+void save_calibration(const std::string& path, const Calibration& cal)
+{
+    std::string tmp = path + ".tmp";
+    FILE* out = std::fopen(tmp.c_str(), "w");
+    if (!out)
+        fail(tmp);
+    std::fprintf(out, "tscal %u\n", kCalVersion);
+    std::fprintf(out, "board_id %" PRIu32 "\n", cal.board_id);
+    std::fprintf(out, "made %" PRId64 "\n", cal.made_unix);
+    std::fprintf(out, "points %" PRIu32 "\n", cal.points);
+    std::fprintf(out, "rms %.17g\n", cal.rms);
+    std::fprintf(out, "gain %.17g\n", cal.gain);
+    std::fprintf(out, "offset %.17g\n", cal.offset);
+    std::fprintf(out, "square %.17g\n", cal.square);
+    std::fprintf(out, "cube %.17g\n", cal.cube);
+    std::fprintf(out, "temp_input %d\n", cal.temp_input);
+    std::fprintf(out, "temp_gain %.17g\n", cal.temp_gain);
+    std::fprintf(out, "temp_ref %.17g\n", cal.temp_ref);
+    if (!cal.note.empty())
+        std::fprintf(out, "note %s\n", cal.note.c_str());
+    bool bad = std::fflush(out) != 0 || fsync(fileno(out)) != 0;
+    bad |= std::fclose(out) != 0;
+    if (bad || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        int err = errno;
+        std::remove(tmp.c_str());
+        errno = err;
+        fail(path);
+    }
+}
+
+std::string find_calibration(const char* given)
+{
+    if (given)
+        return given;
+    if (const char* env = std::getenv("TSSTAND_CAL"))
+        return env;
+    if (access(kCalDefaultPath, F_OK) == 0)
+        return kCalDefaultPath;
+    return {};
+}
+
+BoardCalibration to_board(const Calibration& cal, bool newtons)
+{
+    double gain = std::round(cal.gain * 1000 * 65536);
+    double offset = std::round(cal.offset);
+    if (!(std::abs(gain) <= INT32_MAX && std::abs(offset) <= INT32_MAX) || gain == 0)
+        throw std::range_error("calibration does not fit the board's fixed point");
+    BoardCalibration b;
+    b.board_id = static_cast<uint16_t>(cal.board_id);
+    b.gain = static_cast<int32_t>(gain);
+    b.offset = static_cast<int32_t>(offset);
+    b.flags = newtons ? kBoardNewtons : 0;
+    return b;
+}
+
+Calibration from_board(const BoardCalibration& b)
+{
+    Calibration cal;
+    cal.gain = b.gain / 65536.0 / 1000;
+    cal.offset = b.offset;
+    cal.board_id = b.board_id;
+    return cal;
+}
+
+static void put_le(uint8_t* p, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static uint32_t get_le(const uint8_t* p, int bytes)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < bytes; i++)
+        v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+size_t encode_board_calibration(const BoardCalibration& b, uint8_t* payload)
+{
+    put_le(payload, b.board_id, 2);
+    put_le(payload + 2, static_cast<uint32_t>(b.gain), 4);
+    put_le(payload + 6, static_cast<uint32_t>(b.offset), 4);
+    payload[10] = b.flags;
+    return kBoardCalRequestSize;
+}
+
+bool decode_board_calibration(const uint8_t* payload, size_t len, BoardCalibration& b)
+{
+    if (len < kBoardCalReplySize)
+        return false;
+    b.seq = static_cast<uint16_t>(get_le(payload, 2));
+    b.board_id = static_cast<uint16_t>(get_le(payload + 2, 2));
+    b.gain = static_cast<int32_t>(get_le(payload + 4, 4));
+    b.offset = static_cast<int32_t>(get_le(payload + 8, 4));
+    b.flags = payload[12];
+    b.status = payload[13];
+    return true;
+}
+
+Calibration milli_newtons()
+{
+    Calibration cal;
+    cal.gain = 0.001;
+    cal.note = "milli-newtons from the board";
+    return cal;
+}
+
+LeastSquares::LeastSquares(size_t terms) : terms_(terms)
+{
+    if (terms == 0 || terms > kMaxTerms)
+        throw std::invalid_argument("LeastSquares: unsupported number of terms");
+}
+
+void LeastSquares::add(const double* x, double y, double weight)
+{
+    double s = std::sqrt(weight);
+    double row[kMaxTerms];
+    for (size_t j = 0; j < terms_; j++) {
+        row[j] = x[j] * s;
+        norm2_[j] += row[j] * row[j];
+    }
+    y *= s;
+    // rotate the row into R, zeroing it one column at a time
+    for (size_t k = 0; k < terms_; k++) {
+        if (row[k] == 0)
+            continue;
+        double h = std::hypot(r_[k][k], row[k]);
+        double c = r_[k][k] / h, sn = row[k] / h;
+        r_[k][k] = h;
+        for (size_t j = k + 1; j < terms_; j++) {
+            double a = r_[k][j];
+            r_[k][j] = c * a + sn * row[j];
+            row[j] = c * row[j] - sn * a;
+        }
+        double a = qty_[k];
+        qty_[k] = c * a + sn * y;
+        y = c * y - sn * a;
+    }
+    // what is left of y is out of reach of every term
+    ssr_ += y * y;
+    rows_++;
+}
+
+bool LeastSquares::solve(double* coef) const
+{
+    for (size_t k = terms_; k-- > 0;) {
+        if (norm2_[k] == 0 || std::abs(r_[k][k]) <= 1e-12 * std::sqrt(norm2_[k]))
+            return false;
+        double v = qty_[k];
+        for (size_t j = k + 1; j < terms_; j++)
+            v -= r_[k][j] * coef[j];
+        coef[k] = v / r_[k][k];
+    }
+    return true;
+}
+
+Calibrator::Calibrator(unsigned degree, bool temperature)
+    : degree_(degree), temperature_(temperature), fit_(1 + degree + (temperature ? 1 : 0))
+{
+    if (degree < 1 || degree > 3)
+        throw std::invalid_argument("Calibrator: degree must be 1 to 3");
+}
+
+void Calibrator::add(double newtons, double counts, double temp)
+{
+    if (fit_.rows() == 0) {
+        ref_counts_ = counts;
+        ref_temp_ = temp;
+    }
+    double x[LeastSquares::kMaxTerms];
+    double u = counts - ref_counts_, p = 1;
+    for (unsigned k = 0; k <= degree_; k++, p *= u)
+        x[k] = p;
+    if (temperature_)
+        x[degree_ + 1] = temp - ref_temp_;
+    fit_.add(x, newtons);
+}
+
+bool Calibrator::fit(Calibration& out) const
+{
+    double coef[LeastSquares::kMaxTerms];
+    if (!fit_.solve(coef) || coef[1] == 0)
+        return false;
+    double a[4] = {};
+    for (unsigned k = 0; k <= degree_; k++)
+        a[k] = coef[k];
+
+    // move the origin to the reading at zero load, by Newton's method from
+    // the linear estimate
+    auto p = [&](double u) { return ((a[3] * u + a[2]) * u + a[1]) * u + a[0]; };
+    auto dp = [&](double u) { return (3 * a[3] * u + 2 * a[2]) * u + a[1]; };
+    double z = -a[0] / a[1];
+    for (int i = 0; i < 50; i++) {
+        double d = dp(z);
+        if (d == 0)
+            return false;
+        double step = p(z) / d;
+        z -= step;
+        if (std::abs(step) <= 1e-12 * (1 + std::abs(z)))
+            break;
+    }
+
+    out.offset = ref_counts_ + z;
+    out.gain = dp(z);
+    out.square = a[2] + 3 * a[3] * z;
+    out.cube = a[3];
+    out.temp_gain = temperature_ ? coef[degree_ + 1] : 0;
+    out.temp_ref = ref_temp_;
+    out.points = static_cast<uint32_t>(fit_.rows());
+    out.rms = std::sqrt(fit_.residual_ss() / static_cast<double>(fit_.rows()));
+    return true;
+}
+
+} // namespace tsstand
@@ -0,0 +1,163 @@
+// Load cell calibration: the running statistics and the least squares fit
+// behind tscal, and the calibration record the other tools load. Replaces
+// calibrationGUI.m and the convFact hand-edited into
+// convertToLoadAndPlotMk2.m.
+// This file is part of the code for the SEDS test stand.
+//
+// A record maps a reading to newtons as
+//
+//   u = counts - offset
+//   N = gain u + square u^2 + cube u^3 + temp_gain (temp - temp_ref)
+//
+// where temp is the reading of another board input (temp_input) taken
+// with it. offset is the reading at zero load, so a linear record is just
+// the gain and offset the run file has always carried. Records are small
+// text files, one "key value" per line after a "tscal <version>" line;
+// unknown keys are skipped so older tools can read newer records.
+//
+// A board keeps the linear part in EEPROM (calstore.h in the firmware), in
+// fixed point, and can send milli-newtons instead of counts with it.
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tsstand {
+
+constexpr unsigned kCalVersion = 1;
+constexpr const char* kCalDefaultPath = "tsstand.cal";
+
+struct Calibration {
+    double gain = 1;   // newtons per count at zero load
+    double offset = 0; // counts at zero load
+    double square = 0; // newtons per count^2
+    double cube = 0;   // newtons per count^3
+    int temp_input = -1; // board input read as temperature, -1 for none
+    double temp_gain = 0; // newtons per count of temp_input
+    double temp_ref = 0;  // temp_input reading the fit was centered on
+
+    uint32_t board_id = 0;
+    int64_t made_unix = 0; // 0 for a calibration given by hand
+    uint32_t points = 0;   // loads the fit was made from
+    double rms = 0;        // newtons, residual of the fit
+    std::string note;
+
+    bool linear() const { return square == 0 && cube == 0 && temp_gain == 0; }
+
+    double newtons(double counts) const
+    {
+        double u = counts - offset;
+        return ((cube * u + square) * u + gain) * u;
+    }
+    double newtons(double counts, double temp) const { return newtons(counts) + temp_gain * (temp - temp_ref); }
+};
+
+// Reads a record. Throws std::system_error if the file cannot be read and
+// std::runtime_error if it is not a record this version understands.
+Calibration load_calibration(const std::string& path);
+
+// Writes a record, replacing path atomically. Throws std::system_error.
+void save_calibration(const std::string& path, const Calibration& cal);
+
+// Where tools look for a record: the given path, else $TSSTAND_CAL, else
+// kCalDefaultPath if it exists. Empty if there is none to load.
+std::string find_calibration(const char* given);
+
+// What a board holds in EEPROM, as carried by FRAME_TYPE_CAL.
+struct BoardCalibration {
+    uint16_t seq = 0; // bumped by every store; 0 if the board has none
+    uint16_t board_id = 0;
+    int32_t gain = 0x10000; // milli-newtons per count, 16.16 fixed point
+    int32_t offset = 0;     // counts at zero load
+    uint8_t flags = 0;      // kBoardNewtons
+    uint8_t status = 0;     // of a reply: 0 ok, 1 the write failed, 2 none stored
+};
+constexpr uint8_t kBoardNewtons = 0x01;
+constexpr size_t kBoardCalRequestSize = 11;
+constexpr size_t kBoardCalReplySize = 14;
+
+// The linear part of cal for a board. Throws std::range_error if it does
+// not fit the board's fixed point.
+BoardCalibration to_board(const Calibration& cal, bool newtons);
+Calibration from_board(const BoardCalibration& b);
+// A request to store b; payload needs kBoardCalRequestSize bytes.
+size_t encode_board_calibration(const BoardCalibration& b, uint8_t* payload);
+// Reads a reply; false if it is too short.
+bool decode_board_calibration(const uint8_t* payload, size_t len, BoardCalibration& b);
+// The calibration of readings a board already sent in milli-newtons.
+Calibration milli_newtons();
+
+// Mean and variance in O(1) per sample, by Welford's method.
+class RunningStats {
+public:
+    void add(double x)
+    {
+        n_++;
+        double d = x - mean_;
+        mean_ += d / static_cast<double>(n_);
+        m2_ += d * (x - mean_);
+    }
+    void reset() { *this = RunningStats(); }
+
+    uint64_t count() const { return n_; }
+    double mean() const { return mean_; }
+    double variance() const { return n_ > 1 ? m2_ / static_cast<double>(n_ - 1) : 0; }
+    double stddev() const { return std::sqrt(variance()); }
+    // standard error of the mean
+    double sem() const { return n_ > 1 ? std::sqrt(variance() / static_cast<double>(n_)) : INFINITY; }
+
+private:
+    uint64_t n_ = 0;
+    double mean_ = 0, m2_ = 0;
+};
+
+// Linear least squares one row at a time. Each row is rotated into an
+// upper triangular R (Givens rotations, so no normal equations and no
+// stored rows), at O(terms^2) per row; solve() back-substitutes.
+class LeastSquares {
+public:
+    static constexpr size_t kMaxTerms = 6;
+
+    explicit LeastSquares(size_t terms);
+
+    void add(const double* x, double y, double weight = 1);
+    // false until there are enough independent rows for every term
+    bool solve(double* coef) const;
+
+    size_t terms() const { return terms_; }
+    size_t rows() const { return rows_; }
+    double residual_ss() const { return ssr_; } // weighted, at the solution
+
+private:
+    size_t terms_;
+    size_t rows_ = 0;
+    double r_[kMaxTerms][kMaxTerms] = {};
+    double qty_[kMaxTerms] = {};
+    double norm2_[kMaxTerms] = {}; // of each column, for the rank test
+    double ssr_ = 0;
+};
+
+// Fits a Calibration to points of known load, refitting after each one.
+// degree is that of the polynomial in counts (1 to 3); with temperature,
+// every point also carries the reading of the temperature input.
+class Calibrator {
+public:
+    Calibrator(unsigned degree, bool temperature);
+
+    void add(double newtons, double counts, double temp = 0);
+    size_t points() const { return fit_.rows(); }
+    // false until there are enough points; keeps out's other fields
+    bool fit(Calibration& out) const;
+
+private:
+    unsigned degree_;
+    bool temperature_;
+    // readings are taken relative to the first point's, which keeps the
+    // powers of the counts well apart
+    double ref_counts_ = 0, ref_temp_ = 0;
+    LeastSquares fit_;
+};
+
+} // namespace tsstand
@@ -0,0 +1,57 @@
+// This file is part of the code for the SEDS test stand.
+#include "clock_sync.hpp"
+
+#include <algorithm>
+
+namespace tsstand {
+
+void ClockSync::add(int64_t host_sent, int64_t host_received, int64_t board)
+{
+    points_.push_back({board, host_sent + (host_received - host_sent) / 2, host_received - host_sent});
+    if (points_.size() > window_)
+        points_.pop_front();
+    fit();
+}
+
+void ClockSync::fit()
+{
+    best_rtt_ = points_.front().rtt;
+    for (const Point& p : points_)
+        best_rtt_ = std::min(best_rtt_, p.rtt);
+    // within a millisecond or half again of the best round trip
+    int64_t limit = best_rtt_ + std::max<int64_t>(best_rtt_ / 2, 1000000);
+
+    // measured from the oldest point in the window, so the doubles stay as
+    // small as the window however long the session runs
+    board0_ = points_.front().board;
+    host0_ = points_.front().host_mid;
+    double n = 0, sx = 0, sy = 0, sxx = 0;
+    for (const Point& p : points_) {
+        if (p.rtt > limit)
+            continue;
+        double x = static_cast<double>(p.board - board0_);
+        n++;
+        sx += x;
+        sy += static_cast<double>(p.host_mid - host0_);
+        sxx += x * x;
+    }
+    used_ = static_cast<size_t>(n);
+    // and about their mean, which the sums of squares need to keep precision
+    double mx = sx / n, my = sy / n, dxx = 0, dxy = 0;
+    for (const Point& p : points_) {
+        if (p.rtt > limit)
+            continue;
+        double dx = static_cast<double>(p.board - board0_) - mx;
+        dxx += dx * dx;
+        dxy += dx * (static_cast<double>(p.host_mid - host0_) - my);
+    }
+    // a line needs a spread of board times; until then assume no drift
+    if (n >= 2 && dxx > 1e-9 * sxx)
+        b_ = dxy / dxx;
+    else
+        b_ = ns_per_tick_;
+    a_ = my - b_ * mx;
+    fitted_ = true;
+}
+
+} // namespace tsstand
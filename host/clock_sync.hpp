@@ -0,0 +1,65 @@
+// Maps a board's clock onto the host's, from sync exchanges over the
+// board's RX line (FRAME_TYPE_SYNC in tsframe.h).
+// This file is part of the code for the SEDS test stand.
+//
+// The host notes when it sent a request and when the reply came back; the
+// board answers with its own time at the moment the request arrived. The
+// reply waits in the board's transmit ring behind whatever samples were
+// queued, so most round trips are much longer than the link itself and
+// their midpoint says little about when the board saw the request. Only
+// the exchanges whose round trip is close to the shortest one in the
+// window are used: for those, the board's time lies near the middle of
+// the round trip. A least squares line through them over the last
+// `window` exchanges gives offset and drift, so the estimate follows the
+// crystal as it warms up.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace tsstand {
+
+class ClockSync {
+public:
+    explicit ClockSync(size_t window = 64) : window_(window) {}
+
+    // Host times in ns, board time in its own ticks (unwrapped).
+    void add(int64_t host_sent, int64_t host_received, int64_t board);
+    void reset() { points_.clear(); fitted_ = false; }
+
+    bool ready() const { return fitted_; }
+    // Host time in ns for a board time; only meaningful once ready().
+    int64_t to_host(int64_t board) const
+    {
+        return host0_ + static_cast<int64_t>(a_ + b_ * static_cast<double>(board - board0_));
+    }
+
+    // How fast the board's clock runs against the host's.
+    double drift_ppm() const { return (ns_per_tick_ / b_ - 1) * 1e6; }
+    int64_t best_rtt_ns() const { return best_rtt_; }
+    size_t used() const { return used_; }
+
+    // Board ticks per second, from its hello frame; 1 MHz until set.
+    void set_tick_hz(uint32_t hz) { ns_per_tick_ = 1e9 / hz; }
+
+private:
+    struct Point {
+        int64_t board;
+        int64_t host_mid;
+        int64_t rtt;
+    };
+
+    void fit();
+
+    size_t window_;
+    std::deque<Point> points_;
+    double ns_per_tick_ = 1000;
+    int64_t board0_ = 0, host0_ = 0; // origin, the oldest point in the window
+    double a_ = 0, b_ = 0;           // host ns since host0_ = a_ + b_ * ticks since board0_
+    int64_t best_rtt_ = 0;
+    size_t used_ = 0;
+    bool fitted_ = false;
+};
+
+} // namespace tsstand
@@ -0,0 +1,69 @@
+// This file is part of the code for the SEDS test stand.
+#include "command.hpp"
+
+#include <cctype>
+#include <cstdlib>
+#include <strings.h>
+
+namespace tsstand {
+
+#define COMMAND_INFO(name, id, min, max, initial, help) {#name, id, min, max, initial, help},
+const CommandInfo kCommands[COMMAND_COUNT] = {COMMAND_LIST(COMMAND_INFO)};
+#undef COMMAND_INFO
+
+const CommandInfo* find_command(const std::string& name)
+{
+    char* end;
+    long id = std::strtol(name.c_str(), &end, 0);
+    bool numeric = !name.empty() && *end == 0;
+    for (const CommandInfo& c : kCommands) {
+        if (numeric ? c.id == id : strcasecmp(c.name, name.c_str()) == 0)
+            return &c;
+    }
+    return nullptr;
+}
+
+std::string command_name(const CommandInfo& c)
+{
+    std::string s = c.name;
+    for (char& ch : s)
+        ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return s;
+}
+
+const char* command_status(uint8_t status)
+{
+    switch (status) {
+    case COMMAND_OK: return "ok";
+    case COMMAND_UNKNOWN: return "unknown setting";
+    case COMMAND_RANGE: return "out of range";
+    case COMMAND_UNSUPPORTED: return "not supported by this board";
+    case COMMAND_BUSY: return "busy, try again";
+    default: return "unknown status";
+    }
+}
+
+size_t encode_command(uint8_t id, const int32_t* value, uint8_t* payload)
+{
+    payload[0] = id;
+    if (!value)
+        return 1;
+    for (int i = 0; i < 4; i++)
+        payload[1 + i] = static_cast<uint8_t>(static_cast<uint32_t>(*value) >> (8 * i));
+    return kCommandRequestSize;
+}
+
+bool decode_command_reply(const uint8_t* payload, size_t len, CommandReply& r)
+{
+    if (len < kCommandReplySize)
+        return false;
+    r.id = payload[0];
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= static_cast<uint32_t>(payload[1 + i]) << (8 * i);
+    r.value = static_cast<int32_t>(v);
+    r.status = payload[5];
+    return true;
+}
+
+} // namespace tsstand
@@ -0,0 +1,49 @@
+// The settings a board takes at run time over its RX line: rate, adc
+// configuration, output format and burst trigger. They are defined once,
+// in the firmware's command.h, and the table here is built from the same
+// list, so a tool and the board it talks to agree on IDs and limits.
+// This file is part of the code for the SEDS test stand.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+extern "C" {
+#include "command.h"
+}
+
+namespace tsstand {
+
+struct CommandInfo {
+    const char* name; // as in command.h, e.g. "TRIGGER_LEVEL"
+    uint8_t id;
+    int32_t min, max, initial;
+    const char* help;
+};
+
+extern const CommandInfo kCommands[COMMAND_COUNT];
+
+// By name, in any case, or by ID; nullptr if there is no such setting.
+const CommandInfo* find_command(const std::string& name);
+// The name in lower case, the way the tools print and take it.
+std::string command_name(const CommandInfo& c);
+// "ok", "unknown setting" and so on for a reply's status.
+const char* command_status(uint8_t status);
+
+constexpr size_t kCommandRequestSize = 5;
+constexpr size_t kCommandReplySize = 6;
+
+struct CommandReply {
+    uint8_t id = 0;
+    int32_t value = 0; // in force after the request
+    uint8_t status = 0;
+};
+
+// A request to set id to *value, or to report it if value is null; payload
+// needs kCommandRequestSize bytes. Returns the payload size.
+size_t encode_command(uint8_t id, const int32_t* value, uint8_t* payload);
+// Reads a reply; false if it is too short.
+bool decode_command_reply(const uint8_t* payload, size_t len, CommandReply& r);
+
+} // namespace tsstand
@@ -0,0 +1,68 @@
+// This file is part of the code for the SEDS test stand.
+#include "decimate_ref.hpp"
+
+#include <cmath>
+
+extern "C" {
+#include "decimate_taps.h"
+}
+
+namespace tsstand {
+
+DecimateRef::DecimateRef()
+{
+    // boxcar of length R convolved with itself N times
+    cic_ = {1};
+    for (unsigned n = 0; n < DECIMATE_CIC_ORDER; n++) {
+        std::vector<int64_t> next(cic_.size() + DECIMATE_CIC_RATIO - 1, 0);
+        for (size_t i = 0; i < cic_.size(); i++)
+            for (unsigned r = 0; r < DECIMATE_CIC_RATIO; r++)
+                next[i + r] += cic_[i];
+        cic_.swap(next);
+    }
+    fir_ = DECIMATE_FIR_COEFFS;
+}
+
+std::vector<int32_t> DecimateRef::run(const std::vector<int32_t>& x) const
+{
+    std::vector<int32_t> cic_out;
+    for (size_t j = DECIMATE_CIC_RATIO - 1; j < x.size(); j += DECIMATE_CIC_RATIO) {
+        int64_t acc = 0;
+        for (size_t m = 0; m < cic_.size() && m <= j; m++)
+            acc += cic_[m] * x[j - m];
+        cic_out.push_back(static_cast<int32_t>(
+            (static_cast<int64_t>(static_cast<int32_t>(acc)) * DECIMATE_CIC_RECIP) >>
+            DECIMATE_CIC_SHIFT));
+    }
+
+    std::vector<int32_t> out;
+    const int shift = 15 + 4;
+    for (size_t j = DECIMATE_FIR_RATIO - 1; j < cic_out.size(); j += DECIMATE_FIR_RATIO) {
+        int64_t acc = 0;
+        for (size_t m = 0; m < fir_.size() && m <= j; m++)
+            acc += static_cast<int64_t>(fir_[fir_.size() - 1 - m]) * cic_out[j - m];
+        out.push_back(static_cast<int32_t>((acc + (int64_t{1} << (shift - 1))) >> shift));
+    }
+    return out;
+}
+
+double DecimateRef::response(double f, double fs) const
+{
+    double cic_re = 0, cic_im = 0, cic_sum = 0;
+    for (size_t m = 0; m < cic_.size(); m++) {
+        double w = 2 * M_PI * f * m / fs;
+        cic_re += cic_[m] * std::cos(w);
+        cic_im -= cic_[m] * std::sin(w);
+        cic_sum += cic_[m];
+    }
+    double fs1 = fs / DECIMATE_CIC_RATIO;
+    double fir_re = 0, fir_im = 0;
+    for (size_t m = 0; m < fir_.size(); m++) {
+        double w = 2 * M_PI * f * m / fs1;
+        fir_re += fir_[m] * std::cos(w);
+        fir_im -= fir_[m] * std::sin(w);
+    }
+    return std::hypot(cic_re, cic_im) / cic_sum * std::hypot(fir_re, fir_im) / 32768.0;
+}
+
+} // namespace tsstand
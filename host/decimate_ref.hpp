@@ -0,0 +1,31 @@
+// Straightforward reference for the firmware decimation chain in
+// decimate.c: the CIC is evaluated as a direct convolution with its
+// integer impulse response instead of integrators and combs, the FIR as a
+// plain dot product. Both use the same fixed point scaling, so the output
+// must match the firmware bit for bit.
+// This file is part of the code for the SEDS test stand.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace tsstand {
+
+class DecimateRef {
+public:
+    DecimateRef();
+
+    // Filters a whole signal, returning one output per decimate_Push
+    // call that would have produced one.
+    std::vector<int32_t> run(const std::vector<int32_t>& x) const;
+
+    // Gain of the whole chain at f Hz for an input rate of fs Hz, from the
+    // same integer coefficients.
+    double response(double f, double fs) const;
+
+private:
+    std::vector<int64_t> cic_; // impulse response of the CIC, integer weights
+    std::vector<int32_t> fir_;
+};
+
+} // namespace tsstand
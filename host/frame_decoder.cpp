@@ -0,0 +1,174 @@
+// This file is part of the code for the SEDS test stand.
+#include "frame_decoder.hpp"
+
+#include "packed.hpp"
+
+#include <cstring>
+
+namespace tsstand {
+
+size_t encode_frame(uint8_t type, uint16_t seq, const uint8_t* payload, uint8_t len, uint8_t* out)
+{
+    frame_t f;
+    frame_Begin(&f, type);
+    std::memcpy(f.buf + f.size, payload, len);
+    f.size = static_cast<uint16_t>(f.size + len);
+    frame_FinishSeq(&f, seq);
+    std::memcpy(out, f.buf, f.size);
+    return f.size;
+}
+
+void FrameDecoder::accept(const uint8_t* frame)
+{
+    if (frame_Type(frame) & FRAME_RESENT)
+        stats_.resent++;
+    else
+        check_seq(frame_Seq(frame), frame_Type(frame));
+    stats_.frames++;
+}
+
+void FrameDecoder::check_seq(uint16_t seq, uint8_t type)
+{
+    uint16_t gap = static_cast<uint16_t>(seq - next_seq_);
+    if (have_seq_ && gap >= 0x8000) {
+        uint16_t back = static_cast<uint16_t>(-gap);
+        if (type != kFrameTypeHello && back <= kSeqRestart) {
+            stats_.seq_behind++; // the newest seq still stands
+            return;
+        }
+    } else if (have_seq_ && gap != 0) {
+        stats_.seq_gaps++;
+        stats_.frames_lost += gap;
+    }
+    have_seq_ = true;
+    next_seq_ = static_cast<uint16_t>(seq + 1);
+}
+
+bool FrameDecoder::push(uint8_t b)
+{
+    switch (have_) {
+    case 0:
+        if (b != kFrameSync0) {
+            stats_.bytes_skipped++;
+            return false;
+        }
+        break;
+    case 1:
+        if (b != kFrameSync1) {
+            stats_.bytes_skipped++;
+            have_ = (b == kFrameSync0) ? 1 : 0;
+            stats_.bytes_skipped += (have_ == 0);
+            return false;
+        }
+        break;
+    default:
+        break;
+    }
+    buf_[have_++] = b;
+    if (have_ == kFrameHeaderSize)
+        need_ = kFrameHeaderSize + buf_[5] + kFrameCrcSize;
+    if (have_ < kFrameHeaderSize || have_ < need_)
+        return false;
+
+    if (!crc_ok(buf_, need_)) {
+        // Resync from the byte after the bogus sync word: everything past it
+        // goes back in front of whatever was still waiting to be rescanned.
+        stats_.crc_errors++;
+        stats_.bytes_skipped += 2;
+        size_t rest = replay_len_ - replay_pos_;
+        uint8_t tmp[kFrameMaxSize];
+        std::memcpy(tmp, buf_ + 2, have_ - 2);
+        std::memcpy(tmp + have_ - 2, replay_ + replay_pos_, rest);
+        replay_len_ = have_ - 2 + rest;
+        replay_pos_ = 0;
+        std::memcpy(replay_, tmp, replay_len_);
+        have_ = 0;
+        return false;
+    }
+    accept(buf_);
+    have_ = 0;
+    return true;
+}
+
+int64_t SampleStream::unwrap(uint32_t t)
+{
+    if (!have_t_) {
+        have_t_ = true;
+        last_t_ = t;
+        return last_t_;
+    }
+    last_t_ += static_cast<int32_t>(t - static_cast<uint32_t>(last_t_));
+    return last_t_;
+}
+
+size_t SampleStream::decode(const Frame& f, Sample* out)
+{
+    const uint8_t* p = f.payload;
+    if (f.type == kFrameTypeHello && f.len >= 6) {
+        version_ = p[0];
+        hello_flags_ = p[1];
+        tick_hz_ = frame_Get32(p + 2);
+        if (f.len >= 8)
+            board_id_ = frame_Get16(p + 6);
+        return 0;
+    }
+    if (refused())
+        return 0;
+    if (f.resent) {
+        if (f.type == kFrameTypeRate)
+            return 0;
+        int64_t last = last_t_;
+        Frame first = f;
+        first.resent = false;
+        size_t n = decode(first, out);
+        last_t_ = last;
+        return n;
+    }
+    if (f.type == kFrameTypeRate && f.len >= FRAME_RATE_SIZE) {
+        RateChange r;
+        r.t = have_t_ ? board_time(frame_Get32(p)) : frame_Get32(p);
+        r.period = frame_Get32(p + 4) / 256.0;
+        r.averaged = frame_Get16(p + 8);
+        r.idle = p[10] & FRAME_RATE_IDLE;
+        if (r.period == rate_.period && r.idle == rate_.idle)
+            return 0; // a repeat; the spacing held from the earlier one's t
+        if (rate_.period != 0)
+            rate_changes_++;
+        rate_ = r;
+        return 0;
+    }
+    if (f.type == kFrameTypePacked) {
+        uint32_t t[kMaxSamplesPerFrame];
+        int32_t value[kMaxSamplesPerFrame];
+        size_t n = unpack_samples(p, f.len, t, value);
+        for (size_t i = 0; i < n; i++) {
+            out[i].t = unwrap(t[i]);
+            out[i].value = value[i];
+            out[i].channel = 0;
+        }
+        return n;
+    }
+    size_t head = 4; // t0, and the input for channel frames
+    uint8_t channel = 0;
+    if (f.type == kFrameTypeChannel && f.len >= 5) {
+        channel = p[4];
+        head = 5;
+    } else if (f.type != kFrameTypeSamples || f.len < 4) {
+        return 0;
+    }
+
+    int64_t t = unwrap(frame_Get32(p));
+    size_t n = (f.len - head) / kSampleRecordSize;
+    p += head;
+    for (size_t i = 0; i < n; i++, p += kSampleRecordSize) {
+        uint16_t dt;
+        out[i].value = frame_Record(p, &dt);
+        t += dt;
+        out[i].t = t;
+        out[i].channel = channel;
+    }
+    last_t_ = t;
+    return n;
+}
+
+} // namespace tsstand
@@ -0,0 +1,222 @@
+// Incremental decoder for the binary frames the boards send. The format,
+// CRC and constants are those of protocol/tsframe.h, which the firmware
+// builds too; this adds a decoder that works on whole reads.
+// This file is part of the code for the SEDS test stand.
+#pragma once
+
+#include "tsframe.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace tsstand {
+
+constexpr uint8_t kFrameVersion = FRAME_VERSION;
+constexpr uint8_t kFrameSync0 = FRAME_SYNC0;
+constexpr uint8_t kFrameSync1 = FRAME_SYNC1;
+constexpr size_t kFrameHeaderSize = FRAME_HEADER_SIZE;
+constexpr size_t kFrameCrcSize = FRAME_CRC_SIZE;
+constexpr size_t kFrameMaxSize = kFrameHeaderSize + 255 + kFrameCrcSize;
+
+constexpr uint8_t kFrameTypeHello = FRAME_TYPE_HELLO;
+constexpr uint8_t kFrameTypeSamples = FRAME_TYPE_SAMPLES;
+constexpr uint8_t kFrameTypeBurst = FRAME_TYPE_BURST;
+constexpr uint8_t kFrameTypeTelemetry = FRAME_TYPE_TELEMETRY;
+constexpr uint8_t kFrameTypeChannel = FRAME_TYPE_CHANNEL;
+constexpr uint8_t kFrameTypeSync = FRAME_TYPE_SYNC;
+constexpr uint8_t kFrameTypeCal = FRAME_TYPE_CAL;
+constexpr uint8_t kFrameTypeCommand = FRAME_TYPE_COMMAND;
+constexpr uint8_t kFrameTypePacked = FRAME_TYPE_PACKED;
+constexpr uint8_t kFrameTypeRate = FRAME_TYPE_RATE;
+constexpr uint8_t kFrameTypeNack = FRAME_TYPE_NACK;
+constexpr uint8_t kHelloNewtons = FRAME_HELLO_NEWTONS; // hello flags: load cell readings are mN
+constexpr size_t kSampleRecordSize = FRAME_SAMPLE_RECORD_SIZE;
+
+// Builds a frame for the board, the inverse of FrameDecoder. out needs room
+// for kFrameHeaderSize + len + kFrameCrcSize bytes; returns that size.
+size_t encode_frame(uint8_t type, uint16_t seq, const uint8_t* payload, uint8_t len, uint8_t* out);
+
+// A seq this far behind the newest, or any seq behind it on a hello, means
+// the board started over; a frame less far behind came late or twice.
+constexpr uint16_t kSeqRestart = 0x1000;
+
+struct Frame {
+    uint8_t type;
+    uint16_t seq;
+    const uint8_t* payload;
+    uint8_t len;
+    bool resent = false; // sent again on request (FRAME_RESENT), type without the flag
+};
+
+struct DecoderStats {
+    uint64_t frames = 0;
+    uint64_t crc_errors = 0;
+    uint64_t seq_gaps = 0;      // number of discontinuities seen
+    uint64_t frames_lost = 0;   // frames missing according to seq
+    uint64_t bytes_skipped = 0; // bytes thrown away while hunting for sync
+    uint64_t resent = 0;        // frames sent again on request, outside the seq count
+    uint64_t seq_behind = 0;    // frames behind the newest seq, late or twice
+};
+
+// Splits a byte stream into CRC-checked frames. Bytes may arrive in chunks
+// of any size; partial frames are carried over to the next feed().
+//
+// Frames that lie wholly inside the chunk being fed are checked and handed
+// to the handler in place, pointing into the caller's buffer, so in steady
+// state nothing is copied. Only a frame split across two reads goes through
+// the byte-at-a-time path and the internal buffer. Frame::payload is valid
+// only during the handler call.
+class FrameDecoder {
+public:
+    template <class Handler>
+    void feed(const uint8_t* data, size_t n, Handler&& on_frame)
+    {
+        size_t i = 0;
+        while (i < n) {
+            if (have_ == 0 && replay_pos_ == replay_len_) {
+                size_t used = scan(data + i, n - i, on_frame);
+                i += used;
+                if (i == n)
+                    break;
+            }
+            if (push(data[i++]))
+                emit(buf_, on_frame);
+            // Bytes handed back by a CRC failure are rescanned before any
+            // new input, since a real frame may hide behind a bad header.
+            while (replay_pos_ < replay_len_) {
+                if (push(replay_[replay_pos_++]))
+                    emit(buf_, on_frame);
+            }
+        }
+    }
+
+    const DecoderStats& stats() const { return stats_; }
+
+private:
+    // Fast path over contiguous input. Returns how many bytes it consumed;
+    // it stops at the first frame that is not complete in data.
+    template <class Handler>
+    size_t scan(const uint8_t* data, size_t n, Handler& on_frame)
+    {
+        size_t i = 0;
+        for (;;) {
+            const void* hit = std::memchr(data + i, kFrameSync0, n - i);
+            if (!hit) {
+                stats_.bytes_skipped += n - i;
+                return n;
+            }
+            size_t at = static_cast<size_t>(static_cast<const uint8_t*>(hit) - data);
+            stats_.bytes_skipped += at - i;
+            i = at;
+            if (n - i < kFrameHeaderSize)
+                return i;
+            if (data[i + 1] != kFrameSync1) {
+                stats_.bytes_skipped++;
+                i++;
+                continue;
+            }
+            size_t size = kFrameHeaderSize + data[i + 5] + kFrameCrcSize;
+            if (n - i < size)
+                return i;
+            if (!crc_ok(data + i, size)) {
+                stats_.crc_errors++;
+                stats_.bytes_skipped += 2;
+                i += 2;
+                continue;
+            }
+            accept(data + i);
+            emit(data + i, on_frame);
+            i += size;
+        }
+    }
+
+    template <class Handler>
+    void emit(const uint8_t* frame, Handler& on_frame)
+    {
+        uint8_t type = frame_Type(frame);
+        Frame f{static_cast<uint8_t>(type & ~FRAME_RESENT), frame_Seq(frame), frame_Payload(frame),
+                frame_Len(frame), (type & FRAME_RESENT) != 0};
+        on_frame(f);
+    }
+
+    static bool crc_ok(const uint8_t* frame, size_t size)
+    {
+        return frame_CrcOk(frame, static_cast<uint16_t>(size));
+    }
+    void accept(const uint8_t* frame);
+    bool push(uint8_t b);
+    void check_seq(uint16_t seq, uint8_t type);
+
+    uint8_t buf_[kFrameMaxSize];
+    uint8_t replay_[kFrameMaxSize];
+    size_t replay_pos_ = 0;
+    size_t replay_len_ = 0;
+    size_t have_ = 0;
+    size_t need_ = 0;
+    bool have_seq_ = false;
+    uint16_t next_seq_ = 0;
+    DecoderStats stats_;
+};
+
+struct Sample {
+    int64_t t;           // timebase ticks, unwrapped
+    int32_t value;       // raw ADC counts, or mN if the hello said so
+    uint8_t channel = 0; // board input; 0, the load cell, on a single input board
+};
+
+// The spacing of a board's samples, from a rate frame. A board that drops
+// to a low rate while idle sends one at each change (activity.h).
+struct RateChange {
+    int64_t t = 0;         // ticks, unwrapped; the new spacing holds from here
+    double period = 0;     // ticks per sample; 0 until a rate frame
+    uint16_t averaged = 0; // filtered samples in each one
+    bool idle = false;
+};
+
+// Turns frames into timestamped samples.
+class SampleStream {
+public:
+    // Returns the number of samples written to out (at most
+    // kMaxSamplesPerFrame). Non-sample frames return 0. Sample and channel
+    // frames interleave on a multiplexed board, each with its own t0.
+    // Packed frames (tspack.h) give the same samples as sample frames. A
+    // frame sent again decodes as it would have the first time, without
+    // moving the time base back; its rate frames are not news.
+    size_t decode(const Frame& f, Sample* out);
+
+    static constexpr size_t kMaxSamplesPerFrame = 255; // a packed frame's most
+
+    // Unwraps a 32-bit board time taken near the samples decoded so far.
+    int64_t board_time(uint32_t t) const
+    {
+        return last_t_ + static_cast<int32_t>(t - static_cast<uint32_t>(last_t_));
+    }
+
+    uint32_t tick_hz() const { return tick_hz_; }
+    uint8_t version() const { return version_; }
+    // The board's hello named a protocol version newer than this tool's;
+    // its sample frames are refused (decode returns 0) rather than misread.
+    bool refused() const { return version_ > kFrameVersion; }
+    // the board sends its load cell in milli-newtons (calstore.h)
+    bool newtons() const { return hello_flags_ & kHelloNewtons; }
+    uint16_t board_id() const { return board_id_; } // 0 from older firmware
+    // The spacing in force, and how many times it changed; a rate frame
+    // repeated with the hello is not a change.
+    const RateChange& rate() const { return rate_; }
+    uint64_t rate_changes() const { return rate_changes_; }
+
+private:
+    int64_t unwrap(uint32_t t);
+
+    uint32_t tick_hz_ = 1000000; // until a hello says otherwise
+    uint8_t version_ = 0;
+    uint8_t hello_flags_ = 0;
+    uint16_t board_id_ = 0;
+    bool have_t_ = false;
+    int64_t last_t_ = 0;
+    RateChange rate_;
+    uint64_t rate_changes_ = 0;
+};
+
+} // namespace tsstand
@@ -0,0 +1,318 @@
+// Runs the firmware's acquisition loop (acquire.c) on the simulated board
+// in hal_sim.hpp and reports how it keeps up: conversions lost because the
+// loop fell behind, frames that did not fit in the transmit ring, how busy
+// the UART was, and what each block of conversions cost. The firmware's own
+// profile (profile.h), read back from the telemetry frames it sent, follows.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: fwsim [-b baud] [-x slowdown] [-s seconds] [-B burn_start_s]
+//              [-S sync_period_s] [-i raw.txt] [-o uart.bin]
+//              [-c record.cal [-u]] [-e eeprom.bin] [-X setting=value]...
+//              [-L byte_error_rate] [-R]
+//
+// -i feeds raw ADC counts, one per line, instead of the synthetic burn.
+// -o saves what the UART sent, for tsdecode. -x 0 makes the firmware's
+// own code free, to see what the ADC and the link alone allow. Every -S
+// seconds (0 for never) the host side sends a sync request the way tsacq
+// does, and the report says how many were answered and how far the board
+// time in the replies was from when the request really came in.
+//
+// -c stores a calibration record's gain and offset on the board a second
+// in, as tscal -l does (-u: and has it send milli-newtons), and prints the
+// reply. -e loads the board's EEPROM from a file and saves it back after.
+// Each -X is sent as tsctl would, 50 ms apart from two seconds in, and the
+// replies are printed, so a change of rate or format shows in -o's capture.
+// Each change between the idle and the full rate (activity.h) is listed.
+// -L corrupts that fraction of the bytes on their way to the host, and -R
+// has the host ask for the frames it missed as tsacq does (repeat.hpp);
+// the report counts the samples that made it either way.
+#include "calibration.hpp"
+#include "command.hpp"
+#include "hal_sim.hpp"
+#include "repeat.hpp"
+#include "telemetry.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "acquire.h"
+#include "uart_tx.h"
+}
+
+using namespace tsstand;
+
+namespace {
+
+double thread_cpu_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+void usage()
+{
+    std::fprintf(stderr, "usage: fwsim [-b baud] [-x slowdown] [-s seconds] [-B burn_start_s]\n"
+                         "             [-S sync_period_s] [-i raw.txt] [-o uart.bin]\n"
+                         "             [-c record.cal [-u]] [-e eeprom.bin] [-X setting=value]...\n"
+                         "             [-L byte_error_rate] [-R]\n");
+    std::exit(2);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    SimConfig cfg;
+    double seconds = 10;
+    double sync_period = 0.25;
+    const char* cal_file = nullptr;
+    const char* eeprom_file = nullptr;
+    bool newtons = false;
+    bool repeating = false;
+    std::vector<std::vector<uint8_t>> commands; // frames
+    int opt;
+    while ((opt = getopt(argc, argv, "b:x:s:B:S:i:o:c:ue:X:L:R")) != -1) {
+        switch (opt) {
+        case 'b': cfg.baud = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'x': cfg.slowdown = std::atof(optarg); break;
+        case 's': seconds = std::atof(optarg); break;
+        case 'B': cfg.burn_start = std::atof(optarg); break;
+        case 'S': sync_period = std::atof(optarg); break;
+        case 'i': {
+            FILE* in = std::fopen(optarg, "r");
+            if (!in) {
+                std::perror(optarg);
+                return 1;
+            }
+            long v;
+            while (std::fscanf(in, "%ld", &v) == 1)
+                cfg.input.push_back(static_cast<int16_t>(v));
+            std::fclose(in);
+            break;
+        }
+        case 'o':
+            if (!(cfg.out = std::fopen(optarg, "wb"))) {
+                std::perror(optarg);
+                return 1;
+            }
+            break;
+        case 'c': cal_file = optarg; break;
+        case 'u': newtons = true; break;
+        case 'e': eeprom_file = optarg; break;
+        case 'L': cfg.line_errors = std::atof(optarg); break;
+        case 'R': repeating = true; break;
+        case 'X': {
+            std::string arg = optarg;
+            size_t eq = arg.find('=');
+            const CommandInfo* c = find_command(arg.substr(0, eq));
+            if (!c || eq == std::string::npos) {
+                std::fprintf(stderr, "fwsim: -X %s: want setting=value (tsctl -l lists them)\n", optarg);
+                return 2;
+            }
+            int32_t value = std::atoi(arg.c_str() + eq + 1);
+            uint8_t payload[kCommandRequestSize], frame[kFrameMaxSize];
+            size_t len = encode_command(c->id, &value, payload);
+            size_t n = encode_frame(kFrameTypeCommand, 0, payload, static_cast<uint8_t>(len), frame);
+            commands.emplace_back(frame, frame + n);
+            break;
+        }
+        default: usage();
+        }
+    }
+    if (optind != argc || (newtons && !cal_file))
+        usage();
+
+    uint8_t cal_frame[kFrameMaxSize];
+    size_t cal_size = 0;
+    if (cal_file) {
+        try {
+            uint8_t payload[kBoardCalRequestSize];
+            size_t len = encode_board_calibration(to_board(load_calibration(cal_file), newtons), payload);
+            cal_size = encode_frame(kFrameTypeCal, 0, payload, static_cast<uint8_t>(len), cal_frame);
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "fwsim: %s\n", e.what());
+            return 1;
+        }
+    }
+    if (eeprom_file) {
+        if (FILE* in = std::fopen(eeprom_file, "rb")) {
+            cfg.eeprom.resize(SimBoard::kEepromSize);
+            cfg.eeprom.resize(std::fread(cfg.eeprom.data(), 1, SimBoard::kEepromSize, in));
+            std::fclose(in);
+        }
+    }
+
+    FrameDecoder decoder;
+    Telemetry telemetry;
+    std::vector<uint8_t> sent;
+    cfg.tap = [&](uint8_t b) { sent.push_back(b); };
+
+    // sync requests: when each one's first byte reached the board's FIFO, in
+    // ticks, and what the replies made of it
+    std::vector<double> arrived;
+    uint64_t replies = 0;
+    double error_sum = 0, error_max = 0;
+    BoardCalibration cal_reply;
+    bool cal_replied = false;
+    std::vector<CommandReply> command_replies;
+    SampleStream stream;
+    Sample scratch[SampleStream::kMaxSamplesPerFrame];
+    std::vector<RateChange> rates;
+    SelectiveRepeat repeat;
+    uint64_t samples = 0;
+    SimBoard& board = sim_board();
+    auto host_ns = [&] { return static_cast<int64_t>(board.seconds() * 1e9); };
+    auto on_frame = [&](const Frame& f) {
+        CommandReply reply;
+        if (repeating && !repeat.seen(f, host_ns()))
+            return;
+        if (f.type == kFrameTypeCommand) {
+            if (decode_command_reply(f.payload, f.len, reply))
+                command_replies.push_back(reply);
+            return;
+        }
+        if (f.type == kFrameTypeCal) {
+            cal_replied = decode_board_calibration(f.payload, f.len, cal_reply);
+            return;
+        }
+        if (f.type != kFrameTypeSync) {
+            size_t n = telemetry.add(f) ? 0 : stream.decode(f, scratch);
+            samples += n;
+            if (n == 0 && f.type == kFrameTypeRate && rates.size() != stream.rate_changes() + 1)
+                rates.push_back(stream.rate());
+            return;
+        }
+        uint32_t token = 0, us = 0;
+        for (int i = 0; i < 4; i++) {
+            token |= static_cast<uint32_t>(f.payload[i]) << (8 * i);
+            us |= static_cast<uint32_t>(f.payload[4 + i]) << (8 * i);
+        }
+        if (f.len < 8 || token >= arrived.size())
+            return;
+        double error = us - arrived[token] * 1e6 / HAL_TICK_HZ;
+        replies++;
+        error_sum += error;
+        error_max = std::max(error_max, std::fabs(error));
+    };
+
+    board.configure(cfg);
+    acquire_Start();
+
+    uint64_t handled = 0;
+    double block_us = 0, block_max_us = 0;
+    double next_sync = sync_period;
+    size_t next_command = 0;
+    while (board.seconds() < seconds && !board.input_done()) {
+        if (sync_period > 0 && board.seconds() >= next_sync) {
+            uint8_t payload[4], frame[kFrameMaxSize];
+            uint32_t token = static_cast<uint32_t>(arrived.size());
+            for (int i = 0; i < 4; i++)
+                payload[i] = static_cast<uint8_t>(token >> (8 * i));
+            size_t n = encode_frame(kFrameTypeSync, static_cast<uint16_t>(token), payload, 4, frame);
+            arrived.push_back(board.uart_receive(next_sync * HAL_TICK_HZ, frame, n));
+            next_sync += sync_period;
+        }
+        if (next_command < commands.size() && board.seconds() >= 2 + 0.05 * next_command) {
+            board.uart_receive(board.ticks(), commands[next_command].data(), commands[next_command].size());
+            next_command++;
+        }
+        if (cal_size && board.seconds() >= 1) {
+            board.uart_receive(board.ticks(), cal_frame, cal_size);
+            cal_size = 0;
+        }
+        double t0 = thread_cpu_us();
+        if (acquire_Poll()) {
+            double us = thread_cpu_us() - t0;
+            handled++;
+            block_us += us;
+            block_max_us = std::max(block_max_us, us);
+        }
+        if (sent.size() >= 512) {
+            decoder.feed(sent.data(), sent.size(), on_frame);
+            sent.clear();
+            if (repeating) {
+                repeat.poll(host_ns(), [&](const uint8_t* payload, uint8_t len) {
+                    uint8_t frame[kFrameMaxSize];
+                    size_t n = encode_frame(kFrameTypeNack, 0, payload, len, frame);
+                    board.uart_receive(board.ticks(), frame, n);
+                });
+            }
+        }
+    }
+    decoder.feed(sent.data(), sent.size(), on_frame);
+
+    const SimStats& s = board.stats();
+    double sim_s = board.seconds();
+    double block_period_us = 1e6 * HAL_BLOCK_SIZE / HAL_ADC_HZ;
+    double mean_us = handled ? block_us / handled : 0;
+    std::printf("%.2f s simulated at %u baud, slowdown %g\n", sim_s, cfg.baud, cfg.slowdown);
+    std::printf("conversions   %" PRIu64 ", %" PRIu64 " lost to overrun (%.3f%%)\n", s.conversions,
+                s.overruns, s.conversions ? 100.0 * s.overruns / s.conversions : 0.0);
+    std::printf("blocks        %" PRIu64 ", host %.2f us mean %.2f us max, target ~%.0f us mean of %.0f us"
+                " (%.1f%% busy)\n",
+                handled, mean_us, block_max_us, mean_us * cfg.slowdown, block_period_us,
+                100.0 * mean_us * cfg.slowdown / block_period_us);
+    std::printf("uart          %" PRIu64 " bytes, line %.1f%% busy\n", s.uart_bytes,
+                sim_s > 0 ? 100.0 * s.uart_bytes * 10 / cfg.baud / sim_s : 0.0);
+    std::printf("tx ring       %" PRIu32 " writes rejected, %" PRIu32 " bytes dropped\n",
+                static_cast<uint32_t>(uart_tx_overflowCount), static_cast<uint32_t>(uart_tx_droppedBytes));
+    const DecoderStats& d = decoder.stats();
+    std::printf("host          %" PRIu64 " samples, %" PRIu64 " frames lost in %" PRIu64 " gaps, %" PRIu64
+                " crc errors from %" PRIu64 " bytes corrupted\n",
+                samples, d.frames_lost, d.seq_gaps, d.crc_errors, s.line_errors);
+    if (repeating) {
+        const RepeatStats& r = repeat.stats();
+        std::printf("repeat        %" PRIu64 " requests, %" PRIu64 " frames sent again in time, %" PRIu64
+                    " gone from the board, %" PRIu64 " too late or twice, %zu still missing\n",
+                    r.requests, r.recovered, r.gone, r.late + r.expired, repeat.missing());
+    }
+    if (!arrived.empty()) {
+        std::printf("sync          %" PRIu64 " of %zu requests answered, %" PRIu64 " rx bytes lost to overrun,"
+                    " board time %.1f us late on average, %.1f us at worst\n",
+                    replies, arrived.size(), s.rx_overruns, replies ? error_sum / replies : 0.0, error_max);
+    }
+    if (cal_file) {
+        Calibration cal = from_board(cal_reply);
+        if (cal_replied)
+            std::printf("calibration   board %u seq %u status %u, %.9g N per count, zero at %.0f counts, %s,"
+                        " %" PRIu64 " eeprom rows written\n",
+                        cal_reply.board_id, cal_reply.seq, cal_reply.status, cal.gain, cal.offset,
+                        cal_reply.flags & kBoardNewtons ? "milli-newtons" : "counts", s.eeprom_rows);
+        else
+            std::printf("calibration   no reply\n");
+    }
+    for (const CommandReply& r : command_replies) {
+        const CommandInfo* c = find_command(std::to_string(r.id));
+        std::printf("command       %s %d, %s\n", c ? command_name(*c).c_str() : "?", r.value,
+                    command_status(r.status));
+    }
+    if (!commands.empty())
+        std::printf("adc restarts  %" PRIu64 "\n", s.adc_restarts);
+    for (const RateChange& r : rates) {
+        std::printf("rate          %s from %.3f s, a sample every %.3f ms\n", r.idle ? "idle" : "full",
+                    static_cast<double>(r.t) / stream.tick_hz(), 1e3 * r.period / stream.tick_hz());
+    }
+    if (eeprom_file) {
+        FILE* out = std::fopen(eeprom_file, "wb");
+        if (!out || std::fwrite(board.eeprom().data(), 1, SimBoard::kEepromSize, out) != SimBoard::kEepromSize) {
+            std::perror(eeprom_file);
+            return 1;
+        }
+        std::fclose(out);
+    }
+    if (telemetry.reports)
+        telemetry.print(stdout);
+    if (cfg.out)
+        std::fclose(cfg.out);
+    return 0;
+}
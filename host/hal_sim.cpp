@@ -0,0 +1,279 @@
+// This file is part of the code for the SEDS test stand.
+#include "hal_sim.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <time.h>
+
+namespace tsstand {
+
+namespace {
+
+double thread_cpu_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) * 1e9 + ts.tv_nsec;
+}
+
+} // namespace
+
+SimBoard& sim_board()
+{
+    static SimBoard board;
+    return board;
+}
+
+void SimBoard::configure(const SimConfig& config)
+{
+    cfg_ = config;
+    eeprom_.fill(0);
+    std::copy_n(cfg_.eeprom.begin(), std::min(cfg_.eeprom.size(), eeprom_.size()), eeprom_.begin());
+    period_ = static_cast<double>(HAL_TICK_HZ) / HAL_ADC_HZ;
+    byte_ticks_ = 10.0 * HAL_TICK_HZ / cfg_.baud;
+}
+
+void SimBoard::start()
+{
+    now_ = 0;
+    next_conv_ = period_;
+    line_free_ = 0;
+    rx_free_ = 0;
+    rx_line_.clear();
+    rx_fifo_.clear();
+    resume();
+}
+
+// Charges the CPU time the firmware used since the last hal call to the
+// board's clock and catches the ADC up with it.
+void SimBoard::advance()
+{
+    double cpu = thread_cpu_ns();
+    now_ += (cpu - cpu_) * cfg_.slowdown * (HAL_TICK_HZ / 1e9);
+    while (next_conv_ <= now_ && !input_done_) {
+        convert(next_conv_);
+        next_conv_ += period_;
+    }
+    while (!rx_line_.empty() && rx_line_.front().at <= now_) {
+        if (rx_fifo_.size() < kRxFifo) {
+            rx_fifo_.push_back(rx_line_.front().b);
+            stats_.rx_bytes++;
+        } else {
+            stats_.rx_overruns++;
+        }
+        rx_line_.pop_front();
+    }
+}
+
+// Called on the way out of every hal call, so the simulator's own work is
+// not charged to the firmware.
+void SimBoard::resume()
+{
+    cpu_ = thread_cpu_ns();
+}
+
+// What each input reads during a 2 s burn, in raw 16 bit counts: the load
+// cell, chamber pressure following the thrust, and a case temperature that
+// keeps climbing after the burn.
+double SimBoard::signal(double t, unsigned input)
+{
+    double b = t / HAL_TICK_HZ - cfg_.burn_start;
+    double thrust = (b > 0 && b < 2.0) ? (1 - std::exp(-b / 0.03)) * (1.0 - 0.35 * b) : 0.0;
+    switch (input) {
+    case 0: return 1000.0 + 20000.0 * thrust;
+    case 1: return 500.0 + 15000.0 * thrust;
+    default: return 2000.0 + (b > 0 ? 3000.0 * (1 - std::exp(-b / 1.5)) : 0.0);
+    }
+}
+
+int16_t SimBoard::next_value(double t)
+{
+    if (!cfg_.input.empty()) {
+        if (in_pos_ + 1 >= cfg_.input.size())
+            input_done_ = true;
+        return cfg_.input[std::min(in_pos_++, cfg_.input.size() - 1)];
+    }
+    double v = signal(t, input_);
+    if (dwell_ < HAL_SETTLE && HAL_CHANNELS > 1) {
+        // the decimator still holds some of the previous input
+        unsigned prev = (input_ + HAL_CHANNELS - 1) % HAL_CHANNELS;
+        double w = (dwell_ + 1.0) / (HAL_SETTLE + 1.0);
+        v = w * v + (1 - w) * signal(t, prev);
+    }
+    v += noise_(rng_);
+    return static_cast<int16_t>(std::fmax(-32768.0, std::fmin(32767.0, v)));
+}
+
+// what adc_ISR1_EntryCallback in capture.c does for one conversion
+void SimBoard::convert(double t)
+{
+    int16_t v = next_value(t);
+    if (adc_config_ == 2)
+        v = static_cast<int16_t>(v & ~15);
+    uint8_t tag = 0;
+    if (HAL_CHANNELS > 1) {
+        tag = dwell_ < HAL_SETTLE ? HAL_SETTLING : static_cast<uint8_t>(input_);
+        if (++dwell_ == HAL_SETTLE + HAL_DWELL) {
+            dwell_ = 0;
+            input_ = (input_ + 1) % HAL_CHANNELS;
+        }
+    }
+    stats_.conversions++;
+    if (full_[fill_]) {
+        stats_.overruns++;
+        return;
+    }
+    tags_[fill_][pos_] = tag;
+    times_[fill_][pos_] = static_cast<uint32_t>(static_cast<uint64_t>(t));
+    blocks_[fill_][pos_++] = v;
+    if (pos_ == HAL_BLOCK_SIZE) {
+        full_[fill_] = true;
+        fill_ ^= 1;
+        pos_ = 0;
+    }
+}
+
+uint32_t SimBoard::ticks()
+{
+    advance();
+    resume();
+    return static_cast<uint32_t>(static_cast<uint64_t>(now_));
+}
+
+const int16_t* SimBoard::get_block()
+{
+    advance();
+    if (!held_ && full_[next_]) {
+        held_ = true;
+        stats_.blocks++;
+        resume();
+        return blocks_[next_];
+    }
+    if (cfg_.slowdown == 0 && !held_ && !input_done_) {
+        // nothing for the loop to do until the block fills, a FIFO slot
+        // frees up or a byte comes in
+        double wake = next_conv_ + (HAL_BLOCK_SIZE - 1 - pos_) * period_;
+        if (uart_room() > now_)
+            wake = std::min(wake, uart_room());
+        if (!rx_line_.empty())
+            wake = std::min(wake, rx_line_.front().at);
+        now_ = std::max(now_, wake);
+        advance();
+    }
+    resume();
+    return nullptr;
+}
+
+void SimBoard::release_block()
+{
+    advance();
+    full_[next_] = false;
+    held_ = false;
+    next_ ^= 1;
+    resume();
+}
+
+// when the FIFO next has a free slot
+double SimBoard::uart_room() const
+{
+    return line_free_ - (kFifo - 1) * byte_ticks_;
+}
+
+uint8_t SimBoard::uart_ready()
+{
+    advance();
+    resume();
+    return now_ >= uart_room();
+}
+
+void SimBoard::uart_put(uint8_t b)
+{
+    line_free_ = std::max(line_free_, now_) + byte_ticks_;
+    stats_.uart_bytes++;
+    if (cfg_.line_errors > 0 && std::uniform_real_distribution<double>()(line_rng_) < cfg_.line_errors) {
+        b ^= static_cast<uint8_t>(1u << (line_rng_() & 7));
+        stats_.line_errors++;
+    }
+    if (cfg_.out)
+        std::fputc(b, cfg_.out);
+    if (cfg_.tap)
+        cfg_.tap(b);
+    resume();
+}
+
+double SimBoard::uart_receive(double at, const uint8_t* data, size_t n)
+{
+    double t = std::max({at, now_, rx_free_});
+    for (size_t i = 0; i < n; i++) {
+        t += byte_ticks_;
+        rx_line_.push_back({t, data[i]});
+    }
+    rx_free_ = t;
+    return t - (n - 1) * byte_ticks_;
+}
+
+uint8_t SimBoard::uart_rx_ready()
+{
+    advance();
+    resume();
+    return !rx_fifo_.empty();
+}
+
+uint8_t SimBoard::uart_get()
+{
+    uint8_t b = 0;
+    if (!rx_fifo_.empty()) {
+        b = rx_fifo_.front();
+        rx_fifo_.pop_front();
+    }
+    resume();
+    return b;
+}
+
+uint8_t SimBoard::eeprom_write(uint16_t row, const uint8_t* data)
+{
+    advance();
+    if ((row + 1u) * HAL_EEPROM_ROW > kEepromSize) {
+        resume();
+        return 0;
+    }
+    std::copy_n(data, HAL_EEPROM_ROW, &eeprom_[row * HAL_EEPROM_ROW]);
+    stats_.eeprom_rows++;
+    // the loop stands still while the SPC erases and programs the row
+    now_ += 0.020 * HAL_TICK_HZ;
+    advance();
+    resume();
+    return 1;
+}
+
+uint8_t SimBoard::adc_config(uint8_t config)
+{
+    if (config == 0 || config > HAL_ADC_CONFIGS)
+        return 0;
+    adc_config_ = config;
+    stats_.adc_restarts++;
+    return 1;
+}
+
+} // namespace tsstand
+
+using tsstand::sim_board;
+
+extern "C" {
+
+void hal_Start(void) { sim_board().start(); }
+uint32_t hal_Ticks(void) { return sim_board().ticks(); }
+const int16_t* hal_GetBlock(void) { return sim_board().get_block(); }
+const uint32_t* hal_GetTimes(void) { return sim_board().get_times(); }
+void hal_ReleaseBlock(void) { sim_board().release_block(); }
+const uint8_t* hal_GetChannels(void) { return HAL_CHANNELS > 1 ? sim_board().get_channels() : nullptr; }
+uint32_t hal_Overruns(void) { return static_cast<uint32_t>(sim_board().stats().overruns); }
+uint8_t hal_UartReady(void) { return sim_board().uart_ready(); }
+void hal_UartPut(uint8_t b) { sim_board().uart_put(b); }
+uint8_t hal_UartRxReady(void) { return sim_board().uart_rx_ready(); }
+uint8_t hal_UartGet(void) { return sim_board().uart_get(); }
+const uint8_t* hal_EepromRow(uint16_t row) { return sim_board().eeprom_row(row); }
+uint8_t hal_EepromWrite(uint16_t row, const uint8_t* data) { return sim_board().eeprom_write(row, data); }
+uint8_t hal_AdcConfig(uint8_t config) { return sim_board().adc_config(config); }
+
+}
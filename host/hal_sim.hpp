@@ -0,0 +1,140 @@
+// Simulated board behind the firmware's hal.h, so the acquisition loop
+// (acquire.c and the modules under it, built with -DHAL_SIM) runs on Linux.
+// This file is part of the code for the SEDS test stand.
+//
+// The board has its own clock, in timebase ticks. The ADC delivers a
+// conversion every 1/HAL_ADC_HZ seconds of it into the same pair of blocks
+// capture.c fills, losing conversions the same way when the loop falls
+// behind. The UART sends one byte per 10 bit times at the configured baud
+// from a 4 byte FIFO behind the shift register. Built with HAL_CHANNELS
+// above 1, the ADC steps through that many inputs the way capture.c steps
+// the mux, and the conversions taken while it settles mix two inputs.
+// Bytes handed to uart_receive arrive on the RX line at the baud rate into
+// a 4 byte FIFO, and a byte that finds it full is lost, as on the PSoC.
+// With line_errors set, each byte sent reaches the host with one bit
+// flipped at that chance, as on a noisy cable. The EEPROM is an array that takes 20 ms of the board's time per row
+// written, the worst case on the PSoC. ADC configuration 2 keeps 12 of the
+// 16 bits, to stand for a lower resolution one in the schematic.
+//
+// Time the firmware code spends on the host CPU (thread CPU time, so being
+// preempted does not count) moves the clock forward, multiplied by
+// `slowdown` to stand for the much slower Cortex-M3. With a slowdown of 0
+// the firmware code is free and the clock jumps straight to the next ADC
+// block or the next free FIFO slot whenever the loop is waiting.
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "hal.h"
+}
+
+namespace tsstand {
+
+struct SimConfig {
+    unsigned baud = 115200;
+    double slowdown = 40;
+    std::vector<int16_t> input; // raw conversions; empty for a synthetic burn
+    double burn_start = 5;      // s, for the synthetic signal
+    FILE* out = nullptr;        // receives every byte the UART sends
+    std::function<void(uint8_t)> tap; // and so does this, if set
+    double line_errors = 0;     // chance that a byte reaches them corrupted
+    std::vector<uint8_t> eeprom; // initial contents; the rest reads as 0
+};
+
+struct SimStats {
+    uint64_t conversions = 0; // made by the ADC
+    uint64_t overruns = 0;    // lost because both blocks were held
+    uint64_t blocks = 0;      // handed to the loop
+    uint64_t uart_bytes = 0;
+    uint64_t line_errors = 0; // bytes corrupted on the way to the host
+    uint64_t rx_bytes = 0;    // received into the RX FIFO
+    uint64_t rx_overruns = 0; // lost because it was full
+    uint64_t eeprom_rows = 0; // written
+    uint64_t adc_restarts = 0; // by hal_AdcConfig
+};
+
+class SimBoard {
+public:
+    void configure(const SimConfig& config);
+
+    double seconds() const { return now_ / HAL_TICK_HZ; }
+    bool input_done() const { return input_done_; }
+    const SimStats& stats() const { return stats_; }
+    static constexpr size_t kEepromSize = 2048;
+    const std::array<uint8_t, kEepromSize>& eeprom() const { return eeprom_; }
+
+    // Sends bytes to the board from tick `at` (or now, if that has passed),
+    // after whatever is still on the RX line. Returns the tick the first of
+    // them is in the FIFO.
+    double uart_receive(double at, const uint8_t* data, size_t n);
+
+    // hal.h, through the extern "C" wrappers in hal_sim.cpp
+    void start();
+    uint32_t ticks();
+    const int16_t* get_block();
+    const uint32_t* get_times() const { return times_[next_]; }
+    const uint8_t* get_channels() const { return tags_[next_]; }
+    void release_block();
+    uint8_t uart_ready();
+    void uart_put(uint8_t b);
+    uint8_t uart_rx_ready();
+    uint8_t uart_get();
+    const uint8_t* eeprom_row(uint16_t row) const { return &eeprom_[row * HAL_EEPROM_ROW]; }
+    uint8_t eeprom_write(uint16_t row, const uint8_t* data);
+    uint8_t adc_config(uint8_t config);
+
+private:
+    static constexpr unsigned kFifo = 5; // FIFO plus the shift register
+    static constexpr size_t kRxFifo = 4;
+
+    struct RxByte {
+        double at; // tick its stop bit ends
+        uint8_t b;
+    };
+
+    void advance();
+    void resume();
+    void convert(double t);
+    double signal(double t, unsigned input);
+    int16_t next_value(double t);
+    double uart_room() const;
+
+    SimConfig cfg_;
+    SimStats stats_;
+    double now_ = 0;        // ticks
+    double period_ = 0;     // ticks per conversion
+    double next_conv_ = 0;
+    double byte_ticks_ = 0;
+    double line_free_ = 0;  // when the last queued byte is out
+    double rx_free_ = 0;    // when the last byte on the RX line is in
+    double cpu_ = 0;        // thread CPU time at the last advance, ns
+    size_t in_pos_ = 0;
+    bool input_done_ = false;
+    std::mt19937 rng_{1};
+    std::normal_distribution<double> noise_{0.0, 40.0};
+    std::mt19937 line_rng_{2};
+
+    int16_t blocks_[2][HAL_BLOCK_SIZE];
+    uint32_t times_[2][HAL_BLOCK_SIZE];
+    uint8_t tags_[2][HAL_BLOCK_SIZE];
+    unsigned input_ = 0, dwell_ = 0; // the mux, as in capture.c
+    uint8_t adc_config_ = 1;
+    bool full_[2] = {false, false};
+    unsigned fill_ = 0, pos_ = 0, next_ = 0;
+    bool held_ = false;
+    std::deque<RxByte> rx_line_;
+    std::deque<uint8_t> rx_fifo_;
+    std::array<uint8_t, kEepromSize> eeprom_{};
+};
+
+// The board the hal_* functions talk to.
+SimBoard& sim_board();
+
+} // namespace tsstand
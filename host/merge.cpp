@@ -0,0 +1,42 @@
+// This file is part of the code for the SEDS test stand.
+#include "merge.hpp"
+
+#include <algorithm>
+
+namespace tsstand {
+
+SampleMerger::SampleMerger(size_t boards, int64_t lag_ns, int64_t timeout_ns)
+    : boards_(boards), lag_(lag_ns), timeout_(timeout_ns)
+{
+}
+
+void SampleMerger::push(size_t board, const MergedSample& s, int64_t now)
+{
+    if (start_ == INT64_MIN)
+        start_ = now;
+    Board& b = boards_[board];
+    b.newest = std::max(b.newest, s.t);
+    b.heard = now;
+    heap_.push(s);
+}
+
+int64_t SampleMerger::watermark(int64_t now) const
+{
+    int64_t mark = INT64_MAX;
+    bool any = false;
+    for (const Board& b : boards_) {
+        if (b.heard == INT64_MIN) {
+            // not heard from yet: give it a timeout's grace from the start
+            if (now - start_ < timeout_)
+                return INT64_MIN;
+            continue;
+        }
+        if (now - b.heard > timeout_)
+            continue;
+        mark = std::min(mark, b.newest);
+        any = true;
+    }
+    return any ? mark - lag_ : INT64_MAX;
+}
+
+} // namespace tsstand
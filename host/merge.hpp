@@ -0,0 +1,73 @@
+// Merges the sample streams of several boards, already put on the host's
+// clock (clock_sync.hpp), into one stream in time order.
+// This file is part of the code for the SEDS test stand.
+//
+// Samples are held until every board that is still talking has sent
+// something newer, less `lag` to allow for a board's own frames arriving a
+// little out of order (each input of a multiplexed board has its own
+// frames). A board that has been silent for `timeout` stops holding the
+// others back, so unplugging one does not stall the run.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+namespace tsstand {
+
+struct MergedSample {
+    int64_t t;      // host ns
+    int32_t value;
+    uint8_t source; // board index << 4 | board input
+};
+
+class SampleMerger {
+public:
+    SampleMerger(size_t boards, int64_t lag_ns, int64_t timeout_ns);
+
+    // now is the host time the sample's bytes arrived.
+    void push(size_t board, const MergedSample& s, int64_t now);
+
+    // Hands out, oldest first, every sample no board can still undercut.
+    template <class Out>
+    void drain(int64_t now, Out&& out)
+    {
+        int64_t mark = watermark(now);
+        while (!heap_.empty() && heap_.top().t <= mark) {
+            out(heap_.top());
+            heap_.pop();
+        }
+    }
+
+    // Everything that is left, at the end of the run.
+    template <class Out>
+    void finish(Out&& out)
+    {
+        while (!heap_.empty()) {
+            out(heap_.top());
+            heap_.pop();
+        }
+    }
+
+    size_t held() const { return heap_.size(); }
+    void set_lag(int64_t lag) { lag_ = lag; }
+
+private:
+    struct Later {
+        bool operator()(const MergedSample& a, const MergedSample& b) const { return a.t > b.t; }
+    };
+    struct Board {
+        int64_t newest = INT64_MIN; // host time of its newest sample
+        int64_t heard = INT64_MIN;  // when it last sent one
+    };
+
+    int64_t watermark(int64_t now) const;
+
+    std::vector<Board> boards_;
+    std::priority_queue<MergedSample, std::vector<MergedSample>, Later> heap_;
+    int64_t lag_, timeout_;
+    int64_t start_ = INT64_MIN; // first sample from any board
+};
+
+} // namespace tsstand
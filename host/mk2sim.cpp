@@ -0,0 +1,222 @@
+// Runs the Arduino sketch (loadCellReadoutMk2/, built with -DMK2_HOST) on
+// a simulated ATmega328P and reports whether it keeps up: conversions lost
+// because the ring was full, how busy the serial line was, and where the
+// CPU's cycles went. The ADC converts every 13 ADC clocks and calls the
+// sketch's ADC_vect; the serial port is HardwareSerial's 64 byte transmit
+// buffer drained at the baud rate, one interrupt per byte.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: mk2sim [-p prescaler] [-a average] [-b baud] [-x slowdown]
+//               [-s seconds] [-B burn_start_s] [-o serial.bin]
+//
+// The cycle costs below are estimates of what avr-gcc -Os makes of the
+// sketch, not measurements; -x scales those of the main loop, to see how
+// much slack there is. -o saves what the board sent, for tsdecode. Build
+// it and the sketch with -DMK2_PACKED=1 to run the sketch's packed frames.
+#include "frame_decoder.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "avr_mock.h"
+#include "mk2.h"
+#include "sampler.h"
+}
+
+volatile uint8_t ADMUX, ADCSRA, ADCSRB, DIDR0, SREG;
+volatile uint16_t ADC;
+
+using namespace tsstand;
+
+namespace {
+
+// CPU cycles
+constexpr double kAdcIsr = 75;      // prologue, ring push, epilogue
+constexpr double kTxIsr = 65;       // HardwareSerial's data register empty interrupt
+constexpr double kLoopPass = 45;    // loop(), serialEventRun and an idle mk2_Poll
+constexpr double kSample = 110;     // sampler_Get, averaging and frame_AddSample
+constexpr double kPackSample = 420; // pack_Add, and its share of pack_Block's choice of k
+constexpr double kFrameByte = 14;   // the crc in frame_Finish
+constexpr double kWriteByte = 28;   // Serial.write, per byte
+
+constexpr size_t kTxBuffer = 64; // SERIAL_TX_BUFFER_SIZE; one slot is kept free
+
+struct Serial {
+    double byte_cycles;
+    std::deque<uint8_t> buffer;
+    bool shifting = false;
+    double done = 0; // when the byte in the shift register is out
+    uint64_t bytes = 0;
+    std::vector<uint8_t> sent;
+};
+
+Serial* serial;
+
+struct Signal {
+    double burn_start;
+    std::mt19937 rng{1};
+    std::normal_distribution<double> noise{0, 1.5};
+
+    uint16_t at(double t)
+    {
+        // a 10 bit reading: the bridge amplifier's offset, then a 3 s burn
+        double v = 180;
+        double s = t - burn_start;
+        if (s > 0 && s < 3)
+            v += 650 * std::sin(M_PI * s / 3) * (s < 0.2 ? s / 0.2 : 1);
+        v += noise(rng);
+        return static_cast<uint16_t>(std::clamp(std::lround(v), 0L, 1023L));
+    }
+};
+
+void usage()
+{
+    std::fprintf(stderr, "usage: mk2sim [-p prescaler] [-a average] [-b baud] [-x slowdown]\n"
+                         "              [-s seconds] [-B burn_start_s] [-o serial.bin]\n");
+    std::exit(2);
+}
+
+} // namespace
+
+extern "C" uint8_t mk2_SerialRoom(void)
+{
+    return static_cast<uint8_t>(kTxBuffer - 1 - serial->buffer.size());
+}
+
+extern "C" void mk2_SerialWrite(const uint8_t* buf, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++)
+        serial->buffer.push_back(buf[i]);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned prescaler = MK2_PRESCALER, average = MK2_AVERAGE;
+    unsigned long baud = MK2_BAUD;
+    double slowdown = 1, seconds = 10, burn_start = 2;
+    FILE* out = nullptr;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:a:b:x:s:B:o:")) != -1) {
+        switch (opt) {
+        case 'p': prescaler = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'a': average = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'b': baud = std::strtoul(optarg, nullptr, 0); break;
+        case 'x': slowdown = std::atof(optarg); break;
+        case 's': seconds = std::atof(optarg); break;
+        case 'B': burn_start = std::atof(optarg); break;
+        case 'o':
+            if (!(out = std::fopen(optarg, "wb"))) {
+                std::perror(optarg);
+                return 1;
+            }
+            break;
+        default: usage();
+        }
+    }
+    if (optind != argc || prescaler < 2 || prescaler > 128 || average < 1 || average > 64 || baud == 0)
+        usage();
+
+    // the hardware's UBRR rounds the baud rate; U2X is on, as Serial.begin
+    // sets it
+    double ubrr = std::max(0L, std::lround(F_CPU / (8.0 * baud)) - 1);
+    double actual_baud = F_CPU / (8 * (ubrr + 1));
+    Serial port;
+    port.byte_cycles = 10 * F_CPU / actual_baud;
+    serial = &port;
+    Signal signal{burn_start};
+
+    mk2_Start(MK2_INPUT, static_cast<uint8_t>(prescaler), static_cast<uint8_t>(average));
+    double conv_cycles = SAMPLER_CLOCKS * static_cast<double>(1u << (ADCSRA & 7u));
+    double end = seconds * F_CPU;
+    double now = 0, next_conv = conv_cycles;
+    double adc_isr = 0, tx_isr = 0, work = 0, idle = 0;
+    uint64_t conversions = 0, samples_written = 0;
+
+    // Runs the main loop for cost cycles of its own, with the interrupts
+    // that fall due meanwhile stretching it.
+    auto run = [&](double cost) {
+        double until = now + cost;
+        for (;;) {
+            if (!port.shifting && !port.buffer.empty()) {
+                // Serial.write puts a byte straight in an idle UDR
+                port.shifting = true;
+                port.done = now + port.byte_cycles;
+                port.sent.push_back(port.buffer.front());
+                port.buffer.pop_front();
+            }
+            double next = std::min(next_conv, port.shifting ? port.done : INFINITY);
+            if (next > until)
+                break;
+            if (next == next_conv) {
+                ADC = signal.at(next_conv / F_CPU);
+                ADC_vect();
+                conversions++;
+                next_conv += conv_cycles;
+                until += kAdcIsr;
+                adc_isr += kAdcIsr;
+            } else {
+                port.shifting = false;
+                port.bytes++;
+                if (!port.buffer.empty()) {
+                    until += kTxIsr;
+                    tx_isr += kTxIsr;
+                }
+            }
+            now = std::max(now, next);
+        }
+        now = until;
+    };
+
+    while (now < end) {
+        size_t before = port.buffer.size();
+        mk2_Poll();
+        // a frame of 12 + 5 n bytes, a packed frame, or a hello, or nothing
+        size_t queued = port.buffer.size() - before;
+        double cost = kLoopPass;
+        if (queued) {
+            size_t samples = queued > 12 ? (queued - 12) / kSampleRecordSize : 0;
+            double per_sample = kSample;
+            if (port.buffer[before + 2] == kFrameTypePacked) {
+                samples = port.buffer[before + kFrameHeaderSize + 11];
+                per_sample = kPackSample;
+            }
+            samples_written += samples;
+            cost += slowdown * (samples * per_sample + queued * (kFrameByte + kWriteByte));
+            work += cost;
+        } else {
+            idle += cost;
+        }
+        run(cost);
+        if (out && port.sent.size() >= 4096) {
+            std::fwrite(port.sent.data(), 1, port.sent.size(), out);
+            port.sent.clear();
+        }
+    }
+    if (out) {
+        std::fwrite(port.sent.data(), 1, port.sent.size(), out);
+        std::fclose(out);
+    }
+
+    double total = adc_isr + tx_isr + work + idle;
+    uint32_t lost = sampler_Overruns();
+    double rate = F_CPU / conv_cycles;
+    std::printf("%.2f s simulated, prescaler %u (%.0f conversions/s), average %u, %lu baud (%.0f actual),"
+                " slowdown %g\n",
+                now / F_CPU, 1u << (ADCSRA & 7u), rate, average, baud, actual_baud, slowdown);
+    std::printf("conversions   %" PRIu64 ", %" PRIu32 " lost to overrun (%.3f%%)\n", conversions, lost,
+                conversions ? 100.0 * lost / conversions : 0.0);
+    std::printf("samples       %" PRIu64 " sent, %.0f/s\n", samples_written, samples_written * F_CPU / now);
+    std::printf("serial        %" PRIu64 " bytes, line %.1f%% busy\n", port.bytes,
+                100.0 * port.bytes * port.byte_cycles / now);
+    std::printf("cpu           adc isr %.1f%%, tx isr %.1f%%, loop %.1f%%, idle %.1f%%\n", 100 * adc_isr / total,
+                100 * tx_isr / total, 100 * work / total, 100 * idle / total);
+    return 0;
+}
@@ -0,0 +1,147 @@
+// This file is part of the code for the SEDS test stand.
+#include "packed.hpp"
+
+#include "tspack.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace tsstand {
+
+namespace {
+
+// Reads the bit stream most significant bit first, through a 64-bit window
+// refilled a byte at a time so it always holds at least 56 bits.
+class BitReader {
+public:
+    BitReader(const uint8_t* p, size_t len) : p_(p), end_(p + len) { refill(); }
+
+    uint32_t read(unsigned n)
+    {
+        if (n == 0)
+            return 0;
+        uint32_t v = static_cast<uint32_t>(window_ >> (64 - n));
+        skip(n);
+        return v;
+    }
+
+    // The number of 1s before the next 0, up to max (at most 32).
+    unsigned unary(unsigned max)
+    {
+        unsigned q = ~window_ ? static_cast<unsigned>(__builtin_clzll(~window_)) : 64;
+        if (q >= max) {
+            skip(max);
+            return max;
+        }
+        skip(q + 1);
+        return q;
+    }
+
+    // Read past the end of the payload.
+    bool overrun() const { return used_ > bits_; }
+
+private:
+    void skip(unsigned n)
+    {
+        window_ <<= n;
+        fill_ -= n;
+        used_ += n;
+        refill();
+    }
+
+    void refill()
+    {
+        // past the end the window fills with 0s; overrun() tells if they were read
+        while (fill_ <= 56) {
+            uint64_t b = p_ < end_ ? *p_++ : 0;
+            window_ |= b << (56 - fill_);
+            fill_ += 8;
+        }
+    }
+
+    const uint8_t* p_;
+    const uint8_t* end_;
+    size_t bits_ = 8 * static_cast<size_t>(end_ - p_);
+    uint64_t window_ = 0;
+    unsigned fill_ = 0;
+    size_t used_ = 0;
+};
+
+// value[i] = value[i - 1] + unzigzag(zig[i]) for i in [0, n), each kept to
+// 24 bits as the board's readings are.
+void rebuild(const uint32_t* zig, size_t n, int32_t last, int32_t* value)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    // Differences of 24-bit readings wrap the same in 32 bits, so the sums
+    // can run in 32 bits and be cut to 24 at the end.
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i carry = _mm_set1_epi32(last);
+    for (; i + 4 <= n; i += 4) {
+        __m128i z = _mm_loadu_si128(reinterpret_cast<const __m128i*>(zig + i));
+        __m128i d = _mm_xor_si128(_mm_srli_epi32(z, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z, one)));
+        d = _mm_add_epi32(d, _mm_slli_si128(d, 4));
+        d = _mm_add_epi32(d, _mm_slli_si128(d, 8));
+        __m128i v = _mm_add_epi32(d, carry);
+        carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+        // sign-extend from 24 bits
+        v = _mm_srai_epi32(_mm_slli_epi32(v, 8), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(value + i), v);
+    }
+    if (i)
+        last = value[i - 1];
+#endif
+    for (; i < n; i++) {
+        last = pack_Reading24(last + pack_Unzigzag(zig[i]));
+        value[i] = last;
+    }
+}
+
+} // namespace
+
+size_t unpack_samples(const uint8_t* payload, size_t len, uint32_t* t, int32_t* value)
+{
+    if (len < PACK_HEAD || len > 255 || payload[11] == 0)
+        return 0;
+    size_t count = payload[11];
+    uint32_t t0 = frame_Get32(payload);
+    uint32_t period = frame_Get32(payload + 4);
+    t[0] = t0;
+    value[0] = pack_Reading24(static_cast<int32_t>(payload[8] | payload[9] << 8 | payload[10] << 16));
+
+    BitReader r(payload + PACK_HEAD, len - PACK_HEAD);
+    uint32_t zig[PACK_MAX_SAMPLES];
+    uint32_t pred = 0x80;
+    size_t i = 1;
+    while (i < count) {
+        unsigned k = r.read(5);
+        size_t n = r.read(4) + 1;
+        if (k > 24 || i + n > count)
+            return 0;
+        if (r.read(1)) {
+            for (size_t j = 0; j < n; j++) {
+                int32_t late = pack_Unzigzag(r.unary(2 * PACK_JITTER + 1));
+                pred += period;
+                uint32_t rel = (pred >> 8) + static_cast<uint32_t>(late);
+                pred = pack_Lock(pred, rel, late);
+                t[i + j] = t0 + rel;
+            }
+        } else {
+            for (size_t j = 0; j < n; j++) {
+                pred += period;
+                t[i + j] = t0 + (pred >> 8);
+            }
+        }
+        for (size_t j = 0; j < n; j++, i++) {
+            unsigned q = r.unary(PACK_ESCAPE);
+            zig[i] = q < PACK_ESCAPE ? q << k | r.read(k) : r.read(PACK_RAW_BITS);
+        }
+        if (r.overrun())
+            return 0;
+    }
+    rebuild(zig + 1, count - 1, value[0], value + 1);
+    return count;
+}
+
+} // namespace tsstand
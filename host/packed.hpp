@@ -0,0 +1,17 @@
+// Decoder for packed sample frames (protocol/tspack.h), for the host's
+// rates: whole-word bit reads and, where the CPU has SSE2, the readings
+// rebuilt four at a time.
+// This file is part of the code for the SEDS test stand.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tsstand {
+
+// Fills t and value with the samples of a packed frame's payload, up to
+// PACK_MAX_SAMPLES of each, and returns how many there are; 0 if the
+// payload is malformed. Gives what pack_Decode does, faster.
+size_t unpack_samples(const uint8_t* payload, size_t len, uint32_t* t, int32_t* value);
+
+} // namespace tsstand
@@ -0,0 +1,85 @@
+// This file is part of the code for the SEDS test stand.
+#include "pyramid.hpp"
+
+#include <algorithm>
+
+namespace tsstand {
+
+void MinMaxPyramid::append(int64_t t, int32_t v)
+{
+    size_t leaf = static_cast<size_t>(count_ / kLeaf);
+    if (count_ % kLeaf == 0)
+        times_.push_back(t);
+    count_++;
+    last_t_ = t;
+    if (levels_.empty())
+        levels_.emplace_back();
+
+    for (size_t k = 0;; k++) {
+        if (k == levels_.size()) {
+            // the level below just outgrew one bucket: build the next from it
+            std::vector<Bucket> up;
+            const std::vector<Bucket>& below = levels_[k - 1];
+            for (size_t i = 0; i < below.size(); i++) {
+                size_t j = i >> kFanoutBits;
+                if (j == up.size()) {
+                    up.push_back(below[i]);
+                } else {
+                    up[j].lo = std::min(up[j].lo, below[i].lo);
+                    up[j].hi = std::max(up[j].hi, below[i].hi);
+                }
+            }
+            levels_.push_back(std::move(up));
+            return;
+        }
+        std::vector<Bucket>& level = levels_[k];
+        size_t j = leaf >> (k * kFanoutBits);
+        if (j == level.size()) {
+            level.push_back({v, v});
+        } else {
+            Bucket& b = level[j];
+            if (v >= b.lo && v <= b.hi)
+                return; // and so is every bucket above
+            b.lo = std::min(b.lo, v);
+            b.hi = std::max(b.hi, v);
+        }
+        if (level.size() == 1)
+            return; // the top
+    }
+}
+
+void MinMaxPyramid::query(int64_t t0, int64_t t1, size_t width, std::vector<PlotColumn>& out) const
+{
+    out.clear();
+    if (count_ == 0 || width == 0 || t1 <= t0)
+        return;
+    // leaves from the one holding t0 to the last starting by t1
+    size_t i0 = static_cast<size_t>(std::upper_bound(times_.begin(), times_.end(), t0) - times_.begin());
+    size_t i1 = static_cast<size_t>(std::upper_bound(times_.begin(), times_.end(), t1) - times_.begin());
+    if (i0 > 0)
+        i0--;
+    if (i1 <= i0)
+        return;
+
+    size_t k = 0;
+    while (k + 1 < levels_.size() && ((i1 - i0) >> ((k + 1) * kFanoutBits)) >= width)
+        k++;
+    unsigned shift = static_cast<unsigned>(k * kFanoutBits);
+    const std::vector<Bucket>& level = levels_[k];
+    double px_per_tick = static_cast<double>(width) / static_cast<double>(t1 - t0);
+    size_t last_px = SIZE_MAX;
+    for (size_t j = i0 >> shift; j <= (i1 - 1) >> shift; j++) {
+        int64_t t = times_[j << shift];
+        size_t px = t <= t0 ? 0 : std::min(width - 1, static_cast<size_t>((t - t0) * px_per_tick));
+        const Bucket& b = level[j];
+        if (px == last_px) {
+            out.back().lo = std::min(out.back().lo, b.lo);
+            out.back().hi = std::max(out.back().hi, b.hi);
+            continue;
+        }
+        out.push_back({t, b.lo, b.hi});
+        last_px = px;
+    }
+}
+
+} // namespace tsstand
@@ -0,0 +1,57 @@
+// Multi-resolution min/max summary of one sample stream, for plotting a run
+// of any length at any zoom in time proportional to the plot's width.
+// This file is part of the code for the SEDS test stand.
+//
+// Level 0 holds the minimum and maximum of every kLeaf consecutive samples
+// and the time of the first; each level above combines kFanout buckets of
+// the one below. A query picks the coarsest level that still has a bucket
+// per pixel across the requested span, so it touches at most kFanout
+// buckets per pixel whether the run holds thousands of samples or hundreds
+// of millions. Drawn as a vertical line from minimum to maximum per pixel,
+// this looks exactly like plotting every sample, spikes included, which
+// averaging or picking every n-th sample would not.
+//
+// Appending costs a few comparisons per sample, and the whole pyramid is
+// about 2.3 bytes per sample. Samples must come in time order. Not thread
+// safe; see LivePlot in view_server.hpp for the shared version.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tsstand {
+
+// One pixel column of a plot.
+struct PlotColumn {
+    int64_t t; // time of the first sample, in ticks
+    int32_t lo, hi;
+};
+
+class MinMaxPyramid {
+public:
+    static constexpr size_t kLeaf = 8;
+    static constexpr unsigned kFanoutBits = 2; // 4 buckets per bucket of the next level
+
+    void append(int64_t t, int32_t v);
+
+    uint64_t count() const { return count_; }
+    int64_t first_t() const { return times_.empty() ? 0 : times_.front(); }
+    int64_t last_t() const { return last_t_; }
+
+    // At most `width` columns spanning [t0, t1], in time order; pixels
+    // with no samples are left out.
+    void query(int64_t t0, int64_t t1, size_t width, std::vector<PlotColumn>& out) const;
+
+private:
+    struct Bucket {
+        int32_t lo, hi;
+    };
+
+    std::vector<int64_t> times_;              // of each leaf's first sample
+    std::vector<std::vector<Bucket>> levels_; // levels_[0] are the leaves
+    uint64_t count_ = 0;
+    int64_t last_t_ = 0;
+};
+
+} // namespace tsstand
@@ -0,0 +1,80 @@
+// This file is part of the code for the SEDS test stand.
+#include "repeat.hpp"
+
+#include <algorithm>
+
+namespace tsstand {
+
+bool SelectiveRepeat::seen(const Frame& f, int64_t now)
+{
+    if (f.resent) {
+        auto it = have_seq_ ? missing_.find(behind(f.seq)) : missing_.end();
+        if (it == missing_.end()) {
+            stats_.late++;
+            return false;
+        }
+        missing_.erase(it);
+        stats_.recovered++;
+        return true;
+    }
+    if (!live(f, now))
+        return false;
+    if (f.type == kFrameTypeNack && f.len >= FRAME_NACK_SIZE) {
+        uint64_t first = behind(frame_Get16(f.payload));
+        uint16_t count = frame_Get16(f.payload + 2);
+        for (uint64_t s = first; s < first + count; s++)
+            stats_.gone += missing_.erase(s);
+    }
+    return true;
+}
+
+bool SelectiveRepeat::live(const Frame& f, int64_t now)
+{
+    if (!have_seq_) {
+        have_seq_ = true;
+        next_ = static_cast<uint64_t>(f.seq) + 1;
+        return true;
+    }
+    uint16_t gap = static_cast<uint16_t>(f.seq - static_cast<uint16_t>(next_));
+    if (gap >= 0x8000) {
+        uint16_t back = static_cast<uint16_t>(-gap);
+        if (f.type != kFrameTypeHello && back <= kSeqRestart) {
+            // late or twice: wanted only while still missing
+            auto it = missing_.find(behind(f.seq));
+            if (it == missing_.end()) {
+                stats_.late++;
+                return false;
+            }
+            missing_.erase(it);
+            stats_.recovered++;
+            return true;
+        }
+        // the board started over, and what it sent before is gone with
+        // its history
+        stats_.expired += missing_.size();
+        missing_.clear();
+        next_ = ((((next_ >> 16) + 1) << 16) | f.seq) + 1;
+        return true;
+    }
+    stats_.missed += gap;
+    uint64_t tracked = std::min<uint64_t>(gap, kMaxGap);
+    stats_.expired += gap - tracked;
+    for (uint64_t s = next_ + gap - tracked; s < next_ + gap; s++)
+        missing_[s] = {now, now - retry_}; // due at once
+    next_ += gap + 1;
+    return true;
+}
+
+void SelectiveRepeat::expire(int64_t now)
+{
+    for (auto it = missing_.begin(); it != missing_.end();) {
+        if (now - it->second.found <= window_) {
+            ++it;
+            continue;
+        }
+        it = missing_.erase(it);
+        stats_.expired++;
+    }
+}
+
+} // namespace tsstand
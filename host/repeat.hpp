@@ -0,0 +1,107 @@
+// Selective repeat over a board's RX line: notes the frames that never
+// arrived, by their sequence numbers, and asks the board to send them
+// again (FRAME_TYPE_NACK in tsframe.h) while the live stream goes on.
+// This file is part of the code for the SEDS test stand.
+//
+// A gap in the seq of the live frames puts the frames in it on the missing
+// list. poll() asks for them at once and then every `retry` until they come
+// back, the board answers that it no longer has them, or `window` has
+// passed since the gap showed. A frame that comes back after that is not
+// wanted: whatever puts the samples back in order has let their time go
+// by. The retry allows for a frame sent again waiting behind a transmit
+// ring's worth of live frames, about half a second at 115200 baud. The
+// PSoC board keeps one to several seconds of sample frames (history.h);
+// frames it does not keep, like its hellos and replies, it names gone
+// straight away. A board that never answers, like the Arduino sketch, just
+// lets the window close.
+#pragma once
+
+#include "frame_decoder.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+namespace tsstand {
+
+struct RepeatStats {
+    uint64_t missed = 0;    // frames missing from the live stream
+    uint64_t recovered = 0; // of those, sent again or come late, in time
+    uint64_t gone = 0;      // the board no longer had
+    uint64_t expired = 0;   // still missing when the window closed
+    uint64_t late = 0;      // sent again or come late after that, or twice
+    uint64_t requests = 0;  // NACK frames asked for
+};
+
+class SelectiveRepeat {
+public:
+    explicit SelectiveRepeat(int64_t retry_ns = 500000000, int64_t window_ns = 2000000000)
+        : retry_(retry_ns), window_(window_ns)
+    {
+    }
+
+    static constexpr size_t kMaxRun = FRAME_NACK_MAX_RUN; // frames one request names
+    static constexpr size_t kMaxRequests = 2;             // per poll; the board holds one request at a time
+    static constexpr size_t kMaxGap = 4096;               // frames of one gap kept track of
+
+    // Every frame from the board, at host time now in ns. Returns false for
+    // a frame sent again, or come late or twice in the live stream, that is
+    // no longer wanted; drop its samples. A hello behind the newest seq, or
+    // a frame more than kSeqRestart behind, is a board that started over.
+    bool seen(const Frame& f, int64_t now);
+
+    // Calls send(payload, len) with the payload of each FRAME_TYPE_NACK due
+    // at now, for the caller to frame and write.
+    template <class Send>
+    void poll(int64_t now, Send&& send)
+    {
+        expire(now);
+        size_t sent = 0;
+        auto it = missing_.begin();
+        while (it != missing_.end() && sent < kMaxRequests) {
+            if (now - it->second.asked < retry_) {
+                ++it;
+                continue;
+            }
+            uint64_t first = it->first;
+            uint16_t count = 0;
+            while (it != missing_.end() && it->first == first + count && count < kMaxRun &&
+                   now - it->second.asked >= retry_) {
+                it->second.asked = now;
+                ++it;
+                count++;
+            }
+            uint8_t payload[FRAME_NACK_SIZE];
+            frame_Put16(payload, static_cast<uint16_t>(first));
+            frame_Put16(payload + 2, count);
+            send(payload, static_cast<uint8_t>(sizeof payload));
+            stats_.requests++;
+            sent++;
+        }
+    }
+
+    size_t missing() const { return missing_.size(); }
+    const RepeatStats& stats() const { return stats_; }
+
+private:
+    struct Missing {
+        int64_t found; // host ns the gap showed
+        int64_t asked; // last asked for
+    };
+
+    // The unwrapped seq of a frame from before the newest live one.
+    uint64_t behind(uint16_t seq) const
+    {
+        return next_ - 1 - static_cast<uint16_t>(static_cast<uint16_t>(next_ - 1) - seq);
+    }
+    bool live(const Frame& f, int64_t now);
+    void expire(int64_t now);
+
+    int64_t retry_, window_;
+    std::map<uint64_t, Missing> missing_; // by unwrapped seq
+    bool have_seq_ = false;
+    uint64_t next_ = 0; // unwrapped seq of the next live frame
+    RepeatStats stats_;
+};
+
+} // namespace tsstand
@@ -0,0 +1,225 @@
+// This file is part of the code for the SEDS test stand.
+#include "runfile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace tsstand {
+
+static uint64_t align_up(uint64_t v)
+{
+    return (v + kRunAlign - 1) / kRunAlign * kRunAlign;
+}
+
+static void fail(const std::string& what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+RunWriter::RunWriter(const std::string& path, uint64_t capacity, const RunInfo& info)
+    : capacity_(capacity)
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+        fail(path);
+
+    std::memcpy(header_.magic, kRunMagic, sizeof kRunMagic);
+    header_.version = kRunVersion;
+    header_.header_size = kRunAlign;
+    header_.capacity = capacity;
+    header_.times_offset = kRunAlign;
+    header_.samples_offset = align_up(kRunAlign + capacity * sizeof(int64_t));
+    header_.channels_offset = align_up(header_.samples_offset + capacity * sizeof(int32_t));
+    header_.tick_hz = 1000000;
+    header_.board_id = info.board_id;
+    header_.sample_rate_hz = info.sample_rate_hz;
+    set_calibration(info.cal);
+    header_.start_unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count();
+    std::strncpy(header_.note, info.note.c_str(), sizeof header_.note - 1);
+
+    uint64_t size = align_up(header_.channels_offset + capacity);
+    int err = posix_fallocate(fd_, 0, static_cast<off_t>(size));
+    if (err) {
+        errno = err;
+        fail(path + ": preallocating");
+    }
+    write_at(0, &header_, sizeof header_);
+    times_.reserve(kBatch);
+    samples_.reserve(kBatch);
+    channels_.reserve(kBatch);
+}
+
+void RunWriter::set_calibration(const Calibration& cal)
+{
+    header_.cal_gain = cal.gain;
+    header_.cal_offset = cal.offset;
+    header_.cal_square = cal.square;
+    header_.cal_cube = cal.cube;
+    header_.cal_temp_gain = cal.temp_gain;
+    header_.cal_temp_ref = cal.temp_ref;
+    header_.cal_temp_input = cal.temp_input;
+    header_.cal_points = cal.points;
+    header_.cal_made_unix = cal.made_unix;
+    header_.cal_rms = cal.rms;
+}
+
+RunWriter::~RunWriter()
+{
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void RunWriter::write_at(uint64_t off, const void* data, size_t len)
+{
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = pwrite(fd_, p, len, static_cast<off_t>(off));
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            fail("run file write");
+        }
+        p += n;
+        off += static_cast<uint64_t>(n);
+        len -= static_cast<size_t>(n);
+    }
+}
+
+void RunWriter::flush()
+{
+    if (fd_ < 0 || times_.empty())
+        return;
+    write_at(header_.times_offset + count_ * sizeof(int64_t), times_.data(),
+             times_.size() * sizeof(int64_t));
+    write_at(header_.samples_offset + count_ * sizeof(int32_t), samples_.data(),
+             samples_.size() * sizeof(int32_t));
+    write_at(header_.channels_offset + count_, channels_.data(), channels_.size());
+    count_ += times_.size();
+    times_.clear();
+    samples_.clear();
+    channels_.clear();
+    // the count goes last, so a reader never sees samples that are not there
+    header_.count = count_;
+    write_at(0, &header_, sizeof header_);
+}
+
+void RunWriter::close()
+{
+    if (fd_ < 0)
+        return;
+    flush();
+
+    // move the later columns down to the end of the used part of the one before
+    uint64_t to = align_up(header_.times_offset + count_ * sizeof(int64_t));
+    move_down(header_.samples_offset, to, count_ * sizeof(int32_t));
+    header_.samples_offset = to;
+    to = align_up(header_.samples_offset + count_ * sizeof(int32_t));
+    move_down(header_.channels_offset, to, count_);
+    header_.channels_offset = to;
+
+    header_.capacity = count_;
+    header_.count = count_;
+    write_at(0, &header_, sizeof header_);
+    if (ftruncate(fd_, static_cast<off_t>(header_.channels_offset + count_)) < 0)
+        fail("run file trim");
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void RunWriter::move_down(uint64_t from, uint64_t to, uint64_t len)
+{
+    if (to >= from)
+        return;
+    std::vector<char> buf(1 << 20);
+    for (uint64_t done = 0; done < len;) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(buf.size(), len - done));
+        if (pread(fd_, buf.data(), n, static_cast<off_t>(from + done)) != static_cast<ssize_t>(n))
+            fail("run file compact");
+        write_at(to + done, buf.data(), n);
+        done += n;
+    }
+}
+
+RunFile::RunFile(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        fail(path);
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        fail(path);
+    }
+    map_size_ = static_cast<size_t>(st.st_size);
+    if (map_size_ < sizeof(RunHeader)) {
+        ::close(fd);
+        throw std::runtime_error(path + ": not a run file");
+    }
+    map_ = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        fail(path);
+    }
+
+    header_ = static_cast<const RunHeader*>(map_);
+    const RunHeader& h = *header_;
+    const char* problem = nullptr;
+    if (std::memcmp(h.magic, kRunMagic, sizeof kRunMagic) != 0 || h.version < 1 || h.version > kRunVersion)
+        problem = ": not a version 1 to 3 run file";
+    else if (h.count > h.capacity || h.times_offset % kRunAlign || h.samples_offset % kRunAlign ||
+             h.times_offset + h.count * sizeof(int64_t) > map_size_ ||
+             h.samples_offset + h.count * sizeof(int32_t) > map_size_ || h.tick_hz == 0 ||
+             (h.version >= 2 && h.channels_offset + h.count > map_size_))
+        problem = ": header does not match the file";
+    if (problem) {
+        munmap(map_, map_size_);
+        throw std::runtime_error(path + problem);
+    }
+
+    const char* base = static_cast<const char*>(map_);
+    times_ = reinterpret_cast<const int64_t*>(base + h.times_offset);
+    samples_ = reinterpret_cast<const int32_t*>(base + h.samples_offset);
+    if (h.version >= 2)
+        channels_ = reinterpret_cast<const uint8_t*>(base + h.channels_offset);
+    madvise(map_, map_size_, MADV_SEQUENTIAL);
+}
+
+RunFile::~RunFile()
+{
+    if (map_)
+        munmap(map_, map_size_);
+}
+
+Calibration header_calibration(const RunHeader& h)
+{
+    Calibration cal;
+    cal.gain = h.cal_gain;
+    cal.offset = h.cal_offset;
+    cal.board_id = h.board_id;
+    if (h.version >= 3) {
+        cal.square = h.cal_square;
+        cal.cube = h.cal_cube;
+        cal.temp_input = h.cal_temp_input;
+        cal.temp_gain = h.cal_temp_input >= 0 ? h.cal_temp_gain : 0;
+        cal.temp_ref = h.cal_temp_ref;
+        cal.points = h.cal_points;
+        cal.made_unix = h.cal_made_unix;
+        cal.rms = h.cal_rms;
+    }
+    return cal;
+}
+
+} // namespace tsstand
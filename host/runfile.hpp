@@ -0,0 +1,153 @@
+// Run files: one recorded burn, stored so it can be memory-mapped and used
+// without any parsing.
+// This file is part of the code for the SEDS test stand.
+//
+// Layout (all little-endian):
+//
+//   offset 0          RunHeader, padded to 4096 bytes
+//   times_offset      int64 timestamps in ticks of tick_hz, one per sample
+//   samples_offset    int32 raw readings, one per sample
+//   channels_offset   uint8 board input each reading came from (version 2)
+//
+// Every column starts on a 4096 byte boundary. While a capture is running the
+// columns have room for `capacity` samples and `count` is bumped every time
+// a batch is flushed, so a reader can map a live file and use the first
+// `count` entries. When the capture ends the later columns are moved down to
+// follow the used part of the one before and the file is trimmed.
+//
+// Version 1 files have no channels column; all their samples are from input
+// 0, the load cell. Force in newtons is cal_gain * (reading - cal_offset),
+// for input 0; other inputs are stored as raw counts. Version 3 adds the
+// rest of the calibration record (calibration.hpp) the run was taken with;
+// its extra terms are zero in older files.
+#pragma once
+
+#include "calibration.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tsstand {
+
+constexpr char kRunMagic[8] = {'T', 'S', 'R', 'U', 'N', 0, 0, 0};
+constexpr uint32_t kRunVersion = 3;
+constexpr size_t kRunAlign = 4096;
+
+struct RunHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t capacity;
+    uint64_t count;
+    uint64_t times_offset;
+    uint64_t samples_offset;
+    uint32_t tick_hz;
+    uint32_t board_id;
+    double sample_rate_hz; // nominal output rate of the board
+    double cal_gain;       // newtons per count
+    double cal_offset;     // counts at zero load
+    int64_t start_unix_ns; // wall clock when the capture started
+    char note[64];
+    uint64_t channels_offset; // 0 in version 1
+    double cal_square;        // the rest of the Calibration, version 3
+    double cal_cube;
+    double cal_temp_gain;
+    double cal_temp_ref;
+    int32_t cal_temp_input;
+    uint32_t cal_points;
+    int64_t cal_made_unix;
+    double cal_rms;
+};
+static_assert(sizeof(RunHeader) <= kRunAlign, "run header must fit its block");
+
+struct RunInfo {
+    uint32_t board_id = 0;
+    double sample_rate_hz = 0;
+    Calibration cal;
+    std::string note;
+};
+
+// The calibration a run was recorded with.
+Calibration header_calibration(const RunHeader& h);
+
+// Append-only writer. Throws std::system_error on I/O failure.
+class RunWriter {
+public:
+    RunWriter(const std::string& path, uint64_t capacity, const RunInfo& info);
+    ~RunWriter();
+
+    RunWriter(const RunWriter&) = delete;
+    RunWriter& operator=(const RunWriter&) = delete;
+
+    // Returns false once the file is full; the sample is counted in dropped().
+    bool append(int64_t t, int32_t value, uint8_t channel = 0)
+    {
+        if (count_ + times_.size() >= capacity_) {
+            dropped_++;
+            return false;
+        }
+        times_.push_back(t);
+        samples_.push_back(value);
+        channels_.push_back(channel);
+        if (times_.size() == kBatch)
+            flush();
+        return true;
+    }
+
+    void set_tick_hz(uint32_t hz) { header_.tick_hz = hz; }
+    // for a board that turns out to send milli-newtons
+    void set_calibration(const Calibration& cal);
+    void flush();
+    // Flushes, compacts and trims the file. Called by the destructor too.
+    void close();
+
+    uint64_t count() const { return count_ + times_.size(); }
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    static constexpr size_t kBatch = 1 << 15;
+
+    void write_at(uint64_t off, const void* data, size_t len);
+    void move_down(uint64_t from, uint64_t to, uint64_t len);
+
+    int fd_ = -1;
+    uint64_t capacity_;
+    uint64_t count_ = 0;
+    uint64_t dropped_ = 0;
+    RunHeader header_{};
+    std::vector<int64_t> times_;
+    std::vector<int32_t> samples_;
+    std::vector<uint8_t> channels_;
+};
+
+// Read-only mapping of a run file. Throws std::runtime_error or
+// std::system_error if the file cannot be used.
+class RunFile {
+public:
+    explicit RunFile(const std::string& path);
+    ~RunFile();
+
+    RunFile(const RunFile&) = delete;
+    RunFile& operator=(const RunFile&) = delete;
+
+    const RunHeader& header() const { return *header_; }
+    size_t size() const { return static_cast<size_t>(header_->count); }
+    const int64_t* times() const { return times_; }
+    const int32_t* samples() const { return samples_; }
+    // nullptr for a version 1 file, whose samples are all from input 0
+    const uint8_t* channels() const { return channels_; }
+    uint8_t channel(size_t i) const { return channels_ ? channels_[i] : 0; }
+    double seconds(size_t i) const { return static_cast<double>(times_[i]) / header_->tick_hz; }
+
+private:
+    void* map_ = nullptr;
+    size_t map_size_ = 0;
+    const RunHeader* header_ = nullptr;
+    const int64_t* times_ = nullptr;
+    const int32_t* samples_ = nullptr;
+    const uint8_t* channels_ = nullptr;
+};
+
+} // namespace tsstand
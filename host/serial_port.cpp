@@ -0,0 +1,63 @@
+// This file is part of the code for the SEDS test stand.
+#include "serial_port.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <system_error>
+#include <termios.h>
+#include <unistd.h>
+
+namespace tsstand {
+
+static speed_t to_speed(unsigned baud)
+{
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 2000000: return B2000000;
+    default: throw std::system_error(EINVAL, std::generic_category(), "unsupported baud rate");
+    }
+}
+
+SerialPort::SerialPort(const std::string& path, unsigned baud) : path_(path)
+{
+    speed_t speed = to_speed(baud);
+    fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0)
+        throw std::system_error(errno, std::generic_category(), path);
+
+    termios tio{};
+    if (tcgetattr(fd_, &tio) < 0) {
+        int err = errno;
+        ::close(fd_);
+        throw std::system_error(err, std::generic_category(), path);
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 1; // with O_NONBLOCK an empty read is EAGAIN, not 0
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(fd_, TCSANOW, &tio) < 0) {
+        int err = errno;
+        ::close(fd_);
+        throw std::system_error(err, std::generic_category(), path);
+    }
+    tcflush(fd_, TCIFLUSH);
+}
+
+SerialPort::~SerialPort()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+}
+
+} // namespace tsstand
@@ -0,0 +1,27 @@
+// Raw, non-blocking serial port setup for the stand's USB-UART link.
+// This file is part of the code for the SEDS test stand.
+#pragma once
+
+#include <string>
+
+namespace tsstand {
+
+class SerialPort {
+public:
+    // Opens path in raw 8N1 mode at the given baud rate. Throws
+    // std::system_error on failure.
+    SerialPort(const std::string& path, unsigned baud);
+    ~SerialPort();
+
+    SerialPort(const SerialPort&) = delete;
+    SerialPort& operator=(const SerialPort&) = delete;
+
+    int fd() const { return fd_; }
+    const std::string& path() const { return path_; }
+
+private:
+    int fd_ = -1;
+    std::string path_;
+};
+
+} // namespace tsstand
@@ -0,0 +1,98 @@
+// Fixed-size ring between exactly one producer thread and one consumer
+// thread, so tsacq's serial reader never waits on the stages behind it.
+// This file is part of the code for the SEDS test stand.
+//
+// Both ends are wait-free: every call finishes in a bounded number of steps
+// whatever the other thread is doing, and neither ever takes a lock. The
+// producer claims a slot, fills it in place and publishes it; the consumer
+// peeks at the oldest published slot and releases it when done. When the
+// ring is full claim() fails instead of waiting, and the producer decides
+// what to drop; the ring counts those refusals and the deepest it has been,
+// for the consumer to report.
+//
+// Each index is written by one side only and sits on its own cache line,
+// and each side keeps a private copy of the other's index, refreshed only
+// when the copy says the ring looks full (or empty), so in the steady state
+// the two threads do not bounce cache lines on every item.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace tsstand {
+
+template <class T>
+class SpscRing {
+public:
+    // Capacity is rounded up to a power of two.
+    explicit SpscRing(size_t capacity)
+    {
+        size_t n = 1;
+        while (n < capacity)
+            n <<= 1;
+        slots_.reset(new T[n]);
+        mask_ = n - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer: a free slot to fill, or nullptr if the ring is full.
+    T* claim()
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) {
+                full_.store(full_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+        return &slots_[tail & mask_];
+    }
+
+    // Producer: hands the claimed slot to the consumer.
+    void publish()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: the oldest published slot, or nullptr if there is none.
+    T* peek()
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_)
+                return nullptr;
+            if (tail_cache_ - head > high_water_.load(std::memory_order_relaxed))
+                high_water_.store(tail_cache_ - head, std::memory_order_relaxed);
+        }
+        return &slots_[head & mask_];
+    }
+
+    // Consumer: frees the slot peek() returned.
+    void release() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    size_t capacity() const { return mask_ + 1; }
+    // Times claim() found the ring full, and the most slots the consumer
+    // has found waiting. Either side may read these.
+    uint64_t full() const { return full_.load(std::memory_order_relaxed); }
+    size_t high_water() const { return high_water_.load(std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<T[]> slots_;
+    size_t mask_ = 0;
+
+    alignas(64) std::atomic<size_t> head_{0}; // next slot to consume, written by the consumer
+    size_t tail_cache_ = 0;                   // the consumer's copy of tail_
+    std::atomic<size_t> high_water_{0};
+
+    alignas(64) std::atomic<size_t> tail_{0}; // next slot to fill, written by the producer
+    size_t head_cache_ = 0;                   // the producer's copy of head_
+    std::atomic<uint64_t> full_{0};
+};
+
+} // namespace tsstand
@@ -0,0 +1,81 @@
+// This file is part of the code for the SEDS test stand.
+#include "telemetry.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <iterator>
+
+namespace tsstand {
+
+namespace {
+
+uint32_t get32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0] | (p[1] << 8) | (p[2] << 16)) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+} // namespace
+
+uint64_t StageProfile::quantile(double q) const
+{
+    // bucket counts saturate in each report, so go by their sum, not count
+    uint64_t sum = 0;
+    for (uint64_t h : hist)
+        sum += h;
+    uint64_t want = static_cast<uint64_t>(q * sum);
+    uint64_t seen = 0;
+    for (size_t k = 0; k < hist.size(); k++) {
+        seen += hist[k];
+        if (seen > want)
+            return uint64_t{1} << (kProfileShift + k);
+    }
+    return longest;
+}
+
+bool Telemetry::add(const Frame& f)
+{
+    if (f.type != kFrameTypeTelemetry || f.len < 14)
+        return false;
+    const uint8_t* p = f.payload;
+    size_t nstages = p[12], nbuckets = p[13];
+    size_t per_stage = 12 + 2 * nbuckets;
+    if (f.len < 14 + nstages * per_stage)
+        return false;
+
+    reports++;
+    overruns = get32(p);
+    tx_rejected = get32(p + 4);
+    tx_dropped = get32(p + 8);
+    if (stages.size() < nstages)
+        stages.resize(nstages);
+    p += 14;
+    for (size_t i = 0; i < nstages; i++, p += per_stage) {
+        StageProfile& s = stages[i];
+        uint32_t count = get32(p);
+        s.count += count;
+        s.total += static_cast<uint64_t>(get32(p + 4)) * count;
+        s.longest = std::max(s.longest, get32(p + 8));
+        if (s.hist.size() < nbuckets)
+            s.hist.resize(nbuckets);
+        for (size_t k = 0; k < nbuckets; k++)
+            s.hist[k] += static_cast<uint16_t>(p[12 + 2 * k] | (p[13 + 2 * k] << 8));
+    }
+    return true;
+}
+
+void Telemetry::print(FILE* out) const
+{
+    std::fprintf(out, "%" PRIu64 " telemetry reports, %" PRIu32 " conversions lost, %" PRIu32
+                      " frames rejected (%" PRIu32 " bytes)\n",
+                 reports, overruns, tx_rejected, tx_dropped);
+    std::fprintf(out, "  %-8s %10s %9s %9s %9s %9s  (cycles)\n", "stage", "count", "mean", "p50<=",
+                 "p99<=", "max");
+    for (size_t i = 0; i < stages.size(); i++) {
+        const StageProfile& s = stages[i];
+        const char* name = i < std::size(kProfileStageNames) ? kProfileStageNames[i] : "?";
+        std::fprintf(out, "  %-8s %10" PRIu64 " %9.0f %9" PRIu64 " %9" PRIu64 " %9" PRIu32 "\n", name,
+                     s.count, s.mean(), s.quantile(0.5), s.quantile(0.99), s.longest);
+    }
+}
+
+} // namespace tsstand
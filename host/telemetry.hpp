@@ -0,0 +1,46 @@
+// Telemetry frames from the firmware's loop profiler (profile.h in the
+// firmware project): per-stage histograms of cycle counts and the running
+// counts of lost conversions and rejected frames.
+// This file is part of the code for the SEDS test stand.
+#pragma once
+
+#include "frame_decoder.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace tsstand {
+
+// Stage names, in the order of the enum in profile.h.
+constexpr const char* kProfileStageNames[] = {"service", "block", "send", "latency", "report"};
+constexpr unsigned kProfileShift = 4; // bucket 0 holds intervals under 1 << kProfileShift cycles
+
+struct StageProfile {
+    uint64_t count = 0;
+    uint64_t total = 0; // cycles
+    uint32_t longest = 0;
+    std::vector<uint64_t> hist;
+
+    double mean() const { return count ? static_cast<double>(total) / count : 0.0; }
+    // Upper edge, in cycles, of the bucket holding quantile q (0..1).
+    uint64_t quantile(double q) const;
+};
+
+struct Telemetry {
+    uint64_t reports = 0;
+    uint32_t overruns = 0;    // conversions lost, since start-up
+    uint32_t tx_rejected = 0; // frames the transmit ring had no room for
+    uint32_t tx_dropped = 0;  // bytes in those frames
+    std::vector<StageProfile> stages;
+
+    // Adds a telemetry frame to the totals. Returns false for other frame
+    // types and for malformed payloads.
+    bool add(const Frame& f);
+
+    // One line per stage: intervals, mean, median, 99th percentile and
+    // longest, in cycles.
+    void print(FILE* out) const;
+};
+
+} // namespace tsstand
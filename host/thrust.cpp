@@ -0,0 +1,282 @@
+// This file is part of the code for the SEDS test stand.
+#include "thrust.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace tsstand {
+
+ThrustAnalyzer::ThrustAnalyzer(const AnalysisConfig& config)
+    : cfg_(config)
+{
+    size_t ring = 1;
+    while (ring < 2 * kBlock + cfg_.pad + 2 * kMaxHalfWindow + 2)
+        ring <<= 1;
+    ring_mask_ = ring - 1;
+    ring_t_.resize(ring);
+    ring_load_.resize(ring);
+    ring_impulse_.resize(ring);
+    ring_sum_.resize(ring);
+
+    x_.resize(kBlock);
+    t_.resize(kBlock + 1);
+    load_.resize(kBlock + 1);
+    inc_.resize(kBlock);
+    warm_t_.reserve(cfg_.clean_window);
+    warm_raw_.reserve(cfg_.clean_window);
+}
+
+void ThrustAnalyzer::push(const int64_t* t, const int32_t* raw, size_t n)
+{
+    if (!have_floor_) {
+        size_t take = std::min(n, cfg_.clean_window - warm_raw_.size());
+        warm_t_.insert(warm_t_.end(), t, t + take);
+        warm_raw_.insert(warm_raw_.end(), raw, raw + take);
+        t += take;
+        raw += take;
+        n -= take;
+        if (warm_raw_.size() < cfg_.clean_window)
+            return;
+        set_clean_floor();
+    }
+    run(t, raw, n);
+}
+
+void ThrustAnalyzer::set_clean_floor()
+{
+    size_t n = warm_raw_.size();
+    clean_floor_ = -std::numeric_limits<double>::infinity();
+    if (n >= 2) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++)
+            sum += warm_raw_[i];
+        double mean = sum / n, ss = 0;
+        for (size_t i = 0; i < n; i++)
+            ss += (warm_raw_[i] - mean) * (warm_raw_[i] - mean);
+        clean_floor_ = mean - cfg_.clean_sigmas * std::sqrt(ss / (n - 1));
+    }
+    have_floor_ = true;
+    run(warm_t_.data(), warm_raw_.data(), n);
+    warm_t_.clear();
+    warm_raw_.clear();
+}
+
+void ThrustAnalyzer::run(const int64_t* t, const int32_t* raw, size_t n)
+{
+    while (n > 0) {
+        size_t k = std::min(n, kBlock);
+        block(t, raw, k);
+        t += k;
+        raw += k;
+        n -= k;
+    }
+}
+
+void ThrustAnalyzer::block(const int64_t* t, const int32_t* raw, size_t n)
+{
+    double* x = x_.data();
+    double* ts = t_.data();
+    double* load = load_.data();
+    double* inc = inc_.data();
+
+    int32_t lo = raw[0];
+    for (size_t i = 0; i < n; i++) {
+        x[i] = raw[i];
+        lo = std::min(lo, raw[i]);
+    }
+    if (lo < clean_floor_) {
+        clean(n);
+    } else {
+        raw2_ = n >= 2 ? x[n - 2] : raw1_;
+        raw1_ = x[n - 1];
+    }
+
+    if (done_ == 0) {
+        t0_ = t[0];
+        zero_ = cfg_.tare ? cfg_.cal.newtons(x[0], cfg_.temp) : 0;
+    }
+    const Calibration& cal = cfg_.cal;
+    const double tick = 1.0 / cfg_.tick_hz;
+    const double warm = cal.temp_gain * (cfg_.temp - cal.temp_ref);
+    if (cal.square == 0 && cal.cube == 0) {
+        const double bias = cal.gain * cal.offset - warm + zero_;
+        for (size_t i = 0; i < n; i++)
+            load[i + 1] = cal.gain * x[i] - bias;
+    } else {
+        const double bias = zero_ - warm;
+        for (size_t i = 0; i < n; i++) {
+            double u = x[i] - cal.offset;
+            load[i + 1] = ((cal.cube * u + cal.square) * u + cal.gain) * u - bias;
+        }
+    }
+    for (size_t i = 0; i < n; i++)
+        ts[i + 1] = static_cast<double>(t[i] - t0_) * tick;
+    if (done_ == 0) {
+        ts[0] = ts[1];
+        load[0] = load[1];
+    }
+
+    // trapezoids between consecutive samples; the script drops negative ones
+    double hi = load[1];
+    for (size_t i = 0; i < n; i++) {
+        double a = (ts[i + 1] - ts[i]) * (load[i + 1] + load[i]) * 0.5;
+        inc[i] = a > 0 ? a : 0;
+        hi = std::max(hi, load[i + 1]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        size_t r = slot(done_ + i);
+        impulse_ += inc[i];
+        load_sum_ += load[i + 1];
+        ring_t_[r] = ts[i + 1];
+        ring_load_[r] = load[i + 1];
+        ring_impulse_[r] = impulse_;
+        ring_sum_[r] = load_sum_;
+    }
+
+    if (done_ == 0 || hi > st_.max_force) {
+        size_t i = 0;
+        while (load[i + 1] != hi)
+            i++;
+        st_.max_force = hi;
+        max_index_ = done_ + i;
+        max_settled_ = false;
+    }
+    if (!have_threshold_)
+        baseline(n);
+    if (have_threshold_ && hi > st_.threshold)
+        detect(n);
+    else
+        above_run_ = 0;
+
+    done_ += n;
+    ts[0] = ts[n];
+    load[0] = load[n];
+    settle(false);
+}
+
+void ThrustAnalyzer::clean(size_t n)
+{
+    double* x = x_.data();
+    for (size_t i = 0; i < n; i++) {
+        if (done_ + i >= 2 && x[i] < clean_floor_) {
+            x[i] = raw1_ + (raw1_ - raw2_) / 2;
+            st_.outliers_replaced++;
+        }
+        raw2_ = raw1_;
+        raw1_ = x[i];
+    }
+}
+
+void ThrustAnalyzer::baseline(size_t n)
+{
+    size_t want = cfg_.baseline_window;
+    const double* load = load_.data() + 1;
+    for (size_t i = 0; i < n && base_n_ < want; i++) {
+        base_n_++;
+        double d = load[i] - base_mean_;
+        base_mean_ += d / base_n_;
+        base_m2_ += d * (load[i] - base_mean_);
+    }
+    if (base_n_ < want)
+        return;
+    double sd = base_n_ >= 2 ? std::sqrt(base_m2_ / (base_n_ - 1)) : 0;
+    st_.threshold = base_mean_ + std::max(cfg_.trigger_sigmas * sd, cfg_.min_rise);
+    have_threshold_ = true;
+}
+
+void ThrustAnalyzer::detect(size_t n)
+{
+    const double* load = load_.data() + 1;
+    const double thr = st_.threshold;
+    const size_t hold = std::max<size_t>(cfg_.hold, 1);
+    // the baseline itself is never part of the burn
+    size_t begin = cfg_.baseline_window > done_ ? cfg_.baseline_window - done_ : 0;
+    size_t last = n;
+    for (size_t i = begin; i < n; i++) {
+        if (!(load[i] > thr)) {
+            above_run_ = 0;
+            continue;
+        }
+        if (above_run_++ == 0)
+            above_from_ = done_ + i;
+        if (above_run_ < hold)
+            continue;
+        last = i;
+        if (!st_.burn_found) {
+            size_t g = above_from_;
+            size_t s = g >= cfg_.pad ? g - cfg_.pad : 0;
+            st_.burn_found = true;
+            st_.first_above = g;
+            st_.burn_start = s;
+            first_t_ = ring_t_[slot(g)];
+            first_sum_ = ring_sum_[slot(g)] - ring_load_[slot(g)];
+            start_t_ = ring_t_[slot(s)];
+            start_impulse_ = ring_impulse_[slot(s)];
+        }
+    }
+    if (last == n)
+        return;
+    size_t g = done_ + last;
+    st_.last_above = g;
+    last_t_ = ring_t_[slot(g)];
+    last_sum_ = ring_sum_[slot(g)];
+    end_settled_ = false;
+}
+
+// Captures what the end of the burn window and the samples around the
+// maximum need once they have gone by, or at the end of the run.
+void ThrustAnalyzer::settle(bool at_end)
+{
+    if (done_ == 0)
+        return;
+    size_t last = done_ - 1;
+
+    if (st_.burn_found && !end_settled_ && (st_.last_above + cfg_.pad <= last || at_end)) {
+        size_t e = std::min(st_.last_above + cfg_.pad, last);
+        st_.burn_end = e;
+        end_t_ = ring_t_[slot(e)];
+        end_impulse_ = ring_impulse_[slot(e)];
+        end_settled_ = true;
+    }
+
+    if (!max_settled_ && (max_index_ + kMaxHalfWindow <= last || at_end)) {
+        size_t a = max_index_ >= kMaxHalfWindow ? max_index_ - kMaxHalfWindow : 0;
+        size_t b = std::min(max_index_ + kMaxHalfWindow, last);
+        double w[2 * kMaxHalfWindow + 1] = {}, sum = 0;
+        size_t k = 0;
+        for (size_t g = a; g <= b; g++, k++) {
+            w[k] = ring_load_[slot(g)];
+            sum += w[k];
+        }
+        st_.max_force_mean = sum / k;
+        std::sort(w, w + k);
+        st_.max_force_median = k % 2 ? w[k / 2] : (w[k / 2 - 1] + w[k / 2]) / 2;
+        max_settled_ = true;
+    }
+}
+
+BurnStats ThrustAnalyzer::finish()
+{
+    if (!have_floor_)
+        set_clean_floor();
+    if (!have_threshold_ && base_n_ > 0) {
+        cfg_.baseline_window = base_n_;
+        baseline(0);
+    }
+    settle(true);
+
+    st_.samples = done_;
+    if (st_.burn_found) {
+        st_.ignition = first_t_;
+        st_.burn_time = last_t_ - first_t_;
+        st_.avg_force = (last_sum_ - first_sum_) / (st_.last_above - st_.first_above + 1);
+        st_.impulse = end_impulse_ - start_impulse_;
+        if (st_.burn_end > st_.burn_start)
+            st_.time_step = (end_t_ - start_t_) / (st_.burn_end - st_.burn_start);
+    }
+    return st_;
+}
+
+} // namespace tsstand
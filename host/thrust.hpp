@@ -0,0 +1,131 @@
+// Thrust curve analysis, the native equivalent of convertToLoadAndPlotMk2.m.
+// This file is part of the code for the SEDS test stand.
+//
+// The samples go through the script's pipeline in one pass: outlier
+// readings are replaced, counts become newtons, the burn is found against
+// the quiet start of the run, and the impulse is integrated over the burn.
+// Work is done a block at a time; the per-sample arithmetic is written as
+// plain loops over arrays so the compiler can vectorize it, and only the
+// rare events (an outlier, a new maximum, the load crossing the threshold)
+// drop down to scalar code.
+//
+// Departures from the script: the burn threshold is taken from the load,
+// not the time row, and defaults to 5 standard deviations rather than 1,
+// which the baseline noise alone would cross, and it has to be held for a
+// few samples. The padded window is simply clamped at the ends of the run.
+#pragma once
+
+#include "calibration.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tsstand {
+
+struct AnalysisConfig {
+    Calibration cal;
+    double temp = 0;  // reading of cal.temp_input, taken as constant over the run
+    bool tare = true;      // subtract the first sample's load from all
+    uint32_t tick_hz = 1000000;
+
+    // Readings below mean - clean_sigmas * std of the first clean_window
+    // readings are replaced by extrapolating from the two before them.
+    size_t clean_window = 100;
+    double clean_sigmas = 2;
+
+    // The burn is where the load is more than trigger_sigmas standard
+    // deviations (and at least min_rise newtons) above the mean of the first
+    // baseline_window samples for at least hold samples in a row, so lone
+    // noise spikes in a long run do not count. pad samples either side of
+    // it are kept in the window the impulse is integrated over.
+    size_t baseline_window = 200;
+    double trigger_sigmas = 5;
+    double min_rise = 0;
+    size_t hold = 8;
+    size_t pad = 243;
+};
+
+struct BurnStats {
+    size_t samples = 0;
+    size_t outliers_replaced = 0;
+    double threshold = 0; // N
+    double max_force = 0;
+    double max_force_mean = 0; // over the 11 samples around the maximum
+    double max_force_median = 0;
+
+    bool burn_found = false;
+    size_t first_above = 0; // first and last sample over the threshold
+    size_t last_above = 0;
+    size_t burn_start = 0; // first_above - pad .. last_above + pad
+    size_t burn_end = 0;
+    double ignition = 0;  // s from the first sample to first_above
+    double burn_time = 0; // s, first_above .. last_above
+    double avg_force = 0; // N, first_above .. last_above
+    double time_step = 0; // s, mean over burn_start .. burn_end
+    double impulse = 0;   // N s, over burn_start .. burn_end
+};
+
+// Feed the samples of a run in order with push(), in chunks of any size,
+// then call finish() once.
+class ThrustAnalyzer {
+public:
+    explicit ThrustAnalyzer(const AnalysisConfig& config);
+
+    void push(const int64_t* t, const int32_t* raw, size_t n);
+    BurnStats finish();
+
+    static constexpr size_t kBlock = 4096;
+    static constexpr size_t kMaxHalfWindow = 5;
+
+private:
+    void set_clean_floor();
+    void run(const int64_t* t, const int32_t* raw, size_t n);
+    void block(const int64_t* t, const int32_t* raw, size_t n);
+    void clean(size_t n);
+    void baseline(size_t n);
+    void detect(size_t n);
+    void settle(bool at_end);
+    size_t slot(size_t g) const { return g & ring_mask_; }
+
+    AnalysisConfig cfg_;
+    BurnStats st_;
+    size_t done_ = 0; // samples fully processed
+
+    // the first clean_window samples are held until the outlier floor is known
+    bool have_floor_ = false;
+    double clean_floor_ = 0; // raw counts
+    std::vector<int64_t> warm_t_;
+    std::vector<int32_t> warm_raw_;
+    double raw1_ = 0, raw2_ = 0; // the last two cleaned readings
+
+    int64_t t0_ = 0;
+    double zero_ = 0;
+    double impulse_ = 0, load_sum_ = 0; // running totals
+
+    // baseline (Welford) until the threshold is known
+    bool have_threshold_ = false;
+    double base_mean_ = 0, base_m2_ = 0;
+    size_t base_n_ = 0;
+
+    // one block; slot 0 of t_ and load_ carries the previous block's last sample
+    std::vector<double> x_, t_, load_, inc_;
+
+    // recent history, long enough to look back over the pad from any sample
+    // in the current block
+    size_t ring_mask_ = 0;
+    std::vector<double> ring_t_, ring_load_, ring_impulse_, ring_sum_;
+
+    size_t above_run_ = 0; // consecutive samples over the threshold so far
+    size_t above_from_ = 0;
+
+    // values captured as the burn edges and the maximum go by
+    double start_impulse_ = 0, start_t_ = 0, first_t_ = 0, first_sum_ = 0;
+    double last_t_ = 0, last_sum_ = 0;
+    bool end_settled_ = true;
+    double end_impulse_ = 0, end_t_ = 0;
+    size_t max_index_ = 0;
+    bool max_settled_ = true;
+};
+
+} // namespace tsstand
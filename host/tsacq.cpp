@@ -0,0 +1,629 @@
+// Acquisition daemon: reads the binary sample stream from the board's
+// serial port and writes the decoded samples to disk. Replaces
+// loadcellArduinoReadoutMk2.m.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tsacq [-b baud] [-m minutes] [-r samples_per_second]
+//              [-i board_id] [-C calibration] [-g newtons_per_count]
+//              [-o zero_counts] [-n note] [-t] [-k sigmas] [-p port] [-R]
+//              device... run.tsr
+//
+// The output is a run file (see runfile.hpp) with room for the expected
+// run length (-m, -r), compacted to what was actually recorded on exit
+// (SIGINT/SIGTERM or the device going away). The calibration record
+// (calibration.hpp) from -C, $TSSTAND_CAL or ./tsstand.cal, whichever comes
+// first, goes into the run file's header; -g and -o replace its gain and
+// offset.
+//
+// With -t only burns are recorded: a BurnDetector (burn_detector.hpp) with
+// one second of baseline, pre-trigger and post-trigger samples picks them
+// out as they happen, -k sets its start threshold in standard deviations,
+// and each burn is on disk as soon as it ends. On a multiplexed board this
+// records the load cell (input 0) alone; without -t every input is kept.
+//
+// Given several devices, tsacq records all of them into one run file on
+// the host's clock, in microseconds from the start. Four times a second it
+// sends each board a sync request and fits the board's clock to the host's
+// from the replies (clock_sync.hpp). A board's samples are only recorded
+// once it has answered; one that does not answer within a second is placed
+// by the arrival of its frames instead. The boards' samples are merged
+// in time order (merge.hpp), and the channel column holds the board's
+// position on the command line in its high four bits and the board's input
+// in the low four. -r is the rate of one board, and -t needs a single
+// device.
+//
+// Two threads split the work. The reader owns the serial ports: it reads,
+// decodes frames, keeps each board's clock sync and passes each frame's samples
+// on through an SpscRing (spsc_ring.hpp). The main thread merges, detects
+// burns, writes the run file and reports. Nothing the main thread does can
+// hold up a read: when the ring is full, the reader drops the frame's
+// samples and counts them instead of letting the ports' input buffers
+// overflow.
+//
+// Frames that never arrive, because of a byte error on the line or a full
+// transmit ring on the board, are asked for again while the stream goes
+// on (repeat.hpp), and their samples take their place in time order: what
+// is recorded runs three seconds behind the board to leave room for them. -R turns that off, for a board that cannot send frames again.
+//
+// -p serves a live plot of everything recorded so far on
+// http://127.0.0.1:port/ (view_server.hpp), from a third thread.
+#include "burn_detector.hpp"
+#include "clock_sync.hpp"
+#include "frame_decoder.hpp"
+#include "merge.hpp"
+#include "repeat.hpp"
+#include "runfile.hpp"
+#include "serial_port.hpp"
+#include "spsc_ring.hpp"
+#include "view_server.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace tsstand;
+
+namespace {
+
+constexpr size_t kMaxBoards = 16;           // four bits of the channel column
+constexpr int64_t kSyncPeriodNs = 250000000;
+constexpr int64_t kMergeLagNs = 50000000;   // how far out of order one board's frames can be
+constexpr int64_t kSilentNs = 1000000000;   // a board this quiet stops holding up the rest
+constexpr uint32_t kSyncRing = 16;          // requests remembered per board
+constexpr int64_t kNoReplyNs = 1000000000;  // then place the board by frame arrival
+constexpr size_t kBlockSamples = (255 - 4) / kSampleRecordSize; // a sample frame's most
+constexpr size_t kRingBlocks = 8192;        // about 25 s of samples from one board, 8 or more to a block
+constexpr int64_t kRepeatLagNs = 3000000000; // samples held for lost frames to come back in
+
+int64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+uint32_t get_u32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+void usage()
+{
+    std::fprintf(stderr, "usage: tsacq [-b baud] [-m minutes] [-r samples_per_second]\n"
+                         "             [-i board_id] [-C calibration] [-g newtons_per_count]\n"
+                         "             [-o zero_counts] [-n note] [-t] [-k sigmas] [-p port] [-R]\n"
+                         "             device... run.tsr\n");
+    std::exit(2);
+}
+
+// One serial port and what is known about its board's clock. Belongs to
+// the reader thread.
+struct Board {
+    Board(const std::string& path, unsigned baud) : port(path, baud) {}
+
+    SerialPort port;
+    FrameDecoder decoder;
+    SampleStream stream;
+    ClockSync sync;
+    SelectiveRepeat repeat;
+    bool open = true;
+    bool replied = false;
+    bool by_arrival = false;  // never replied; its frames' arrival stands in
+    int64_t first_data = 0;   // host ns its first samples came in, 0 before
+    uint64_t unsynced = 0;    // samples dropped waiting for the first reply
+    bool refused = false;     // its protocol is newer than ours
+    uint64_t rate_changes = 0; // reported so far
+    uint32_t token = 0;   // of the newest request
+    int64_t sent[kSyncRing] = {};
+    uint16_t seq = 0;
+    uint64_t samples = 0;
+
+    void send(uint8_t type, const uint8_t* payload, uint8_t len)
+    {
+        uint8_t frame[kFrameMaxSize];
+        size_t n = encode_frame(type, seq++, payload, len, frame);
+        // a full output buffer only costs this request
+        if (write(port.fd(), frame, n) < 0 && errno != EAGAIN)
+            std::fprintf(stderr, "%s: %s\n", port.path().c_str(), std::strerror(errno));
+    }
+
+    void request_sync(int64_t t)
+    {
+        uint8_t payload[4];
+        token++;
+        for (int i = 0; i < 4; i++)
+            payload[i] = static_cast<uint8_t>(token >> (8 * i));
+        sent[token % kSyncRing] = t;
+        send(kFrameTypeSync, payload, sizeof payload);
+    }
+
+    // Asks for the frames missing lately, as repeat.hpp decides.
+    void request_repeats(int64_t t)
+    {
+        repeat.poll(t, [&](const uint8_t* payload, uint8_t len) { send(kFrameTypeNack, payload, len); });
+    }
+
+    // A sync reply that arrived at host time t.
+    void on_reply(const Frame& f, int64_t t)
+    {
+        // the board time needs a recent sample to unwrap against
+        if (f.len < 8 || first_data == 0 || by_arrival)
+            return;
+        uint32_t tok = get_u32(f.payload);
+        if (token - tok >= kSyncRing)
+            return;
+        replied = true;
+        sync.add(sent[tok % kSyncRing], t, stream.board_time(get_u32(f.payload + 4)));
+    }
+};
+
+// One frame's samples on their way from the reader to the main thread.
+// When merging, the times are already host ns.
+struct Block {
+    bool end;         // the reader is done; nothing follows
+    uint8_t board;
+    uint16_t n;
+    uint32_t tick_hz;
+    bool newtons;     // the board's load cell readings are in mN
+    int64_t arrived;  // host ns
+    Sample samples[kBlockSamples];
+};
+
+// The reader's counters, sent to the main thread once a second.
+struct LinkReport {
+    uint64_t bytes;
+    uint64_t dropped; // samples the ring had no room for
+    struct {
+        uint64_t crc_errors, frames_lost, recovered, samples, unsynced;
+        bool replied;
+        double drift_ppm, rtt_ms;
+    } boards[kMaxBoards];
+};
+
+class Reader {
+public:
+    Reader(std::vector<std::unique_ptr<Board>>& boards, bool merging, bool repeating,
+           SpscRing<Block>& blocks, SpscRing<LinkReport>& reports)
+        : boards_(boards), merging_(merging), repeating_(repeating), blocks_(blocks), reports_(reports)
+    {
+    }
+
+    // Reads until a signal on sfd or every board has gone away.
+    void run(int sfd)
+    {
+        size_t nboards = boards_.size();
+        int ep = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        for (size_t b = 0; b < nboards; b++) {
+            ev.data.u64 = b;
+            epoll_ctl(ep, EPOLL_CTL_ADD, boards_[b]->port.fd(), &ev);
+        }
+        ev.data.u64 = nboards;
+        epoll_ctl(ep, EPOLL_CTL_ADD, sfd, &ev);
+
+        size_t open_boards = nboards;
+        bool running = true;
+        int64_t next_sync = now_ns();
+        int64_t next_report = next_sync + 1000000000;
+        while (running) {
+            if (merging_ && now_ns() >= next_sync) {
+                for (auto& b : boards_) {
+                    if (b->open)
+                        b->request_sync(now_ns());
+                }
+                next_sync += kSyncPeriodNs;
+            }
+            if (repeating_) {
+                for (auto& b : boards_) {
+                    if (b->open)
+                        b->request_repeats(now_ns());
+                }
+            }
+            epoll_event events[kMaxBoards + 1];
+            int n = epoll_wait(ep, events, kMaxBoards + 1, merging_ || repeating_ ? 50 : 250);
+            if (n < 0 && errno != EINTR) {
+                std::perror("epoll_wait");
+                break;
+            }
+            for (int e = 0; e < n; e++) {
+                size_t index = static_cast<size_t>(events[e].data.u64);
+                if (index == nboards) {
+                    running = false;
+                    continue;
+                }
+                Board& board = *boards_[index];
+                read_board(board, index);
+                if (board.open && (events[e].events & (EPOLLHUP | EPOLLERR))) {
+                    std::fprintf(stderr, "%s: hung up\n", board.port.path().c_str());
+                    board.open = false;
+                }
+                if (!board.open) {
+                    epoll_ctl(ep, EPOLL_CTL_DEL, board.port.fd(), nullptr);
+                    running = --open_boards > 0;
+                }
+            }
+            if (now_ns() >= next_report || !running) {
+                next_report += 1000000000;
+                report();
+            }
+        }
+        close(ep);
+
+        // the one place the reader waits for the main thread: it is done
+        Block* b;
+        while (!(b = blocks_.claim()))
+            usleep(1000);
+        b->end = true;
+        blocks_.publish();
+    }
+
+private:
+    void read_board(Board& board, size_t index)
+    {
+        for (;;) {
+            ssize_t got = read(board.port.fd(), buf_, sizeof buf_);
+            if (got > 0) {
+                bytes_ += static_cast<uint64_t>(got);
+                int64_t arrived = now_ns();
+                board.decoder.feed(buf_, static_cast<size_t>(got),
+                                   [&](const Frame& f) { on_frame(board, index, f, arrived); });
+                continue;
+            }
+            if (got < 0 && (errno == EAGAIN || errno == EINTR))
+                return;
+            // EOF or EIO: the board went away
+            std::fprintf(stderr, "%s: %s\n", board.port.path().c_str(),
+                         got == 0 ? "closed" : std::strerror(errno));
+            board.open = false;
+            return;
+        }
+    }
+
+    void on_frame(Board& board, size_t index, const Frame& f, int64_t arrived)
+    {
+        if (repeating_ && !board.repeat.seen(f, arrived))
+            return; // sent again too late to be put in its place
+        if (f.type == kFrameTypeSync) {
+            board.on_reply(f, arrived);
+            return;
+        }
+        Sample s[SampleStream::kMaxSamplesPerFrame];
+        // decode even without room in the ring, to keep the stream's time
+        // base going
+        size_t k = board.stream.decode(f, s);
+        board.samples += k;
+        if (board.stream.refused() && !board.refused) {
+            std::fprintf(stderr, "%s: board sends protocol version %u, newer than this tsacq's %u;"
+                                 " its samples are skipped\n",
+                         board.port.path().c_str(), board.stream.version(), kFrameVersion);
+            board.refused = true;
+        }
+        if (board.stream.rate_changes() != board.rate_changes) {
+            const RateChange& r = board.stream.rate();
+            std::fprintf(stderr, "%s: %s, a sample every %.3f ms\n", board.port.path().c_str(),
+                         r.idle ? "idle" : "load on, full rate", 1e3 * r.period / board.stream.tick_hz());
+            board.rate_changes = board.stream.rate_changes();
+        }
+        if (k == 0)
+            return;
+        if (merging_) {
+            board.sync.set_tick_hz(board.stream.tick_hz());
+            if (board.first_data == 0)
+                board.first_data = arrived;
+            if (!board.replied && !board.by_arrival) {
+                if (arrived - board.first_data < kNoReplyNs) {
+                    // switching from a guess to the fit later would put
+                    // samples out of order, so there is no guess
+                    board.unsynced += k;
+                    return;
+                }
+                std::fprintf(stderr, "%s: no sync replies, placing samples by arrival\n",
+                             board.port.path().c_str());
+                board.by_arrival = true;
+                board.sync.add(arrived, arrived, s[k - 1].t);
+            }
+            for (size_t i = 0; i < k; i++)
+                s[i].t = board.sync.to_host(s[i].t);
+        }
+        // a block holds a sample frame; a packed frame fills several
+        for (size_t i = 0; i < k; i += kBlockSamples) {
+            Block* b = blocks_.claim();
+            if (!b) {
+                dropped_ += k - i;
+                return;
+            }
+            size_t n = std::min(k - i, kBlockSamples);
+            std::memcpy(b->samples, s + i, n * sizeof(Sample));
+            b->end = false;
+            b->board = static_cast<uint8_t>(index);
+            b->n = static_cast<uint16_t>(n);
+            b->tick_hz = board.stream.tick_hz();
+            b->newtons = board.stream.newtons();
+            b->arrived = arrived;
+            blocks_.publish();
+        }
+    }
+
+    void report()
+    {
+        LinkReport* r = reports_.claim();
+        if (!r)
+            return; // the main thread is behind; it will get the next one
+        r->bytes = bytes_;
+        r->dropped = dropped_;
+        for (size_t i = 0; i < boards_.size(); i++) {
+            Board& b = *boards_[i];
+            r->boards[i] = {b.decoder.stats().crc_errors, b.decoder.stats().frames_lost,
+                            b.repeat.stats().recovered, b.samples, b.unsynced, b.replied,
+                            b.sync.drift_ppm(), b.sync.best_rtt_ns() / 1e6};
+        }
+        reports_.publish();
+    }
+
+    std::vector<std::unique_ptr<Board>>& boards_;
+    bool merging_;
+    bool repeating_;
+    SpscRing<Block>& blocks_;
+    SpscRing<LinkReport>& reports_;
+    uint8_t buf_[1 << 16];
+    uint64_t bytes_ = 0, dropped_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    unsigned baud = 115200;
+    double minutes = 15;
+    RunInfo info;
+    info.sample_rate_hz = 2400;
+    bool triggered = false;
+    bool repeating = true;
+    BurnDetectorConfig trigger;
+    unsigned port = 0;
+    const char* cal_path = nullptr;
+    double gain = 0, offset = 0;
+    bool have_gain = false, have_offset = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:m:r:i:C:g:o:n:tk:p:R")) != -1) {
+        switch (opt) {
+        case 'b': baud = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'm': minutes = std::atof(optarg); break;
+        case 'r': info.sample_rate_hz = std::atof(optarg); break;
+        case 'i': info.board_id = static_cast<uint32_t>(std::atoi(optarg)); break;
+        case 'C': cal_path = optarg; break;
+        case 'g': gain = std::atof(optarg); have_gain = true; break;
+        case 'o': offset = std::atof(optarg); have_offset = true; break;
+        case 'n': info.note = optarg; break;
+        case 't': triggered = true; break;
+        case 'k': trigger.start_sigmas = std::atof(optarg); break;
+        case 'p': port = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'R': repeating = false; break;
+        default: usage();
+        }
+    }
+    if (argc - optind < 2)
+        usage();
+    size_t nboards = static_cast<size_t>(argc - optind - 1);
+    bool merging = nboards > 1;
+    if (nboards > kMaxBoards || (merging && triggered)) {
+        std::fprintf(stderr, "tsacq: at most %zu devices, and -t takes only one\n", kMaxBoards);
+        return 2;
+    }
+
+    std::string cal_file = find_calibration(cal_path);
+    if (!cal_file.empty()) {
+        try {
+            info.cal = load_calibration(cal_file);
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "tsacq: %s\n", e.what());
+            return 1;
+        }
+        std::fprintf(stderr, "calibration %s: %.6g N per count, zero at %.1f counts, %u points\n",
+                     cal_file.c_str(), info.cal.gain, info.cal.offset, info.cal.points);
+        if (info.cal.board_id != info.board_id)
+            std::fprintf(stderr, "tsacq: warning: %s is for board %u, not %u\n", cal_file.c_str(),
+                         info.cal.board_id, info.board_id);
+    }
+    if (have_gain)
+        info.cal.gain = gain;
+    if (have_offset)
+        info.cal.offset = offset;
+
+    size_t second = static_cast<size_t>(info.sample_rate_hz);
+    trigger.baseline_window = trigger.pre = trigger.post = second;
+    trigger.polarity = info.cal.gain < 0 ? -1 : 1;
+    BurnDetector detector(trigger);
+
+    std::vector<std::unique_ptr<Board>> boards;
+    for (size_t b = 0; b < nboards; b++)
+        boards.push_back(std::make_unique<Board>(argv[optind + b], baud));
+    RunWriter out(argv[argc - 1], static_cast<uint64_t>(minutes * 60 * info.sample_rate_hz * nboards), info);
+    SampleMerger merger(nboards, kMergeLagNs + (repeating ? kRepeatLagNs : 0), kSilentNs);
+    // a single board's own samples, in its ticks, put back in order
+    SampleMerger reorder(1, 0, kSilentNs);
+    const int64_t start_ns = now_ns();
+    LivePlot plot(info);
+    std::optional<ViewServer> server;
+    if (port)
+        server.emplace(static_cast<uint16_t>(port), plot);
+    auto record = [&](int64_t t, int32_t v, uint8_t channel) {
+        out.append(t, v, channel);
+        if (server)
+            plot.append(channel, t, v);
+    };
+    auto write_merged = [&](const MergedSample& s) { record((s.t - start_ns) / 1000, s.value, s.source); };
+
+    // blocked before the reader starts, so it inherits the mask and the
+    // signals only ever show up on the signalfd
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+    int sfd = signalfd(-1, &mask, SFD_CLOEXEC);
+
+    SpscRing<Block> blocks(kRingBlocks * nboards);
+    SpscRing<LinkReport> reports(4);
+    Reader reader(boards, merging, repeating, blocks, reports);
+    std::thread reading([&] { reader.run(sfd); });
+    std::atomic<bool> done{false};
+    std::thread serving;
+    if (server) {
+        std::fprintf(stderr, "live plot on http://127.0.0.1:%u/\n", port);
+        serving = std::thread([&] { server->run(done); });
+    }
+
+    uint64_t last_bytes = 0, last_count = 0, last_samples[kMaxBoards] = {};
+    uint32_t tick_hz = merging ? 1000000 : boards[0]->stream.tick_hz();
+    uint32_t seen = 0, sends_newtons = 0; // bit per board
+    bool newtons = false, warned_mixed = false;
+    Calibration units = info.cal;
+    int64_t caught_up = start_ns; // arrival time of the newest block taken
+    auto repeat_lag = [&](uint32_t hz) {
+        return repeating ? static_cast<int64_t>(kRepeatLagNs * 1e-9 * hz) : int64_t{0};
+    };
+    out.set_tick_hz(tick_hz);
+    plot.set_tick_hz(tick_hz);
+    reorder.set_lag(repeat_lag(tick_hz));
+    // one sample of a single board, in order
+    auto take = [&](const MergedSample& s) {
+        if (!triggered) {
+            record(s.t, s.value, s.source);
+            return;
+        }
+        if (s.source != 0)
+            return; // burns are found and kept on the load cell alone
+        detector.push(
+            Sample{s.t, s.value, 0}, [&](const Sample& k) { record(k.t, k.value, 0); },
+            [&](BurnEvent ev, const BurnInfo& burn) {
+                double hz = tick_hz;
+                if (ev == BurnEvent::Start) {
+                    std::fprintf(stderr, "burn started at %.3f s\n", burn.start_t / hz);
+                    return;
+                }
+                out.flush();
+                std::fprintf(stderr,
+                             "burn ended: %.3f s, peak %.2f N over baseline, %" PRIu64
+                             " samples kept\n",
+                             (burn.end_t - burn.start_t) / hz,
+                             units.newtons(burn.peak) - units.newtons(burn.baseline_mean), burn.kept);
+            });
+    };
+
+    for (;;) {
+        if (LinkReport* r = reports.peek()) {
+            std::fprintf(stderr,
+                         "%" PRIu64 " samples (+%" PRIu64 "), %" PRIu64 " B/s, %" PRIu64
+                         " dropped, ring %zu of %zu deep, %" PRIu64 " past capacity\n",
+                         out.count(), out.count() - last_count, r->bytes - last_bytes, r->dropped,
+                         blocks.high_water(), blocks.capacity(), out.dropped());
+            for (size_t i = 0; i < nboards; i++) {
+                const auto& s = r->boards[i];
+                std::fprintf(stderr, "  %s: +%" PRIu64 " samples, %" PRIu64 " crc errors, %" PRIu64
+                                     " frames lost",
+                             boards[i]->port.path().c_str(), s.samples - last_samples[i], s.crc_errors,
+                             s.frames_lost);
+                if (merging)
+                    std::fprintf(stderr, ", %s, drift %+.1f ppm, best round trip %.2f ms, %" PRIu64
+                                         " before sync",
+                                 s.replied ? "synced" : "not synced", s.drift_ppm, s.rtt_ms, s.unsynced);
+                if (repeating)
+                    std::fprintf(stderr, ", %" PRIu64 " sent again", s.recovered);
+                std::fputc('\n', stderr);
+                last_samples[i] = s.samples;
+            }
+            last_bytes = r->bytes;
+            last_count = out.count();
+            reports.release();
+        }
+        Block* b = blocks.peek();
+        if (!b) {
+            if (merging)
+                merger.drain(now_ns(), write_merged); // nothing is waiting, so now is as far as anyone got
+            else
+                reorder.drain(now_ns(), take);
+            usleep(1000);
+            continue;
+        }
+        if (b->end) {
+            blocks.release();
+            break;
+        }
+        // a board that applies its own calibration sends mN; the run is in
+        // those units only while every board seen so far does
+        seen |= 1u << b->board;
+        if (b->newtons)
+            sends_newtons |= 1u << b->board;
+        else
+            sends_newtons &= ~(1u << b->board);
+        if (sends_newtons && sends_newtons != seen && !warned_mixed) {
+            std::fprintf(stderr, "tsacq: warning: some boards send newtons and some counts; recording counts\n");
+            warned_mixed = true;
+        }
+        if ((sends_newtons == seen) != newtons) {
+            newtons = !newtons;
+            units = newtons ? milli_newtons() : info.cal;
+            out.set_calibration(units);
+            plot.set_calibration(units);
+            trigger.polarity = units.gain < 0 ? -1 : 1;
+            detector = BurnDetector(trigger);
+            std::fprintf(stderr, "board sends %s\n", newtons ? "milli-newtons" : "counts");
+        }
+        if (merging) {
+            uint8_t source = static_cast<uint8_t>(b->board << 4);
+            for (size_t i = 0; i < b->n; i++) {
+                const Sample& s = b->samples[i];
+                merger.push(b->board, {s.t, s.value, static_cast<uint8_t>(source | (s.channel & 15))},
+                            b->arrived);
+            }
+            // drained as of when the block came in: a backlog in the ring
+            // must not look like a silent board to the merger
+            caught_up = b->arrived;
+            blocks.release();
+            merger.drain(caught_up, write_merged);
+            continue;
+        }
+        if (b->tick_hz != tick_hz) {
+            tick_hz = b->tick_hz;
+            out.set_tick_hz(tick_hz);
+            plot.set_tick_hz(tick_hz);
+            reorder.set_lag(repeat_lag(tick_hz));
+        }
+        for (size_t i = 0; i < b->n; i++) {
+            const Sample& s = b->samples[i];
+            reorder.push(0, {s.t, s.value, s.channel}, b->arrived);
+        }
+        int64_t arrived = b->arrived;
+        blocks.release();
+        reorder.drain(arrived, take);
+    }
+
+    reading.join();
+    done = true;
+    if (serving.joinable())
+        serving.join();
+    if (merging)
+        merger.finish(write_merged);
+    else
+        reorder.finish(take);
+    out.close();
+    return 0;
+}
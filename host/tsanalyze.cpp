@@ -0,0 +1,147 @@
+// Thrust curve statistics for a recorded run. Replaces the processing half
+// of convertToLoadAndPlotMk2.m; see thrust.hpp for the pipeline.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tsanalyze [-C calibration] [-g newtons_per_count] [-o zero_counts]
+//                  [-k sigmas] [-p pad] [-n input] [-c curve.csv] run.tsr
+//
+// Calibration defaults to the record the run was taken with, in the run
+// file's header; -C loads another record (calibration.hpp), and -g and -o
+// replace the gain and offset. A temperature term is applied with the
+// temperature input's mean over the run. -c writes the isolated burn
+// as time_s,force_n for plotting. A run from a multiplexed board is
+// analyzed on input 0, the load cell, unless -n picks another.
+#include "runfile.hpp"
+#include "thrust.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <unistd.h>
+#include <vector>
+
+using namespace tsstand;
+
+namespace {
+
+void usage()
+{
+    std::fprintf(stderr, "usage: tsanalyze [-C calibration] [-g newtons_per_count] [-o zero_counts]\n"
+                         "                 [-k sigmas] [-p pad] [-n input] [-c curve.csv] run.tsr\n");
+    std::exit(2);
+}
+
+void write_curve(const char* path, const int64_t* t, const int32_t* raw, const AnalysisConfig& cfg,
+                 const BurnStats& st)
+{
+    FILE* out = std::fopen(path, "w");
+    if (!out) {
+        std::perror(path);
+        return;
+    }
+    double zero = cfg.tare ? cfg.cal.newtons(raw[0], cfg.temp) : 0;
+    std::fprintf(out, "time_s,force_n\n");
+    for (size_t i = st.burn_start; i <= st.burn_end; i++) {
+        std::fprintf(out, "%.6f,%.4f\n", static_cast<double>(t[i] - t[0]) / cfg.tick_hz,
+                     cfg.cal.newtons(raw[i], cfg.temp) - zero);
+    }
+    std::fclose(out);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    AnalysisConfig cfg;
+    double gain = 0, offset = 0;
+    bool have_gain = false, have_offset = false;
+    const char* cal_path = nullptr;
+    const char* curve = nullptr;
+    int input = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "C:g:o:k:p:n:c:")) != -1) {
+        switch (opt) {
+        case 'C': cal_path = optarg; break;
+        case 'g': gain = std::atof(optarg); have_gain = true; break;
+        case 'o': offset = std::atof(optarg); have_offset = true; break;
+        case 'k': cfg.trigger_sigmas = std::atof(optarg); break;
+        case 'p': cfg.pad = static_cast<size_t>(std::atol(optarg)); break;
+        case 'n': input = std::atoi(optarg); break;
+        case 'c': curve = optarg; break;
+        default: usage();
+        }
+    }
+    if (argc - optind != 1)
+        usage();
+
+    try {
+        RunFile run(argv[optind]);
+        const RunHeader& h = run.header();
+        cfg.cal = cal_path ? load_calibration(cal_path) : header_calibration(h);
+        if (have_gain)
+            cfg.cal.gain = gain;
+        if (have_offset)
+            cfg.cal.offset = offset;
+        cfg.tick_hz = h.tick_hz;
+
+        auto t0 = std::chrono::steady_clock::now();
+        const int64_t* t = run.times();
+        const int32_t* raw = run.samples();
+        size_t n = run.size();
+        std::vector<int64_t> input_t;
+        std::vector<int32_t> input_raw;
+        // the temperature input of the same board
+        int temp_channel = cfg.cal.temp_input >= 0 ? (input & ~15) | cfg.cal.temp_input : -1;
+        RunningStats temp;
+        if (run.channels() || input != 0) {
+            // pull the one input out of the interleaved columns
+            for (size_t i = 0; i < n; i++) {
+                if (run.channel(i) == input) {
+                    input_t.push_back(t[i]);
+                    input_raw.push_back(raw[i]);
+                } else if (run.channel(i) == temp_channel) {
+                    temp.add(raw[i]);
+                }
+            }
+            if (input_t.size() != n) {
+                t = input_t.data();
+                raw = input_raw.data();
+                n = input_t.size();
+            }
+        }
+        if (temp.count()) {
+            cfg.temp = temp.mean();
+        } else if (cfg.cal.temp_gain != 0) {
+            std::fprintf(stderr, "no readings of input %d; leaving out the temperature term\n", temp_channel);
+            cfg.cal.temp_gain = 0;
+        }
+        ThrustAnalyzer analyzer(cfg);
+        analyzer.push(t, raw, n);
+        BurnStats st = analyzer.finish();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        std::printf("samples            %zu (%zu outliers replaced)\n", st.samples, st.outliers_replaced);
+        std::printf("maxForceSingle     %.4f N\n", st.max_force);
+        std::printf("maxForceMean       %.4f N\n", st.max_force_mean);
+        std::printf("maxForceMedian     %.4f N\n", st.max_force_median);
+        if (st.burn_found) {
+            std::printf("threshold          %.4f N\n", st.threshold);
+            std::printf("ignition           %.6f s (sample %zu)\n", st.ignition, st.first_above);
+            std::printf("avgForce           %.4f N\n", st.avg_force);
+            std::printf("timeStepSize       %.6f s\n", st.time_step);
+            std::printf("impulseTotal       %.4f N s\n", st.impulse);
+            std::printf("burnTime           %.6f s\n", st.burn_time);
+        } else {
+            std::printf("no burn above %.4f N\n", st.threshold);
+        }
+        std::fprintf(stderr, "analyzed in %.1f ms\n", ms);
+
+        if (curve && st.burn_found)
+            write_curve(curve, t, raw, cfg, st);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
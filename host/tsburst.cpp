@@ -0,0 +1,117 @@
+// Runs the firmware trigger and burst capture (burst.c, compiled for the
+// host) against synthetic ADC streams and checks the windows it captures.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tsburst        prints one line per case and exits nonzero if any fails
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "burst.h"
+}
+
+namespace {
+
+constexpr uint32_t kTicksPerConversion = 218; // 24 MHz bus clock, ~110 ksps
+
+struct Signal {
+    std::vector<int16_t> x;
+    std::vector<uint32_t> t;
+};
+
+// noise around base, jumping to base + step at conversion `at`
+Signal step(size_t n, size_t at, double base, double step, uint32_t t0 = 0)
+{
+    Signal s;
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(0.0, 20.0);
+    for (size_t i = 0; i < n; i++) {
+        s.x.push_back(static_cast<int16_t>(std::lround(base + (i >= at ? step : 0) + noise(rng))));
+        s.t.push_back(t0 + static_cast<uint32_t>(i * kTicksPerConversion));
+    }
+    return s;
+}
+
+// feeds the signal in capture-sized blocks the way main.c does and returns
+// the conversion index at which the window completed, or -1
+long run(burst_t* b, const Signal& s)
+{
+    size_t i = 0;
+    while (i < s.x.size()) {
+        uint16_t n = static_cast<uint16_t>(std::min<size_t>(256, s.x.size() - i));
+        uint16_t used = burst_Push(b, &s.x[i], &s.t[i], n);
+        if (b->state == BURST_READY)
+            return static_cast<long>(i + used - 1);
+        i += n;
+    }
+    return -1;
+}
+
+int failures = 0;
+
+void check(bool ok, const char* what)
+{
+    std::printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    failures += !ok;
+}
+
+// every sample of the window is the input it claims to be, with its time
+bool window_matches(const burst_t* b, const Signal& s, size_t trigger, size_t stride)
+{
+    for (uint16_t i = 0; i < burst_Count(b); i++) {
+        long src = static_cast<long>(trigger) + (static_cast<long>(i) - b->pre) * static_cast<long>(stride);
+        if (src < 0 || burst_Get(b, i) != s.x[src])
+            return false;
+        int64_t want = static_cast<int64_t>(s.t[src]) - s.t[trigger];
+        if (std::llabs(burst_Offset(b, i) - want) > 1)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    static burst_t b;
+
+    burst_Init(&b, 1000, 3000, 1, 2000, BURST_RISING);
+    burst_Arm(&b);
+    check(run(&b, step(200000, 1u << 30, 0, 0)) < 0 && b.state == BURST_ARMED, "noise alone never triggers");
+
+    Signal s = step(20000, 5000, 0, 4000, 0xFFFF0000u); // the timebase wraps inside the window
+    burst_Arm(&b);
+    long done = run(&b, s);
+    check(done == 5000 + 3000 - 1, "window completes post samples after the step");
+    check(burst_Count(&b) == 4000 && burst_Get(&b, b.pre) == s.x[5000], "trigger sample sits at index pre");
+    check(window_matches(&b, s, 5000, 1), "window holds the input around the trigger, times across the wrap");
+    check(burst_Push(&b, s.x.data(), s.t.data(), 10) == 10 && burst_Count(&b) == 4000,
+          "a ready window is left alone until re-armed");
+
+    burst_Arm(&b);
+    check(run(&b, step(20000, 0, 0, 4000)) < 0, "a signal already past the level does not trigger");
+    burst_Arm(&b);
+    check(run(&b, step(20000, 500, 0, 4000)) < 0, "no trigger before the pre-trigger window is full");
+
+    burst_Init(&b, 500, 500, 8, 2000, BURST_RISING);
+    burst_Arm(&b);
+    s = step(40000, 20003, 0, 4000);
+    done = run(&b, s);
+    // with stride 8 the first kept conversion past the step is 20008
+    check(done == 20008 + 499 * 8, "stride keeps one conversion in eight");
+    check(window_matches(&b, s, 20008, 8), "strided window matches the input");
+
+    burst_Init(&b, 100, 100, 1, -2000, BURST_FALLING);
+    burst_Arm(&b);
+    s = step(5000, 3000, 0, -4000);
+    done = run(&b, s);
+    check(done == 3099 && window_matches(&b, s, 3000, 1), "falling trigger");
+
+    burst_Init(&b, 60000, 60000, 1, 0, BURST_RISING);
+    check(b.pre + b.post == BURST_CAPACITY, "oversized windows are clamped to the ring");
+
+    std::printf("%d failure%s\n", failures, failures == 1 ? "" : "s");
+    return failures != 0;
+}
@@ -0,0 +1,244 @@
+// Calibrates the load cell against known weights and writes the
+// calibration record the other tools load. Replaces calibrationGUI.m.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tscal [-b baud] [-i board_id] [-n input] [-d degree] [-T temp_input]
+//              [-s counts] [-w seconds] [-N note] [-o record.cal] [-E [-u]] device
+//        tscal [-b baud] -l record.cal [-u] device
+//        tscal [-b baud] -q device
+//
+// For each weight put on the stand, type its mass in kg. The reading is
+// averaged until the standard error of its mean is under -s counts (or for
+// -w seconds at most, as the script did), and the fit is redone with the
+// new point and printed. A blank line or end of input writes the record,
+// to ./tsstand.cal unless -o says otherwise. -d fits a polynomial of that
+// degree rather than a line, and -T adds a term for the reading of another
+// board input, such as a temperature sensor.
+//
+// -E also stores the linear part of the fit in the board's EEPROM, and -l
+// stores an existing record there without measuring; -u with either has
+// the board send milli-newtons from then on. -q prints what the board
+// holds. A board already sending milli-newtons cannot be calibrated: store
+// its record again without -u first.
+#include "calibration.hpp"
+#include "frame_decoder.hpp"
+#include "serial_port.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace tsstand;
+
+namespace {
+
+constexpr double kStandardGravity = 9.80665; // m/s^2
+constexpr uint64_t kMinSamples = 100;
+constexpr int kCalTries = 3;
+constexpr int kCalReplyMs = 1000;
+
+void usage()
+{
+    std::fprintf(stderr, "usage: tscal [-b baud] [-i board_id] [-n input] [-d degree] [-T temp_input]\n"
+                         "             [-s counts] [-w seconds] [-N note] [-o record.cal] [-E [-u]] device\n"
+                         "       tscal [-b baud] -l record.cal [-u] device\n"
+                         "       tscal [-b baud] -q device\n");
+    std::exit(2);
+}
+
+// Reads the board until the reading of input has settled.
+bool settle(const SerialPort& port, int input, int temp_input, double tolerance, double seconds,
+            RunningStats& reading, RunningStats& temp)
+{
+    // only what the board sends from now on, as flushinput did
+    tcflush(port.fd(), TCIFLUSH);
+    FrameDecoder decoder;
+    SampleStream stream;
+    Sample samples[SampleStream::kMaxSamplesPerFrame];
+    uint8_t buf[4096];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (reading.count() >= kMinSamples && reading.sem() <= tolerance)
+            return true;
+        pollfd p = {port.fd(), POLLIN, 0};
+        if (poll(&p, 1, 100) <= 0)
+            continue;
+        ssize_t got = read(port.fd(), buf, sizeof buf);
+        if (got <= 0)
+            continue;
+        decoder.feed(buf, static_cast<size_t>(got), [&](const Frame& f) {
+            size_t n = stream.decode(f, samples);
+            if (stream.newtons())
+                throw std::runtime_error("the board sends milli-newtons; store its calibration without -u first");
+            for (size_t i = 0; i < n; i++) {
+                if (samples[i].channel == input)
+                    reading.add(samples[i].value);
+                else if (samples[i].channel == temp_input)
+                    temp.add(samples[i].value);
+            }
+        });
+    }
+    return false;
+}
+
+// Sends a CAL request, a store if store is set and a query if not, and
+// waits for the board's reply.
+BoardCalibration exchange(const SerialPort& port, const BoardCalibration* store)
+{
+    uint8_t payload[kBoardCalRequestSize], frame[kFrameMaxSize], buf[4096];
+    size_t len = store ? encode_board_calibration(*store, payload) : 0;
+    size_t n = encode_frame(kFrameTypeCal, 0, payload, static_cast<uint8_t>(len), frame);
+    for (int tries = 0; tries < kCalTries; tries++) {
+        tcflush(port.fd(), TCIFLUSH);
+        if (write(port.fd(), frame, n) != static_cast<ssize_t>(n))
+            throw std::runtime_error(port.path() + ": " + std::strerror(errno));
+        FrameDecoder decoder;
+        BoardCalibration reply;
+        bool got_reply = false;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kCalReplyMs);
+        while (!got_reply && std::chrono::steady_clock::now() < deadline) {
+            pollfd p = {port.fd(), POLLIN, 0};
+            if (poll(&p, 1, 100) <= 0)
+                continue;
+            ssize_t got = read(port.fd(), buf, sizeof buf);
+            if (got <= 0)
+                continue;
+            decoder.feed(buf, static_cast<size_t>(got), [&](const Frame& f) {
+                if (f.type == kFrameTypeCal && decode_board_calibration(f.payload, f.len, reply))
+                    got_reply = true;
+            });
+        }
+        if (got_reply)
+            return reply;
+    }
+    throw std::runtime_error(port.path() + ": no calibration reply from the board");
+}
+
+void print_board(const BoardCalibration& b)
+{
+    static const char* const status[] = {"stored", "write failed", "none stored"};
+    Calibration cal = from_board(b);
+    std::printf("board %u: %s, seq %u, %.9g N per count, zero at %.0f counts, sends %s\n", b.board_id,
+                b.status < 3 ? status[b.status] : "unknown status", b.seq, cal.gain, cal.offset,
+                b.flags & kBoardNewtons ? "milli-newtons" : "counts");
+}
+
+// Stores the linear part of cal on the board. False if it did not take.
+bool store(const SerialPort& port, const Calibration& cal, bool newtons)
+{
+    if (!cal.linear())
+        std::fprintf(stderr, "tscal: warning: the board keeps only the gain and offset of this record\n");
+    BoardCalibration want = to_board(cal, newtons);
+    BoardCalibration got = exchange(port, &want);
+    print_board(got);
+    return got.status == 0 && got.gain == want.gain && got.offset == want.offset && got.flags == want.flags;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    unsigned baud = 115200;
+    Calibration cal;
+    int input = 0;
+    unsigned degree = 1;
+    double tolerance = 0.1, seconds = 10;
+    const char* path = kCalDefaultPath;
+    const char* load = nullptr;
+    bool eeprom = false, newtons = false, query = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:i:n:d:T:s:w:N:o:El:uq")) != -1) {
+        switch (opt) {
+        case 'b': baud = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'i': cal.board_id = static_cast<uint32_t>(std::atoi(optarg)); break;
+        case 'n': input = std::atoi(optarg); break;
+        case 'd': degree = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'T': cal.temp_input = std::atoi(optarg); break;
+        case 's': tolerance = std::atof(optarg); break;
+        case 'w': seconds = std::atof(optarg); break;
+        case 'N': cal.note = optarg; break;
+        case 'o': path = optarg; break;
+        case 'E': eeprom = true; break;
+        case 'l': load = optarg; break;
+        case 'u': newtons = true; break;
+        case 'q': query = true; break;
+        default: usage();
+        }
+    }
+    if (argc - optind != 1 || degree < 1 || degree > 3 || (newtons && !eeprom && !load) || (query && load))
+        usage();
+
+    try {
+        SerialPort port(argv[optind], baud);
+        if (query) {
+            print_board(exchange(port, nullptr));
+            return 0;
+        }
+        if (load)
+            return store(port, load_calibration(load), newtons) ? 0 : 1;
+        Calibrator calibrator(degree, cal.temp_input >= 0);
+        bool fitted = false;
+        char line[128];
+        for (;;) {
+            std::fprintf(stderr, "load in kg (blank to finish): ");
+            if (!std::fgets(line, sizeof line, stdin) || line[0] == '\n')
+                break;
+            char* end;
+            double kg = std::strtod(line, &end);
+            if (end == line) {
+                std::fprintf(stderr, "not a number\n");
+                continue;
+            }
+
+            RunningStats reading, temp;
+            bool settled = settle(port, input, cal.temp_input, tolerance, seconds, reading, temp);
+            if (reading.count() < 2) {
+                std::fprintf(stderr, "no readings of input %d\n", input);
+                continue;
+            }
+            if (cal.temp_input >= 0 && temp.count() == 0) {
+                std::fprintf(stderr, "no readings of input %d\n", cal.temp_input);
+                continue;
+            }
+            std::fprintf(stderr, "  %" PRIu64 " samples, mean %.3f counts, std %.3f, error of mean %.4f%s\n",
+                         reading.count(), reading.mean(), reading.stddev(), reading.sem(),
+                         settled ? "" : " (did not settle)");
+            if (cal.temp_input >= 0)
+                std::fprintf(stderr, "  input %d mean %.3f counts\n", cal.temp_input, temp.mean());
+
+            calibrator.add(kg * kStandardGravity, reading.mean(), temp.mean());
+            fitted = calibrator.fit(cal);
+            if (!fitted)
+                continue;
+            std::fprintf(stderr, "  fit of %u points: %.9g N per count, zero at %.3f counts, rms %.4g N\n",
+                         cal.points, cal.gain, cal.offset, cal.rms);
+            if (degree > 1)
+                std::fprintf(stderr, "  %.6g N per count^2, %.6g N per count^3\n", cal.square, cal.cube);
+            if (cal.temp_input >= 0)
+                std::fprintf(stderr, "  %.6g N per count of input %d from %.3f\n", cal.temp_gain,
+                             cal.temp_input, cal.temp_ref);
+        }
+        if (!fitted) {
+            std::fprintf(stderr, "tscal: not enough points for a fit; nothing written\n");
+            return 1;
+        }
+        cal.made_unix = static_cast<int64_t>(std::time(nullptr));
+        save_calibration(path, cal);
+        std::printf("%s\n", path);
+        if (eeprom && !store(port, cal, newtons))
+            return 1;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "tscal: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
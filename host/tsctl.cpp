@@ -0,0 +1,145 @@
+// Changes the board's settings while it runs, instead of editing acquire.h
+// and reflashing: the output rate, the adc configuration, frames or text,
+// and the burst trigger (see command.h in the firmware).
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tsctl -l
+//        tsctl [-b baud] device [setting[=value]]...
+//
+// -l lists the settings. With a device, each setting=value is sent in
+// turn and the value the board then has is printed; a bare setting, or no
+// settings at all, prints the board's current values. Settings are named
+// as -l prints them or by number. Exits nonzero if any was refused.
+#include "command.hpp"
+#include "frame_decoder.hpp"
+#include "serial_port.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace tsstand;
+
+namespace {
+
+constexpr int kTries = 3;
+constexpr int kReplyMs = 500;
+
+void usage()
+{
+    std::fprintf(stderr, "usage: tsctl -l\n"
+                         "       tsctl [-b baud] device [setting[=value]]...\n");
+    std::exit(2);
+}
+
+void list()
+{
+    for (const CommandInfo& c : kCommands)
+        std::printf("%-14s %u  %d to %d, %d at reset: %s\n", command_name(c).c_str(), c.id, c.min, c.max,
+                    c.initial, c.help);
+}
+
+// Sends a command frame and waits for the board's answer to it.
+CommandReply exchange(const SerialPort& port, uint8_t id, const int32_t* value)
+{
+    uint8_t payload[kCommandRequestSize], frame[kFrameMaxSize], buf[4096];
+    size_t len = encode_command(id, value, payload);
+    size_t n = encode_frame(kFrameTypeCommand, 0, payload, static_cast<uint8_t>(len), frame);
+    for (int tries = 0; tries < kTries; tries++) {
+        tcflush(port.fd(), TCIFLUSH);
+        if (write(port.fd(), frame, n) != static_cast<ssize_t>(n))
+            throw std::runtime_error(port.path() + ": " + std::strerror(errno));
+        FrameDecoder decoder;
+        CommandReply reply;
+        bool got_reply = false;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kReplyMs);
+        while (!got_reply && std::chrono::steady_clock::now() < deadline) {
+            pollfd p = {port.fd(), POLLIN, 0};
+            if (poll(&p, 1, 100) <= 0)
+                continue;
+            ssize_t got = read(port.fd(), buf, sizeof buf);
+            if (got <= 0)
+                continue;
+            // in text mode the reply is the one frame among the lines
+            decoder.feed(buf, static_cast<size_t>(got), [&](const Frame& f) {
+                if (f.type == kFrameTypeCommand && decode_command_reply(f.payload, f.len, reply) && reply.id == id)
+                    got_reply = true;
+            });
+        }
+        if (got_reply)
+            return reply;
+    }
+    throw std::runtime_error(port.path() + ": no reply from the board");
+}
+
+// Sends one "setting" or "setting=value" argument. False if the board
+// refused it.
+bool send(const SerialPort& port, const std::string& arg)
+{
+    size_t eq = arg.find('=');
+    const CommandInfo* c = find_command(arg.substr(0, eq));
+    if (!c) {
+        std::fprintf(stderr, "tsctl: no setting %s (tsctl -l lists them)\n", arg.substr(0, eq).c_str());
+        return false;
+    }
+    int32_t value = 0;
+    if (eq != std::string::npos) {
+        char* end;
+        long v = std::strtol(arg.c_str() + eq + 1, &end, 0);
+        if (end == arg.c_str() + eq + 1 || *end) {
+            std::fprintf(stderr, "tsctl: %s: not a number\n", arg.c_str());
+            return false;
+        }
+        if (v < c->min || v > c->max) {
+            std::fprintf(stderr, "tsctl: %s must be %d to %d\n", command_name(*c).c_str(), c->min, c->max);
+            return false;
+        }
+        value = static_cast<int32_t>(v);
+    }
+    CommandReply r = exchange(port, c->id, eq == std::string::npos ? nullptr : &value);
+    std::printf("%s %d", command_name(*c).c_str(), r.value);
+    if (r.status != COMMAND_OK)
+        std::printf(" (%s)", command_status(r.status));
+    std::putchar('\n');
+    return r.status == COMMAND_OK;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    unsigned baud = 115200;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:l")) != -1) {
+        switch (opt) {
+        case 'b': baud = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'l': list(); return 0;
+        default: usage();
+        }
+    }
+    if (argc - optind < 1)
+        usage();
+
+    bool ok = true;
+    try {
+        SerialPort port(argv[optind], baud);
+        if (argc - optind == 1) {
+            for (const CommandInfo& c : kCommands)
+                ok &= send(port, c.name);
+        }
+        for (int i = optind + 1; i < argc; i++)
+            ok &= send(port, argv[i]);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "tsctl: %s\n", e.what());
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
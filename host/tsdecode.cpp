@@ -0,0 +1,77 @@
+// Converts a raw capture of the binary sample stream into CSV
+// (time in seconds, raw reading, board input) that MATLAB can load with
+// readmatrix.
+// Decoder statistics, including dropped and corrupted frames, go to stderr,
+// with how many samples came at a board's idle rate (activity.h), then the
+// firmware's loop profile if the capture has telemetry. Frames the board
+// sent again on request (repeat.hpp) arrive late; their samples are put
+// back in time order.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tsdecode [capture.bin] > run.csv
+#include "frame_decoder.hpp"
+#include "merge.hpp"
+#include "telemetry.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+
+using namespace tsstand;
+
+int main(int argc, char** argv)
+{
+    FILE* in = stdin;
+    if (argc > 1 && !(in = std::fopen(argv[1], "rb"))) {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    FrameDecoder decoder;
+    SampleStream stream;
+    // ordered in the board's ticks; frames come back within 3 s
+    SampleMerger reorder(1, 0, INT64_MAX);
+    Telemetry telemetry;
+    Sample samples[SampleStream::kMaxSamplesPerFrame];
+    uint64_t count = 0, idle = 0;
+    uint8_t buf[1 << 16];
+    size_t n;
+
+    auto print = [&](const MergedSample& s) {
+        std::printf("%.6f,%" PRId32 ",%u\n", static_cast<double>(s.t) / stream.tick_hz(), s.value, s.source);
+    };
+    std::printf("time_s,reading,input\n");
+    while ((n = std::fread(buf, 1, sizeof buf, in)) > 0) {
+        decoder.feed(buf, n, [&](const Frame& f) {
+            if (telemetry.add(f))
+                return;
+            size_t got = stream.decode(f, samples);
+            reorder.set_lag(3 * static_cast<int64_t>(stream.tick_hz()));
+            for (size_t i = 0; i < got; i++)
+                reorder.push(0, {samples[i].t, samples[i].value, samples[i].channel}, 0);
+            if (got)
+                reorder.drain(0, print);
+            count += got;
+            if (stream.rate().idle)
+                idle += got;
+        });
+    }
+
+    reorder.finish(print);
+
+    const DecoderStats& s = decoder.stats();
+    std::fprintf(stderr,
+                 "%" PRIu64 " samples in %" PRIu64 " frames, %" PRIu64 " crc errors, %" PRIu64
+                 " frames lost in %" PRIu64 " gaps, %" PRIu64 " out of order, %" PRIu64 " sent again, %" PRIu64
+                 " bytes skipped\n",
+                 count, s.frames, s.crc_errors, s.frames_lost, s.seq_gaps, s.seq_behind, s.resent, s.bytes_skipped);
+    if (stream.rate().period > 0)
+        std::fprintf(stderr, "%" PRIu64 " samples at the idle rate, %" PRIu64 " changes of rate\n", idle,
+                     stream.rate_changes());
+    if (stream.refused())
+        std::fprintf(stderr, "the board sends protocol version %u, newer than this tsdecode's %u;"
+                             " its samples were skipped\n",
+                     stream.version(), kFrameVersion);
+    if (telemetry.reports)
+        telemetry.print(stderr);
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Runs the firmware decimation filter (decimate.c, compiled for the host)
+// next to the reference in decimate_ref.cpp and reports any output that
+// differs, or prints the chain's frequency response.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tsfilter [raw.txt]     compare on raw ADC counts, one per line
+//                               (a synthetic signal when no file is given)
+//        tsfilter --response    gain in dB from 0 Hz to the input Nyquist
+#include "decimate_ref.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "decimate.h"
+}
+
+using namespace tsstand;
+
+static constexpr double kAdcRate = 110000.0;
+
+// steps, a slow chirp and noise, clipped to the 16 bit result range
+static std::vector<int32_t> synthetic(size_t n)
+{
+    std::vector<int32_t> x(n);
+    std::mt19937 rng(1);
+    std::normal_distribution<double> noise(0.0, 200.0);
+    for (size_t i = 0; i < n; i++) {
+        double t = i / kAdcRate;
+        double v = (i / 20000 % 2 ? 20000.0 : -12000.0) +
+                   8000.0 * std::sin(2 * M_PI * (10.0 + 400.0 * t) * t) + noise(rng);
+        x[i] = static_cast<int32_t>(std::fmax(-32768.0, std::fmin(32767.0, v)));
+    }
+    return x;
+}
+
+int main(int argc, char** argv)
+{
+    DecimateRef ref;
+
+    if (argc > 1 && std::strcmp(argv[1], "--response") == 0) {
+        for (double f = 0; f <= kAdcRate / 2; f += (f < 5000 ? 50.0 : 1000.0))
+            std::printf("%8.0f Hz %8.2f dB\n", f,
+                        20 * std::log10(std::fmax(ref.response(f, kAdcRate), 1e-12)));
+        return 0;
+    }
+
+    std::vector<int32_t> x;
+    if (argc > 1) {
+        FILE* in = std::fopen(argv[1], "r");
+        if (!in) {
+            std::perror(argv[1]);
+            return 1;
+        }
+        long v;
+        while (std::fscanf(in, "%ld", &v) == 1)
+            x.push_back(static_cast<int32_t>(v));
+        std::fclose(in);
+    } else {
+        x = synthetic(2000000);
+    }
+
+    std::vector<int32_t> fw;
+    decimate_t d;
+    decimate_Init(&d);
+    for (int32_t v : x) {
+        int32_t out;
+        if (decimate_Push(&d, v, &out))
+            fw.push_back(out);
+    }
+    std::vector<int32_t> want = ref.run(x);
+
+    size_t bad = (fw.size() == want.size()) ? 0 : 1;
+    for (size_t i = 0; i < fw.size() && i < want.size(); i++) {
+        if (fw[i] != want[i] && bad++ < 10)
+            std::printf("output %zu: firmware %d, reference %d\n", i, fw[i], want[i]);
+    }
+    std::printf("%zu inputs, %zu outputs (reference %zu), %zu mismatches\n", x.size(),
+                fw.size(), want.size(), bad);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+// Checks the firmware's text formatter (textfmt.c, compiled for the host)
+// against snprintf, and times the two.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tsfmt          every reading the stream can carry (24 bits), every
+//                       millisecond of the first 2^24 ms, 10 million random
+//                       values and the digit-count edges; exits nonzero on
+//                       the first mismatch
+//        tsfmt --all    all 2^32 values of both formatters (about 15 minutes)
+//        tsfmt --bench  ns per line for textfmt_Line and snprintf
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "textfmt.h"
+}
+
+namespace {
+
+uint64_t checked = 0;
+
+void fail(const char* what, const char* want, const char* got)
+{
+    std::printf("FAIL %s: snprintf \"%s\", textfmt \"%s\"\n", what, want, got);
+    std::exit(1);
+}
+
+void check_u32(uint32_t v)
+{
+    char want[16], got[16];
+    int n = std::snprintf(want, sizeof want, "%" PRIu32, v);
+    uint8_t m = textfmt_U32(got, v);
+    got[m] = '\0';
+    if (m != n || std::memcmp(want, got, m) != 0)
+        fail("u32", want, got);
+    checked++;
+}
+
+void check_i32(int32_t v)
+{
+    char want[16], got[16];
+    int n = std::snprintf(want, sizeof want, "%" PRId32, v);
+    uint8_t m = textfmt_I32(got, v);
+    got[m] = '\0';
+    if (m != n || std::memcmp(want, got, m) != 0)
+        fail("i32", want, got);
+    checked++;
+}
+
+void check_line(uint64_t us, int32_t reading)
+{
+    char want[32], got[32];
+    int n = std::snprintf(want, sizeof want, "%" PRIu32 ":%" PRId32 "\r\n",
+                          static_cast<uint32_t>(us / 1000), reading);
+    uint8_t m = textfmt_Line(got, textfmt_Millis(us), reading);
+    got[m] = '\0';
+    if (m != n || m > TEXTFMT_LINE_MAX || std::memcmp(want, got, m) != 0)
+        fail("line", want, got);
+    checked++;
+}
+
+void bench()
+{
+    constexpr int kLines = 10000000;
+    std::mt19937 rng(3);
+    std::vector<int32_t> readings(4096);
+    for (int32_t& r : readings)
+        r = static_cast<int32_t>(rng() % (1u << 24)) - (1 << 23);
+    char buf[32];
+    unsigned sink = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLines; i++) {
+        uint64_t us = 418ull * i;
+        sink += textfmt_Line(buf, textfmt_Millis(us), readings[i & 4095]);
+        sink += static_cast<unsigned char>(buf[0]);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLines; i++) {
+        uint64_t us = 418ull * i;
+        sink += std::snprintf(buf, sizeof buf, "%ld:%ld\r\n", static_cast<long>(us / 1000),
+                              static_cast<long>(readings[i & 4095]));
+        sink += static_cast<unsigned char>(buf[0]);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::nano> a = t1 - t0, b = t2 - t1;
+    std::printf("textfmt_Line %.1f ns/line, snprintf %.1f ns/line (%u)\n", a.count() / kLines,
+                b.count() / kLines, sink & 1);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        bench();
+        return 0;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--all") == 0) {
+        uint32_t v = 0;
+        do {
+            check_u32(v);
+            check_i32(static_cast<int32_t>(v));
+        } while (++v != 0);
+        std::printf("ok   %" PRIu64 " values\n", checked);
+        return 0;
+    }
+
+    for (int32_t v = -(1 << 23); v < (1 << 23); v++)
+        check_i32(v);
+    for (uint32_t ms = 0; ms < (1u << 24); ms++)
+        check_line(1000ull * ms + ms % 1000, 0);
+    uint32_t p = 1;
+    for (int d = 0; d < 10; d++, p *= 10) {
+        for (uint32_t v : {p - 1, p, p + 1}) {
+            check_u32(v);
+            check_i32(static_cast<int32_t>(v));
+            check_i32(-static_cast<int32_t>(v));
+        }
+    }
+    for (uint32_t v : {0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu}) {
+        check_u32(v);
+        check_i32(static_cast<int32_t>(v));
+    }
+    // around the end of textfmt_Millis' multiply range, and past it
+    for (uint64_t us = (1ull << 35) - 5000; us < (1ull << 35) + 5000; us++)
+        check_line(us, -1);
+    std::mt19937 rng(11);
+    for (int i = 0; i < 10000000; i++) {
+        uint32_t v = static_cast<uint32_t>(rng());
+        check_u32(v);
+        check_i32(static_cast<int32_t>(v));
+        check_line((static_cast<uint64_t>(rng()) << 3) | (v & 7), static_cast<int32_t>(v));
+    }
+    std::printf("ok   %" PRIu64 " values\n", checked);
+    return 0;
+}
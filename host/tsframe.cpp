@@ -0,0 +1,630 @@
+// Checks the wire protocol (protocol/tsframe.h) end to end, as the boards
+// and the host use it, and times it.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tsframe          the CRC against a bitwise reference; random frames
+//                         of every size through the encoder, then through
+//                         FrameDecoder in reads of random size and through
+//                         the firmware's frame_Push, with noise and
+//                         corrupted frames between them; sample frames
+//                         back through SampleStream; seqs out of order,
+//                         through FrameDecoder and SelectiveRepeat;
+//                         a frame sent again;
+//                         rate frames; the version rules; packed frames (tspack.h) of
+//                         steady, jittery, drifting and gapped timestamps
+//                         and of quiet and noisy readings through
+//                         pack_Decode and the host's decoder, and random
+//                         payloads through both.
+//                         Exits nonzero on the first failure
+//        tsframe --bench  MB/s of the CRC and both decoders, and samples/s
+//                         encoded and decoded, plain and packed
+#include "frame_decoder.hpp"
+#include "packed.hpp"
+#include "repeat.hpp"
+#include "tsframe.h"
+#include "tspack.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+uint16_t frame_seq = 0;
+
+using namespace tsstand;
+
+namespace {
+
+uint64_t checked = 0;
+
+void fail(const char* what)
+{
+    std::printf("FAIL %s\n", what);
+    std::exit(1);
+}
+
+uint16_t crc_reference(const uint8_t* p, size_t n)
+{
+    uint16_t crc = 0xFFFF;
+    while (n--) {
+        crc ^= static_cast<uint16_t>(*p++ << 8);
+        for (int b = 0; b < 8; b++)
+            crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+    }
+    return crc;
+}
+
+void check_crc(std::mt19937& rng)
+{
+    const uint8_t check[] = "123456789";
+    if (frame_Crc16(0xFFFF, check, 9) != 0x29B1)
+        fail("crc of \"123456789\" is not 0x29B1");
+    uint8_t buf[300];
+    for (int i = 0; i < 100000; i++) {
+        size_t n = rng() % sizeof buf;
+        for (size_t j = 0; j < n; j++)
+            buf[j] = static_cast<uint8_t>(rng());
+        if (frame_Crc16(0xFFFF, buf, static_cast<uint16_t>(n)) != crc_reference(buf, n))
+            fail("crc differs from the bitwise reference");
+        checked++;
+    }
+}
+
+// A stream of random frames with noise and corrupted frames between them,
+// and the frames a decoder should find in it.
+struct Stream {
+    std::vector<uint8_t> bytes;
+    std::vector<std::vector<uint8_t>> frames;
+};
+
+Stream make_stream(std::mt19937& rng, size_t count, bool noise)
+{
+    Stream s;
+    frame_t f;
+    for (size_t i = 0; i < count; i++) {
+        frame_Begin(&f, static_cast<uint8_t>(1 + rng() % 8));
+        size_t len = rng() % 4 ? rng() % 64 : rng() % 256;
+        for (size_t j = 0; j < len; j++)
+            frame_Put(&f, rng(), 1);
+        frame_FinishSeq(&f, static_cast<uint16_t>(i));
+        if (f.size != FRAME_HEADER_SIZE + len + FRAME_CRC_SIZE || !frame_CrcOk(f.buf, f.size))
+            fail("encoder built a bad frame");
+        if (noise && rng() % 8 == 0) {
+            // some garbage, sometimes with a sync word in it
+            size_t n = rng() % 40;
+            for (size_t j = 0; j < n; j++)
+                s.bytes.push_back(rng() % 6 ? static_cast<uint8_t>(rng()) : j % 2 ? FRAME_SYNC1 : FRAME_SYNC0);
+        }
+        if (noise && rng() % 16 == 0) {
+            // a frame hit on the way: it must not come out
+            std::vector<uint8_t> bad(f.buf, f.buf + f.size);
+            bad[2 + rng() % (bad.size() - 2)] ^= static_cast<uint8_t>(1 + rng() % 255);
+            s.bytes.insert(s.bytes.end(), bad.begin(), bad.end());
+            continue;
+        }
+        s.bytes.insert(s.bytes.end(), f.buf, f.buf + f.size);
+        s.frames.emplace_back(f.buf, f.buf + f.size);
+    }
+    return s;
+}
+
+void check_decoders(std::mt19937& rng)
+{
+    for (int noise = 0; noise < 2; noise++) {
+        Stream s = make_stream(rng, 200000, noise);
+
+        // the host's, fed in reads of random size
+        FrameDecoder decoder;
+        size_t got = 0;
+        bool order = true;
+        auto on_frame = [&](const Frame& f) {
+            const std::vector<uint8_t>& want = s.frames[got < s.frames.size() ? got : 0];
+            if (got >= s.frames.size() || f.len != want[5] || f.type != want[2] || f.seq != frame_Seq(want.data()) ||
+                std::memcmp(f.payload, want.data() + kFrameHeaderSize, f.len) != 0)
+                order = false;
+            got++;
+        };
+        for (size_t i = 0; i < s.bytes.size();) {
+            size_t n = std::min<size_t>(s.bytes.size() - i, 1 + rng() % (rng() % 2 ? 16 : 4096));
+            decoder.feed(s.bytes.data() + i, n, on_frame);
+            i += n;
+        }
+        if (!order || got != s.frames.size()) {
+            std::printf("FrameDecoder: %zu of %zu frames\n", got, s.frames.size());
+            fail("FrameDecoder lost, corrupted or invented a frame");
+        }
+        checked += got;
+
+        // the firmware's, a byte at a time; without noise it finds every
+        // frame, with noise it gives up the frame a false header swallows
+        uint8_t buf[FRAME_HEADER_SIZE + 255 + FRAME_CRC_SIZE];
+        frame_decoder_t d;
+        frame_DecoderInit(&d, buf, 255);
+        size_t next = 0, found = 0;
+        for (uint8_t b : s.bytes) {
+            if (!frame_Push(&d, b))
+                continue;
+            size_t size = FRAME_HEADER_SIZE + frame_Len(buf) + FRAME_CRC_SIZE;
+            while (next < s.frames.size() &&
+                   (s.frames[next].size() != size || std::memcmp(s.frames[next].data(), buf, size) != 0))
+                next++;
+            if (next == s.frames.size())
+                fail("frame_Push returned a frame that was not sent");
+            next++;
+            found++;
+        }
+        if (!noise && found != s.frames.size())
+            fail("frame_Push lost a frame from a clean stream");
+        std::printf("%s stream: FrameDecoder %zu of %zu frames, frame_Push %zu\n", noise ? "noisy" : "clean", got,
+                    s.frames.size(), found);
+        checked += found;
+    }
+
+    // a short receive buffer skips longer frames and still finds the next
+    uint8_t small[FRAME_HEADER_SIZE + 8 + FRAME_CRC_SIZE];
+    frame_decoder_t d;
+    frame_DecoderInit(&d, small, 8);
+    frame_t f;
+    int found = 0;
+    for (size_t len : {20u, 4u, 200u, 8u}) {
+        frame_Begin(&f, FRAME_TYPE_COMMAND);
+        for (size_t j = 0; j < len; j++)
+            frame_Put(&f, 0xA5, 1);
+        frame_FinishSeq(&f, 0);
+        for (uint16_t i = 0; i < f.size; i++)
+            found += frame_Push(&d, f.buf[i]);
+    }
+    if (found != 2 || d.bad != 2)
+        fail("frame_Push with a short buffer");
+}
+
+// Seqs in and out of order: a gap counts the frames in it, a frame late or
+// twice counts on its own and leaves the seq where it was, and a board that
+// starts over, with its hello or by a long way back, counts as neither.
+void check_seq()
+{
+    FrameDecoder decoder;
+    uint8_t buf[kFrameHeaderSize + 1 + kFrameCrcSize];
+    const uint8_t payload = 0;
+    struct Step {
+        uint16_t seq;
+        uint8_t type;
+    };
+    const Step steps[] = {{10, 0x7F},
+                          {11, 0x7F},
+                          {13, 0x7F}, // 12 lost
+                          {12, 0x7F}, // late
+                          {11, 0x7F}, // twice
+                          {14, 0x7F},
+                          {0, FRAME_TYPE_HELLO}, // started over
+                          {1, 0x7F},
+                          {0x2000, 0x7F}, // 0x1FFE lost
+                          {0x2001, 0x7F},
+                          {5, 0x7F}, // started over, its hello lost
+                          {6, 0x7F},
+                          {0xFFFF, FRAME_TYPE_HELLO},
+                          {0, 0x7F},
+                          {1, 0x7F},
+                          {0xFFFF, 0x7F}, // late, across the wrap
+                          {2, 0x7F}};
+    size_t frames = 0;
+    for (const Step& s : steps) {
+        size_t n = encode_frame(s.type, s.seq, &payload, s.type == FRAME_TYPE_HELLO ? 0 : 1, buf);
+        decoder.feed(buf, n, [&](const Frame&) { frames++; });
+    }
+    const DecoderStats& st = decoder.stats();
+    if (frames != sizeof steps / sizeof steps[0] || st.seq_gaps != 2 || st.frames_lost != 1 + 0x1FFE ||
+        st.seq_behind != 3)
+        fail("seq counting");
+    checked += frames;
+}
+
+// Selective repeat (repeat.hpp) over a stream with a gap in it: the gap is
+// asked for, a frame from it that comes late in the live stream fills its
+// place, one that comes twice or is no longer missing is dropped, and a
+// board that starts over leaves nothing to ask for.
+void check_repeat()
+{
+    SelectiveRepeat repeat;
+    const uint8_t payload[1] = {0};
+    auto frame = [&](uint16_t seq, uint8_t type = 0x7F, bool resent = false) {
+        return Frame{type, seq, payload, sizeof payload, resent};
+    };
+    int64_t now = 0;
+    bool ok = true;
+    for (uint16_t seq : {0xFFFE, 0xFFFF, 2, 3})
+        ok &= repeat.seen(frame(seq), now);
+    if (!ok || repeat.missing() != 2 || repeat.stats().missed != 2)
+        fail("SelectiveRepeat finding a gap across the wrap");
+
+    uint16_t first = 0, count = 0;
+    repeat.poll(now, [&](const uint8_t* p, uint8_t len) {
+        if (len == FRAME_NACK_SIZE)
+            first = frame_Get16(p), count = frame_Get16(p + 2);
+    });
+    if (first != 0 || count != 2)
+        fail("SelectiveRepeat asking for a gap");
+
+    now += 1000000;
+    ok = repeat.seen(frame(1), now);             // late, still missing
+    ok &= !repeat.seen(frame(1), now);           // twice
+    ok &= !repeat.seen(frame(0xFFFF), now);      // never missing
+    ok &= repeat.seen(frame(0, 0x7F, true), now); // sent again
+    ok &= !repeat.seen(frame(0, 0x7F, true), now);
+    ok &= repeat.seen(frame(4), now);
+    const RepeatStats& st = repeat.stats();
+    if (!ok || repeat.missing() != 0 || st.recovered != 2 || st.late != 3 || st.missed != 2 || st.expired != 0)
+        fail("SelectiveRepeat with frames late and twice");
+
+    // started over: with a hello, and without one by a long way back
+    ok = repeat.seen(frame(7), now);
+    ok &= repeat.seen(frame(0, FRAME_TYPE_HELLO), now);
+    ok &= repeat.seen(frame(1), now);
+    ok &= repeat.seen(frame(2), now);
+    ok &= repeat.seen(frame(0x2000), now); // 0x1FFD missing
+    ok &= repeat.seen(frame(0x10), now);
+    ok &= repeat.seen(frame(0x11), now);
+    if (!ok || repeat.missing() != 0 || st.missed != 2 + 2 + 0x1FFD || st.expired != 2 + 0x1FFD || st.late != 3)
+        fail("SelectiveRepeat with a board that started over");
+    checked += 17;
+}
+
+void check_samples(std::mt19937& rng)
+{
+    frame_t f;
+    FrameDecoder decoder;
+    SampleStream stream;
+    Sample out[SampleStream::kMaxSamplesPerFrame];
+    std::vector<int64_t> want_t;
+    std::vector<int32_t> want_v;
+    size_t got = 0;
+    auto on_frame = [&](const Frame& fr) {
+        size_t n = stream.decode(fr, out);
+        for (size_t i = 0; i < n; i++, got++) {
+            if (got >= want_t.size() || out[i].t != want_t[got] || out[i].value != want_v[got])
+                fail("sample frames do not decode to what was encoded");
+        }
+    };
+
+    frame_Hello(&f, 16000000u / 128u, FRAME_HELLO_NEWTONS, 7);
+    decoder.feed(f.buf, f.size, on_frame);
+    if (stream.tick_hz() != 125000 || !stream.newtons() || stream.board_id() != 7 || stream.version() != FRAME_VERSION)
+        fail("hello");
+
+    // timestamps wrap 32 bits along the way; readings cover all 24 bits
+    uint32_t t = 0xFFF00000u;
+    int64_t unwrapped = t;
+    frame_t previous{}, last{};
+    frame_BeginSamples(&f);
+    for (int i = 0; i < 1000000; i++) {
+        uint32_t dt = rng() % 4 ? rng() % 2000 : rng() % 65536;
+        if (i)
+            t += dt, unwrapped += dt;
+        int32_t v = static_cast<int32_t>(rng() % (1u << 24)) - (1 << 23);
+        want_t.push_back(unwrapped);
+        want_v.push_back(v);
+        if (frame_AddSample(&f, t, v)) {
+            frame_Finish(&f);
+            decoder.feed(f.buf, f.size, on_frame);
+            previous = last;
+            last = f;
+            frame_BeginSamples(&f);
+        }
+    }
+    if (got != want_t.size())
+        fail("samples went missing");
+    checked += got;
+
+    // the frame before last again, as a board sends it on request: the same
+    // samples, no gap in the seq, and the time base left where it was
+    frame_MarkResent(previous.buf);
+    size_t again = 0;
+    decoder.feed(previous.buf, previous.size, [&](const Frame& fr) {
+        if (fr.resent && fr.type == FRAME_TYPE_SAMPLES)
+            again = stream.decode(fr, out);
+    });
+    if (again != FRAME_SAMPLES_PER_FRAME || decoder.stats().resent != 1 || decoder.stats().seq_gaps != 0)
+        fail("a frame sent again");
+    for (size_t i = 0; i < again; i++) {
+        size_t k = got - 2 * FRAME_SAMPLES_PER_FRAME + i;
+        if (out[i].t != want_t[k] || out[i].value != want_v[k])
+            fail("a frame sent again decodes differently");
+    }
+
+    // rate frames: the first sets the spacing, a repeat changes nothing
+    for (uint32_t period : {0x1000u, 0x1000u, 0x20000u}) {
+        frame_Begin(&f, FRAME_TYPE_RATE);
+        frame_Put(&f, t + period, 4);
+        frame_Put(&f, period, 4);
+        frame_Put(&f, period >> 12, 2);
+        frame_Put(&f, period > 0x1000u ? FRAME_RATE_IDLE : 0, 1);
+        frame_Finish(&f);
+        decoder.feed(f.buf, f.size, on_frame);
+    }
+    if (stream.rate_changes() != 1 || !stream.rate().idle || stream.rate().period != 512 ||
+        stream.rate().averaged != 32 || stream.rate().t != unwrapped + 0x20000)
+        fail("rate frames");
+
+    // the version rules: unknown types and longer payloads are read past,
+    // a newer version is refused
+    frame_Begin(&f, 0x7F);
+    frame_Put(&f, 1, 4);
+    frame_Finish(&f);
+    if (stream.decode(Frame{frame_Type(f.buf), 0, frame_Payload(f.buf), frame_Len(f.buf)}, out) != 0)
+        fail("an unknown frame type gave samples");
+    frame_Begin(&f, FRAME_TYPE_HELLO);
+    frame_Put(&f, FRAME_VERSION, 1);
+    frame_Put(&f, 0, 1);
+    frame_Put(&f, 1000000, 4);
+    frame_Put(&f, 3, 2);
+    frame_Put(&f, 0xDEADBEEF, 4); // a field from later
+    frame_Finish(&f);
+    stream.decode(Frame{FRAME_TYPE_HELLO, 0, frame_Payload(f.buf), frame_Len(f.buf)}, out);
+    if (stream.refused() || stream.board_id() != 3 || stream.tick_hz() != 1000000)
+        fail("a longer hello of the same version");
+    f.buf[FRAME_HEADER_SIZE] = FRAME_VERSION + 1;
+    stream.decode(Frame{FRAME_TYPE_HELLO, 0, frame_Payload(f.buf), frame_Len(f.buf)}, out);
+    frame_BeginSamples(&f);
+    frame_AddSample(&f, 0, 1);
+    frame_Finish(&f);
+    if (!stream.refused() || stream.decode(Frame{FRAME_TYPE_SAMPLES, 0, frame_Payload(f.buf), frame_Len(f.buf)}, out))
+        fail("samples after a newer version's hello were not refused");
+}
+
+// Timestamps and readings for packed frames: a tick rate that is rarely a
+// whole number of ticks per sample, a board clock drifting against it,
+// jitter, gaps, and readings from a quiet load cell to full-scale noise.
+struct PackCase {
+    std::vector<uint32_t> t;
+    std::vector<int32_t> v;
+    uint32_t period; // 24.8, as the board computes it
+};
+
+PackCase make_pack_case(std::mt19937& rng, size_t n)
+{
+    PackCase c;
+    c.period = 256 + rng() % (4000 * 256);
+    double ticks = c.period / 256.0 * (1 + (static_cast<double>(rng() % 2001) - 1000) * 1e-6);
+    double at = rng() % 1000 / 1000.0;
+    uint32_t t0 = rng() % 4 ? rng() : 0xFFFFFFFFu - rng() % 100000; // some wrap 32 bits
+    unsigned jitter = rng() % 3 ? 0 : rng() % 12;
+    unsigned noise = 1u << (rng() % 25);
+    double level = static_cast<double>(rng() % (1u << 24)) - (1 << 23);
+    for (size_t i = 0; i < n; i++) {
+        at += ticks;
+        if (rng() % 2000 == 0)
+            at += rng() % 100000; // a gap: samples lost on the board
+        int64_t j = jitter ? static_cast<int64_t>(rng() % (2 * jitter + 1)) - jitter : 0;
+        c.t.push_back(t0 + static_cast<uint32_t>(static_cast<int64_t>(at) + j));
+        level += std::sin(i * 0.001) * noise / 8;
+        int32_t v = static_cast<int32_t>(level) + static_cast<int32_t>(rng() % noise) - static_cast<int32_t>(noise / 2);
+        if (rng() % 500 == 0)
+            v = static_cast<int32_t>(rng()); // a spike, full scale
+        c.v.push_back(pack_Reading24(v));
+    }
+    return c;
+}
+
+// Checks a packed payload against the samples it should hold, with both
+// decoders.
+void check_unpack(const uint8_t* payload, uint8_t len, const PackCase& c, size_t first, size_t count)
+{
+    uint32_t t[PACK_MAX_SAMPLES], t2[PACK_MAX_SAMPLES];
+    int32_t v[PACK_MAX_SAMPLES], v2[PACK_MAX_SAMPLES];
+    if (pack_Decode(payload, len, t, v) != count || unpack_samples(payload, len, t2, v2) != count)
+        fail("a packed frame's sample count");
+    for (size_t i = 0; i < count; i++) {
+        if (t[i] != c.t[first + i] || v[i] != c.v[first + i])
+            fail("pack_Decode does not give back what was packed");
+        if (t2[i] != t[i] || v2[i] != v[i])
+            fail("unpack_samples differs from pack_Decode");
+    }
+    checked += count;
+}
+
+void check_packed(std::mt19937& rng)
+{
+    static pack_t p;
+    size_t samples = 0, bytes = 0, frames = 0;
+    for (int run = 0; run < 400; run++) {
+        PackCase c = make_pack_case(rng, 5000);
+        size_t first = 0;
+        pack_Begin(&p, c.period);
+        for (size_t i = 0; i < c.t.size(); i++) {
+            if (!pack_Add(&p, c.t[i], c.v[i]))
+                continue;
+            size_t count = p.count;
+            pack_Finish(&p);
+            if (p.frame.size > FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD + FRAME_CRC_SIZE ||
+                !frame_CrcOk(p.frame.buf, p.frame.size))
+                fail("pack_Finish built a bad frame");
+            check_unpack(frame_Payload(p.frame.buf), frame_Len(p.frame.buf), c, first, count);
+            first += count;
+            bytes += p.frame.size;
+            frames++;
+            pack_Begin(&p, c.period);
+        }
+        size_t count = p.count;
+        if (pack_Finish(&p)) {
+            check_unpack(frame_Payload(p.frame.buf), frame_Len(p.frame.buf), c, first, count);
+            first += count;
+            bytes += p.frame.size;
+            frames++;
+        }
+        if (first != c.t.size())
+            fail("packed samples went missing");
+        samples += first;
+    }
+    std::printf("packed: %zu samples in %zu frames, %.2f bytes a sample\n", samples, frames,
+                static_cast<double>(bytes) / samples);
+
+    // through SampleStream, as tsacq reads them
+    FrameDecoder decoder;
+    SampleStream stream;
+    Sample out[SampleStream::kMaxSamplesPerFrame];
+    PackCase c = make_pack_case(rng, 100000);
+    size_t got = 0;
+    auto on_frame = [&](const Frame& fr) {
+        size_t n = stream.decode(fr, out);
+        for (size_t i = 0; i < n; i++, got++) {
+            if (got >= c.t.size() || static_cast<uint32_t>(out[i].t) != c.t[got] || out[i].value != c.v[got])
+                fail("packed frames do not decode through SampleStream");
+        }
+    };
+    pack_Begin(&p, c.period);
+    for (size_t i = 0; i < c.t.size(); i++) {
+        if (pack_Add(&p, c.t[i], c.v[i])) {
+            pack_Finish(&p);
+            decoder.feed(p.frame.buf, p.frame.size, on_frame);
+            pack_Begin(&p, c.period);
+        }
+    }
+    if (pack_Finish(&p))
+        decoder.feed(p.frame.buf, p.frame.size, on_frame);
+    if (got != c.t.size())
+        fail("packed samples went missing in SampleStream");
+    checked += got;
+
+    // whatever arrives, the decoders agree and stay in bounds
+    uint8_t payload[255];
+    uint32_t t[PACK_MAX_SAMPLES], t2[PACK_MAX_SAMPLES];
+    int32_t v[PACK_MAX_SAMPLES], v2[PACK_MAX_SAMPLES];
+    for (int i = 0; i < 200000; i++) {
+        uint8_t len = static_cast<uint8_t>(rng() % 256);
+        for (uint8_t j = 0; j < len; j++)
+            payload[j] = static_cast<uint8_t>(rng() % 3 ? rng() % 4 : rng());
+        if (len >= PACK_HEAD)
+            payload[11] = static_cast<uint8_t>(rng() % 8 ? 1 + rng() % 20 : rng());
+        size_t n = pack_Decode(payload, len, t, v);
+        if (unpack_samples(payload, len, t2, v2) != n)
+            fail("the decoders differ on a random payload");
+        for (size_t j = 0; j < n; j++) {
+            if (t[j] != t2[j] || v[j] != v2[j])
+                fail("the decoders differ on a random payload");
+        }
+        checked++;
+    }
+}
+
+double seconds_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void bench()
+{
+    std::mt19937 rng(5);
+    constexpr size_t kSamples = 20000000;
+    std::vector<int32_t> readings(4096);
+    for (int32_t& r : readings)
+        r = static_cast<int32_t>(rng() % (1u << 24)) - (1 << 23);
+
+    // encode, as the firmware does
+    std::vector<uint8_t> wire;
+    wire.reserve(kSamples / FRAME_SAMPLES_PER_FRAME * 52 + 64);
+    frame_t f;
+    auto t0 = std::chrono::steady_clock::now();
+    frame_BeginSamples(&f);
+    for (size_t i = 0; i < kSamples; i++) {
+        if (frame_AddSample(&f, static_cast<uint32_t>(i * 9), readings[i & 4095])) {
+            frame_Finish(&f);
+            wire.insert(wire.end(), f.buf, f.buf + f.size);
+            frame_BeginSamples(&f);
+        }
+    }
+    double s = seconds_since(t0);
+    double mb = static_cast<double>(wire.size()) / 1e6;
+    std::printf("encode           %6.0f MB/s, %5.1f M samples/s\n", mb / s, kSamples / s / 1e6);
+
+    t0 = std::chrono::steady_clock::now();
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i + 60000 <= wire.size(); i += 60000)
+        crc = frame_Crc16(crc, wire.data() + i, 60000);
+    s = seconds_since(t0);
+    std::printf("crc              %6.0f MB/s (%04x)\n", mb / s, crc);
+
+    FrameDecoder decoder;
+    SampleStream stream;
+    Sample out[SampleStream::kMaxSamplesPerFrame];
+    uint64_t samples = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < wire.size(); i += 65536) {
+        decoder.feed(wire.data() + i, std::min<size_t>(65536, wire.size() - i),
+                     [&](const Frame& fr) { samples += stream.decode(fr, out); });
+    }
+    s = seconds_since(t0);
+    std::printf("FrameDecoder     %6.0f MB/s, %5.1f M samples/s with SampleStream\n", mb / s, samples / s / 1e6);
+
+    uint8_t buf[FRAME_MAX_SIZE];
+    frame_decoder_t d;
+    frame_DecoderInit(&d, buf, 255);
+    uint64_t frames = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (uint8_t b : wire)
+        frames += frame_Push(&d, b);
+    s = seconds_since(t0);
+    std::printf("frame_Push       %6.0f MB/s (%" PRIu64 " frames)\n", mb / s, frames);
+
+    // packed, a quiet load cell sampled steadily; readings wander by a few
+    // counts with the odd spike
+    static pack_t p;
+    std::vector<uint8_t> packed;
+    packed.reserve(kSamples * 2);
+    int32_t level = 0;
+    for (int32_t& r : readings) {
+        level += static_cast<int32_t>(rng() % 9) - 4;
+        r = rng() % 200 ? level + static_cast<int32_t>(rng() % 64) : static_cast<int32_t>(rng() % (1u << 24));
+    }
+    t0 = std::chrono::steady_clock::now();
+    pack_Begin(&p, 9 * 256);
+    for (size_t i = 0; i < kSamples; i++) {
+        if (pack_Add(&p, static_cast<uint32_t>(i * 9), readings[i & 4095])) {
+            pack_Finish(&p);
+            packed.insert(packed.end(), p.frame.buf, p.frame.buf + p.frame.size);
+            pack_Begin(&p, 9 * 256);
+        }
+    }
+    s = seconds_since(t0);
+    std::printf("pack_Add         %6.1f M samples/s, %.2f bytes a sample\n", kSamples / s / 1e6,
+                static_cast<double>(packed.size()) / kSamples);
+
+    uint32_t pt[PACK_MAX_SAMPLES];
+    int32_t pv[PACK_MAX_SAMPLES];
+    for (int host = 0; host < 2; host++) {
+        FrameDecoder packed_decoder;
+        samples = 0;
+        t0 = std::chrono::steady_clock::now();
+        packed_decoder.feed(packed.data(), packed.size(), [&](const Frame& fr) {
+            samples += host ? unpack_samples(fr.payload, fr.len, pt, pv) : pack_Decode(fr.payload, fr.len, pt, pv);
+        });
+        s = seconds_since(t0);
+        std::printf("%-16s %6.1f M samples/s\n", host ? "unpack_samples" : "pack_Decode", samples / s / 1e6);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc == 2 && !std::strcmp(argv[1], "--bench")) {
+        bench();
+        return 0;
+    }
+    if (argc != 1) {
+        std::fprintf(stderr, "usage: tsframe [--bench]\n");
+        return 2;
+    }
+    std::mt19937 rng(1);
+    check_crc(rng);
+    check_decoders(rng);
+    check_seq();
+    check_repeat();
+    check_samples(rng);
+    check_packed(rng);
+    std::printf("ok, %" PRIu64 " checks\n", checked);
+    return 0;
+}
@@ -0,0 +1,182 @@
+// Stand-in for the board: opens a pseudo-terminal and streams synthetic
+// frames through it, built with the firmware's own encoder (tsframe.h), so
+// tsacq and the other host tools can run without hardware. The pty path is printed on
+// stdout.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tssim [-r samples_per_second] [-b baud] [-s seconds] [-B burn_start_s]
+//              [-O clock_offset_s] [-d clock_drift_ppm]
+//
+// -b limits the output to what a UART at that baud rate could carry (10
+// bits per byte); frames that do not fit are dropped the way the firmware's
+// TX ring drops them, so the receiver sees sequence gaps. -b 0 disables the
+// limit.
+//
+// Sync requests (tsframe.h) are answered as the firmware answers them. The
+// simulated board's clock starts -O seconds ahead and runs -d parts per
+// million fast, so tsacq's clock fit can be checked on several of these at
+// once.
+#include "frame_decoder.hpp"
+#include "tsframe.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <random>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+uint16_t frame_seq = 0;
+
+namespace {
+
+// idle load cell with a 2 s burn: fast rise, regressive tail, noise
+double signal(double t, double burn_start, std::mt19937& rng)
+{
+    static std::normal_distribution<double> noise(0.0, 6.0);
+    double v = 1200.0 + noise(rng);
+    double b = t - burn_start;
+    if (b > 0 && b < 2.0)
+        v += 9000.0 * (1 - std::exp(-b / 0.03)) * (1.0 - 0.35 * b);
+    return v;
+}
+
+double seconds_since(const timespec& start)
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec - start.tv_sec) + (ts.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+// The simulated board's clock, in its microseconds.
+struct BoardClock {
+    timespec start;
+    double offset = 0; // s
+    double rate = 1;
+
+    uint32_t micros(double t) const { return static_cast<uint32_t>(static_cast<int64_t>((offset + t * rate) * 1e6)); }
+    uint32_t now() const { return micros(seconds_since(start)); }
+};
+
+// Sleeps until ts, answering sync requests from the other end as they come.
+void sleep_until(const timespec& ts, int fd, tsstand::FrameDecoder& decoder, const BoardClock& clock)
+{
+    static uint8_t buf[256];
+    for (;;) {
+        double left = -seconds_since(ts);
+        if (left <= 0)
+            return;
+        pollfd p{fd, POLLIN, 0};
+        timespec wait{static_cast<time_t>(left), static_cast<long>((left - std::floor(left)) * 1e9)};
+        if (ppoll(&p, 1, &wait, nullptr) <= 0)
+            continue;
+        uint32_t arrived = clock.now();
+        ssize_t n = read(fd, buf, sizeof buf);
+        if (n <= 0)
+            continue;
+        decoder.feed(buf, static_cast<size_t>(n), [&](const tsstand::Frame& f) {
+            if (f.type != FRAME_TYPE_SYNC || f.len < 4)
+                return;
+            frame_t reply;
+            frame_Begin(&reply, FRAME_TYPE_SYNC);
+            frame_Put(&reply, f.payload[0] | f.payload[1] << 8 | f.payload[2] << 16 |
+                                  static_cast<uint32_t>(f.payload[3]) << 24, 4);
+            frame_Put(&reply, arrived, 4);
+            frame_Finish(&reply);
+            if (write(fd, reply.buf, reply.size) < 0)
+                std::perror("write");
+        });
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    double rate = 2400, seconds = 0, burn_start = 5;
+    unsigned baud = 115200;
+    BoardClock clock;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:b:s:B:O:d:")) != -1) {
+        switch (opt) {
+        case 'r': rate = std::atof(optarg); break;
+        case 'b': baud = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 's': seconds = std::atof(optarg); break;
+        case 'B': burn_start = std::atof(optarg); break;
+        case 'O': clock.offset = std::atof(optarg); break;
+        case 'd': clock.rate = 1 + std::atof(optarg) * 1e-6; break;
+        default:
+            std::fprintf(stderr, "usage: tssim [-r rate] [-b baud] [-s seconds] [-B burn_start_s]\n"
+                                 "             [-O clock_offset_s] [-d clock_drift_ppm]\n");
+            return 2;
+        }
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+        std::perror("posix_openpt");
+        return 1;
+    }
+    // Keep our own handle on the slave in raw mode: without it the line
+    // discipline would mangle binary bytes, and the master would see EIO
+    // between readers.
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    termios tio{};
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    std::printf("%s\n", ptsname(master));
+    std::fflush(stdout);
+
+    const double step = 0.01;
+    const double byte_budget = baud ? baud / 10.0 * step : 1e12;
+    std::mt19937 rng(1);
+    frame_t frame;
+    unsigned long dropped = 0;
+    unsigned long frames = 0;
+    double credit = 0;
+    double next_sample = 0;
+    tsstand::FrameDecoder decoder;
+
+    frame_Hello(&frame, 1000000u, 0, 0);
+    if (write(master, frame.buf, frame.size) < 0)
+        std::perror("write");
+    frame_BeginSamples(&frame);
+
+    timespec tick;
+    clock_gettime(CLOCK_MONOTONIC, &tick);
+    clock.start = tick;
+    for (double t = 0; seconds <= 0 || t < seconds; t += step) {
+        credit = std::fmin(credit + byte_budget, 8192.0 + byte_budget);
+        for (; next_sample < t + step; next_sample += 1.0 / rate) {
+            int32_t v = static_cast<int32_t>(signal(next_sample, burn_start, rng));
+            if (!frame_AddSample(&frame, clock.micros(next_sample), v))
+                continue;
+            frame_Finish(&frame);
+            if (credit >= frame.size && write(master, frame.buf, frame.size) == frame.size)
+                credit -= frame.size;
+            else
+                dropped++;
+            frame_BeginSamples(&frame);
+            if (++frames % 256 == 0) {
+                frame_t hello;
+                frame_Hello(&hello, 1000000u, 0, 0);
+                if (write(master, hello.buf, hello.size) < 0)
+                    dropped++;
+            }
+        }
+        tick.tv_nsec += static_cast<long>(step * 1e9);
+        if (tick.tv_nsec >= 1000000000L) {
+            tick.tv_nsec -= 1000000000L;
+            tick.tv_sec++;
+        }
+        sleep_until(tick, master, decoder, clock);
+    }
+    std::fprintf(stderr, "%lu frames dropped\n", dropped);
+    close(slave);
+    close(master);
+    return 0;
+}
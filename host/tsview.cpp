@@ -0,0 +1,89 @@
+// Browses a recorded run in a web browser. Replaces the plotting half of
+// convertToLoadAndPlotMk2.m; see view_server.hpp for the page and the
+// pyramids behind it.
+// This file is part of the code for the SEDS test stand.
+//
+// usage: tsview [-p port] [-g newtons_per_count] [-o zero_counts] run.tsr
+//
+// Prints the address to open and serves it until Ctrl-C. Calibration
+// defaults to the run file's header, as in tsanalyze.
+#include "runfile.hpp"
+#include "view_server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <unistd.h>
+
+using namespace tsstand;
+
+namespace {
+
+std::atomic<bool> stop{false};
+
+void on_signal(int)
+{
+    stop = true;
+}
+
+void usage()
+{
+    std::fprintf(stderr, "usage: tsview [-p port] [-g newtons_per_count] [-o zero_counts] run.tsr\n");
+    std::exit(2);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    unsigned port = 8080;
+    double gain = 0, offset = 0;
+    bool have_gain = false, have_offset = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:g:o:")) != -1) {
+        switch (opt) {
+        case 'p': port = static_cast<unsigned>(std::atoi(optarg)); break;
+        case 'g': gain = std::atof(optarg); have_gain = true; break;
+        case 'o': offset = std::atof(optarg); have_offset = true; break;
+        default: usage();
+        }
+    }
+    if (argc - optind != 1)
+        usage();
+
+    try {
+        RunFile run(argv[optind]);
+        const RunHeader& h = run.header();
+        RunInfo info;
+        info.board_id = h.board_id;
+        info.sample_rate_hz = h.sample_rate_hz;
+        info.cal = header_calibration(h);
+        if (have_gain)
+            info.cal.gain = gain;
+        if (have_offset)
+            info.cal.offset = offset;
+        info.note = std::string(h.note, strnlen(h.note, sizeof h.note));
+
+        auto start = std::chrono::steady_clock::now();
+        LivePlot plot(info);
+        plot.set_tick_hz(h.tick_hz);
+        plot.append(run.channels(), run.times(), run.samples(), run.size());
+        std::fprintf(stderr, "%zu samples indexed in %.0f ms\n", run.size(),
+                     std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        ViewServer server(static_cast<uint16_t>(port), plot);
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+        std::printf("http://127.0.0.1:%u/\n", port);
+        std::fflush(stdout);
+        server.run(stop);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "tsview: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
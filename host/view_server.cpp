@@ -0,0 +1,358 @@
+// This file is part of the code for the SEDS test stand.
+#include "view_server.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+
+namespace tsstand {
+
+namespace {
+
+// The viewer: one canvas, wheel to zoom, drag to pan, double click for the
+// whole run. While "follow" is ticked the view keeps its width and tracks
+// the newest samples.
+const char kPage[] = R"html(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>Test stand</title>
+<style>
+body { margin: 0; font: 13px sans-serif; }
+#bar { padding: 4px 8px; height: 22px; }
+canvas { display: block; width: 100vw; height: calc(100vh - 30px); cursor: crosshair; }
+</style></head>
+<body>
+<div id="bar"><select id="ch"></select>
+<label><input type="checkbox" id="follow" checked> follow</label>
+<span id="status"></span></div>
+<canvas id="plot"></canvas>
+<script>
+const cv = document.getElementById('plot'), ctx = cv.getContext('2d');
+const sel = document.getElementById('ch'), follow = document.getElementById('follow');
+const status = document.getElementById('status');
+let info = null, view = null, cols = null, busy = false, drag = null;
+
+function label(c) { return info.channels.some(x => x > 15) ? 'board ' + (c >> 4) + ' input ' + (c & 15) : 'input ' + c; }
+function isForce(c) { return (c & 15) == 0; }
+function toY(v) {
+  if (!isForce(+sel.value)) return v;
+  const u = v - info.cal_offset;
+  return ((info.cal_cube * u + info.cal_square) * u + info.cal_gain) * u;
+}
+
+async function poll() {
+  if (busy) return;
+  busy = true;
+  try {
+    info = await (await fetch('/info')).json();
+    if (sel.options.length != info.channels.length) {
+      sel.innerHTML = '';
+      for (const c of info.channels) sel.add(new Option(label(c), c));
+    }
+    if (!view) view = [info.t0, info.t1];
+    if (follow.checked) {
+      const w = view[1] - view[0];
+      view = [Math.max(info.t0, info.t1 - w), info.t1];
+    }
+    const q = '/data?ch=' + sel.value + '&from=' + view[0] + '&to=' + view[1] + '&w=' + cv.clientWidth;
+    cols = await (await fetch(q)).json();
+    status.textContent = info.count + ' samples, ' + (info.t1 - info.t0).toFixed(1) + ' s' +
+                         (info.note ? ', ' + info.note : '');
+    draw();
+  } catch (e) {
+    status.textContent = 'no answer from the server';
+  } finally {
+    busy = false;
+  }
+}
+
+function draw() {
+  const dpr = window.devicePixelRatio || 1, w = cv.clientWidth, h = cv.clientHeight;
+  cv.width = w * dpr; cv.height = h * dpr;
+  ctx.setTransform(dpr, 0, 0, dpr, 0, 0);
+  ctx.clearRect(0, 0, w, h);
+  if (!cols || cols.t.length == 0) return;
+  let lo = Infinity, hi = -Infinity;
+  for (let i = 0; i < cols.t.length; i++) {
+    const a = toY(cols.lo[i]), b = toY(cols.hi[i]);
+    lo = Math.min(lo, a, b); hi = Math.max(hi, a, b);
+  }
+  const pad = (hi - lo) * 0.05 || 1, left = 60, bottom = 20;
+  lo -= pad; hi += pad;
+  const x = t => left + (t - view[0]) / (view[1] - view[0]) * (w - left);
+  const y = v => (h - bottom) * (1 - (v - lo) / (hi - lo));
+
+  ctx.strokeStyle = '#ddd'; ctx.fillStyle = '#444'; ctx.beginPath();
+  for (let i = 0; i <= 5; i++) {
+    const v = lo + (hi - lo) * i / 5, t = view[0] + (view[1] - view[0]) * i / 5;
+    ctx.moveTo(left, y(v)); ctx.lineTo(w, y(v));
+    ctx.fillText(v.toPrecision(5), 2, y(v) + 4);
+    ctx.fillText(t.toFixed(3) + ' s', x(t) - (i == 5 ? 50 : 0), h - 5);
+  }
+  ctx.stroke();
+
+  ctx.strokeStyle = '#c03'; ctx.beginPath();
+  for (let i = 0; i < cols.t.length; i++) {
+    const px = Math.round(x(cols.t[i])) + 0.5, a = y(toY(cols.lo[i])), b = y(toY(cols.hi[i]));
+    if (i == 0) ctx.moveTo(px, a); else ctx.lineTo(px, a);
+    ctx.lineTo(px, b);
+  }
+  ctx.stroke();
+  ctx.fillText(isForce(+sel.value) ? 'N' : 'counts', 2, 12);
+}
+
+cv.addEventListener('wheel', e => {
+  e.preventDefault();
+  const f = e.deltaY > 0 ? 1.25 : 0.8, r = (e.offsetX - 60) / (cv.clientWidth - 60);
+  const t = view[0] + r * (view[1] - view[0]);
+  view = [t - (t - view[0]) * f, t + (view[1] - t) * f];
+  follow.checked = false;
+  poll();
+});
+cv.addEventListener('mousedown', e => { drag = { x: e.offsetX, view: view.slice() }; });
+window.addEventListener('mouseup', () => { drag = null; });
+cv.addEventListener('mousemove', e => {
+  if (!drag) return;
+  const dt = (e.offsetX - drag.x) / (cv.clientWidth - 60) * (drag.view[1] - drag.view[0]);
+  view = [drag.view[0] - dt, drag.view[1] - dt];
+  follow.checked = false;
+  draw();
+});
+cv.addEventListener('dblclick', () => { view = null; follow.checked = true; poll(); });
+sel.addEventListener('change', poll);
+window.addEventListener('resize', poll);
+setInterval(poll, 500);
+poll();
+</script>
+</body></html>
+)html";
+
+void send_all(int fd, const char* p, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR)
+                continue;
+            return; // the browser went away; nothing to do about it
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+void respond(int fd, const char* status, const char* type, const std::string& body)
+{
+    char head[256];
+    int n = std::snprintf(head, sizeof head,
+                          "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n"
+                          "Cache-Control: no-store\r\nConnection: close\r\n\r\n",
+                          status, type, body.size());
+    send_all(fd, head, static_cast<size_t>(n));
+    send_all(fd, body.data(), body.size());
+}
+
+// The value of `key` in a query string, or nullptr.
+const char* param(const std::string& query, const char* key)
+{
+    size_t len = std::strlen(key);
+    for (size_t pos = 0; pos < query.size();) {
+        size_t end = query.find('&', pos);
+        if (end == std::string::npos)
+            end = query.size();
+        if (end - pos > len && query.compare(pos, len, key) == 0 && query[pos + len] == '=')
+            return query.c_str() + pos + len + 1;
+        pos = end + 1;
+    }
+    return nullptr;
+}
+
+void append_json_string(std::string& out, const char* s)
+{
+    out += '"';
+    for (; *s; s++) {
+        unsigned char c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += *s;
+        } else if (c < 0x20) {
+            char esc[8];
+            std::snprintf(esc, sizeof esc, "\\u%04x", c);
+            out += esc;
+        } else {
+            out += *s;
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+void LivePlot::append(const uint8_t* channels, const int64_t* t, const int32_t* v, size_t n)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    MinMaxPyramid* plot = nullptr;
+    uint8_t last = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t ch = channels ? channels[i] : 0;
+        if (!plot || ch != last) {
+            plot = &plots_[ch];
+            last = ch;
+        }
+        plot->append(t[i], v[i]);
+    }
+}
+
+std::string LivePlot::info_json()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    double hz = tick_hz_;
+    uint64_t count = 0;
+    int64_t t0 = INT64_MAX, t1 = INT64_MIN;
+    std::string channels;
+    for (const auto& p : plots_) {
+        if (p.second.count() == 0)
+            continue;
+        count += p.second.count();
+        t0 = std::min(t0, p.second.first_t());
+        t1 = std::max(t1, p.second.last_t());
+        channels += (channels.empty() ? "" : ",") + std::to_string(p.first);
+    }
+    if (count == 0)
+        t0 = t1 = 0;
+    char buf[384];
+    std::snprintf(buf, sizeof buf,
+                  "{\"count\":%llu,\"t0\":%.6f,\"t1\":%.6f,\"tick_hz\":%.0f,\"board_id\":%u,"
+                  "\"sample_rate_hz\":%g,\"cal_gain\":%.9g,\"cal_offset\":%.9g,\"cal_square\":%.9g,"
+                  "\"cal_cube\":%.9g,\"channels\":[",
+                  static_cast<unsigned long long>(count), t0 / hz, t1 / hz, hz, info_.board_id,
+                  info_.sample_rate_hz, info_.cal.gain, info_.cal.offset, info_.cal.square, info_.cal.cube);
+    std::string out = buf + channels + "],\"note\":";
+    append_json_string(out, info_.note.c_str());
+    out += '}';
+    return out;
+}
+
+std::string LivePlot::data_json(unsigned channel, double from_s, double to_s, size_t width)
+{
+    std::vector<PlotColumn> cols;
+    double hz = tick_hz_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = plots_.find(static_cast<uint8_t>(channel));
+        if (it != plots_.end())
+            it->second.query(static_cast<int64_t>(from_s * hz), static_cast<int64_t>(to_s * hz), width, cols);
+    }
+    std::string t = "{\"t\":[", lo = "],\"lo\":[", hi = "],\"hi\":[";
+    char buf[32];
+    for (size_t i = 0; i < cols.size(); i++) {
+        const char* sep = i ? "," : "";
+        std::snprintf(buf, sizeof buf, "%s%.6f", sep, cols[i].t / hz);
+        t += buf;
+        std::snprintf(buf, sizeof buf, "%s%d", sep, cols[i].lo);
+        lo += buf;
+        std::snprintf(buf, sizeof buf, "%s%d", sep, cols[i].hi);
+        hi += buf;
+    }
+    return t + lo + hi + "]}";
+}
+
+ViewServer::ViewServer(uint16_t port, LivePlot& plot) : plot_(plot)
+{
+    fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0)
+        throw std::system_error(errno, std::generic_category(), "socket");
+    int on = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0 || listen(fd_, 8) < 0) {
+        int err = errno;
+        ::close(fd_);
+        throw std::system_error(err, std::generic_category(), "127.0.0.1:" + std::to_string(port));
+    }
+}
+
+ViewServer::~ViewServer()
+{
+    ::close(fd_);
+}
+
+void ViewServer::run(const std::atomic<bool>& stop)
+{
+    while (!stop.load(std::memory_order_relaxed)) {
+        pollfd p{fd_, POLLIN, 0};
+        if (poll(&p, 1, 200) <= 0)
+            continue;
+        int fd = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+        timeval timeout{1, 0}; // a stuck browser must not hold up the next request
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
+        handle(fd);
+        ::close(fd);
+    }
+}
+
+void ViewServer::handle(int fd)
+{
+    char buf[4096];
+    size_t len = 0;
+    while (len < sizeof buf - 1) {
+        ssize_t n = recv(fd, buf + len, sizeof buf - 1 - len, 0);
+        if (n <= 0)
+            return;
+        len += static_cast<size_t>(n);
+        buf[len] = 0;
+        if (std::strstr(buf, "\r\n\r\n"))
+            break;
+    }
+    // "GET /path?query HTTP/1.1"; nothing past the request line matters
+    char method[8], target[1024];
+    if (std::sscanf(buf, "%7s %1023s", method, target) != 2) {
+        respond(fd, "400 Bad Request", "text/plain", "bad request\n");
+        return;
+    }
+    if (std::strcmp(method, "GET") != 0) {
+        respond(fd, "405 Method Not Allowed", "text/plain", "GET only\n");
+        return;
+    }
+    std::string path = target, query;
+    size_t q = path.find('?');
+    if (q != std::string::npos) {
+        query = path.substr(q + 1);
+        path.resize(q);
+    }
+
+    if (path == "/") {
+        respond(fd, "200 OK", "text/html; charset=utf-8", kPage);
+    } else if (path == "/info") {
+        respond(fd, "200 OK", "application/json", plot_.info_json());
+    } else if (path == "/data") {
+        const char* ch = param(query, "ch");
+        const char* from = param(query, "from");
+        const char* to = param(query, "to");
+        const char* w = param(query, "w");
+        if (!ch || !from || !to || !w) {
+            respond(fd, "400 Bad Request", "text/plain", "need ch, from, to and w\n");
+            return;
+        }
+        size_t width = std::min<size_t>(std::strtoul(w, nullptr, 10), 8192);
+        respond(fd, "200 OK", "application/json",
+                plot_.data_json(static_cast<unsigned>(std::atoi(ch)), std::atof(from), std::atof(to), width));
+    } else {
+        respond(fd, "404 Not Found", "text/plain", "not found\n");
+    }
+}
+
+} // namespace tsstand
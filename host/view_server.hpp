@@ -0,0 +1,74 @@
+// Live plot of a run in a web browser: min/max pyramids (pyramid.hpp) of
+// every input, served over HTTP on localhost to a small page that zooms and
+// pans with the mouse.
+// This file is part of the code for the SEDS test stand.
+//
+// The page asks for /info (run header, inputs, time span) and for
+// /data?ch=input&from=s&to=s&w=pixels, which returns at most w min/max
+// columns, and polls again twice a second so a running capture scrolls
+// along. Every request is answered in time proportional to w, so the page
+// stays as quick on a run of hundreds of millions of samples as on a short
+// one. The server only listens on 127.0.0.1.
+#pragma once
+
+#include "pyramid.hpp"
+#include "runfile.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace tsstand {
+
+// The pyramids of every input of a run, safe to append to from one thread
+// while the server reads them from another.
+class LivePlot {
+public:
+    explicit LivePlot(const RunInfo& info) : info_(info) {}
+
+    void append(uint8_t channel, int64_t t, int32_t v)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        plots_[channel].append(t, v);
+    }
+    // n samples under one lock; channels may be nullptr for all input 0
+    void append(const uint8_t* channels, const int64_t* t, const int32_t* v, size_t n);
+    void set_tick_hz(uint32_t hz) { tick_hz_ = hz; }
+    void set_calibration(const Calibration& cal)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        info_.cal = cal;
+    }
+
+    std::string info_json();
+    std::string data_json(unsigned channel, double from_s, double to_s, size_t width);
+
+private:
+    std::mutex mutex_;
+    std::map<uint8_t, MinMaxPyramid> plots_;
+    RunInfo info_;
+    std::atomic<uint32_t> tick_hz_{1000000};
+};
+
+class ViewServer {
+public:
+    // Listens on 127.0.0.1:port. Throws std::system_error on failure.
+    ViewServer(uint16_t port, LivePlot& plot);
+    ~ViewServer();
+
+    ViewServer(const ViewServer&) = delete;
+    ViewServer& operator=(const ViewServer&) = delete;
+
+    // Answers requests, one at a time, until stop is set.
+    void run(const std::atomic<bool>& stop);
+
+private:
+    void handle(int fd);
+
+    int fd_ = -1;
+    LivePlot& plot_;
+};
+
+} // namespace tsstand
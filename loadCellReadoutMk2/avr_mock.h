@@ -0,0 +1,54 @@
+// Stand-in for <avr/io.h> and <avr/interrupt.h> when the sketch's C files
+// are built on the host with -DMK2_HOST (see host/mk2sim.cpp). Only the
+// registers and bits the sketch touches are here; the simulator defines
+// them, writes ADC, and calls ADC_vect for every conversion.
+#ifndef AVR_MOCK_H
+#define AVR_MOCK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+extern volatile uint8_t ADMUX;
+extern volatile uint8_t ADCSRA;
+extern volatile uint8_t ADCSRB;
+extern volatile uint8_t DIDR0;
+extern volatile uint16_t ADC;
+extern volatile uint8_t SREG;
+
+// ADMUX
+#define REFS1 7
+#define REFS0 6
+#define ADLAR 5
+// ADCSRA
+#define ADEN 7
+#define ADSC 6
+#define ADATE 5
+#define ADIF 4
+#define ADIE 3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+// ADCSRB: ADTS2..0 of 0 is free running
+#define ADTS2 2
+#define ADTS1 1
+#define ADTS0 0
+
+#define _BV(bit) (1u << (bit))
+#define cli() ((void)0)
+#define sei() ((void)0)
+
+#define ISR(vector) void vector(void)
+void ADC_vect(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AVR_MOCK_H
@@ -1,32 +1,33 @@
 //This script allows the Arduino to read off the analog measurements from
-//the load cell, convert it to digital counts, and write it to the computer. 
+//the load cell, convert it to digital counts, and write it to the computer.
 //This script is part of UB SEDS small test stand program
 //
 // Ari Rubinsztejn
 // ari@gereshes.com
 // www.gereshes.com
+//
+// The ADC runs free with an interrupt per conversion instead of
+// analogRead, and the readings go out in the PSoC board's binary frames
+// instead of "time,reading" lines built in a String, so nothing blocks and
+// nothing is allocated (see mk2.h). tsacq and the other host tools read
+// it like the PSoC board.
 
+#include "mk2.h"
 
-//Initializing variables
-
-String toPrint;
-int readout;
-int readout1;
-int readout2;
 void setup() {
-  Serial.begin(115200); //starts serial communication  at baud rate of 115200
+  Serial.begin(MK2_BAUD);
+  mk2_Start(MK2_INPUT, MK2_PRESCALER, MK2_AVERAGE);
 }
 
 void loop() {
+  mk2_Poll();
+}
 
-  
-   readout=analogRead(0);//Reads out the value of the sensor
-
-   toPrint=round(micros()/100); //Records the current time
-
-   toPrint+=',';
-   toPrint+=readout;//Combines the current readout with the measurement.
-   
-   Serial.println(toPrint); //Prints the timestamped measurement to the serial line
+uint8_t mk2_SerialRoom(void) {
+  int room = Serial.availableForWrite();
+  return room > 255 ? 255 : (uint8_t)room;
+}
 
-}
+void mk2_SerialWrite(const uint8_t *buf, uint8_t n) {
+  Serial.write(buf, n);
+}
@@ -0,0 +1,119 @@
+#include "mk2.h"
+#include "sampler.h"
+
+#if MK2_PACKED
+// about 40 samples, and the frame still fits the serial buffer whole
+#define FRAME_MAX_PAYLOAD 52u
+#else
+// a hello or eight samples; frame_t then takes 60 bytes of SRAM, not 270
+#define FRAME_MAX_PAYLOAD 44u
+#endif
+#include "tsframe.h"
+#if MK2_PACKED
+#include "tspack.h"
+#endif
+
+#if defined(MK2_HOST)
+#include "avr_mock.h"
+#endif
+
+uint16_t frame_seq = 0;
+
+#if MK2_PACKED
+static pack_t pack;
+#else
+static frame_t frame;
+#endif
+static frame_t hello;
+static frame_t *pending = 0;   // finished, waiting for room in the serial buffer
+static uint16_t frames = 0;
+static uint32_t tick_hz = 0;    // the ADC clock; a conversion is SAMPLER_CLOCKS ticks
+static uint8_t shift = 0;       // log2 of the conversions averaged
+static uint32_t sum = 0;
+static uint8_t n = 0;
+static uint32_t first = 0;      // conversion number of the first in sum
+
+static void begin_samples(void)
+{
+#if MK2_PACKED
+    pack_Begin(&pack, ((uint32_t)SAMPLER_CLOCKS << shift) * 256u);
+#else
+    frame_BeginSamples(&frame);
+#endif
+}
+
+// Takes a sample; returns the frame to send once it is full, else 0.
+static frame_t *add_sample(uint32_t t, int32_t value)
+{
+#if MK2_PACKED
+    if(pack_Add(&pack, t, value)){
+        (void)pack_Finish(&pack);
+        return &pack.frame;
+    }
+#else
+    if(frame_AddSample(&frame, t, value)){
+        frame_Finish(&frame);
+        return &frame;
+    }
+#endif
+    return 0;
+}
+
+void mk2_Start(uint8_t input, uint8_t prescaler, uint8_t average)
+{
+    shift = 0;
+    while(shift < 6u && (2u << shift) <= average){
+        shift++;
+    }
+    tick_hz = F_CPU / sampler_Start(input, prescaler);
+    frame_Hello(&hello, tick_hz, 0u, 0u);
+    begin_samples();
+    pending = &hello;
+}
+
+void mk2_Poll(void)
+{
+    uint32_t index;
+    uint16_t value;
+    uint32_t t;
+
+    if(pending != 0){
+        if(mk2_SerialRoom() < pending->size){
+            return;
+        }
+        mk2_SerialWrite(pending->buf, (uint8_t)pending->size);
+        if(pending == &hello){
+            pending = 0;
+        }else{
+            pending = 0;
+            begin_samples();
+            if(++frames == MK2_HELLO_EVERY){
+                frames = 0;
+                frame_Hello(&hello, tick_hz, 0u, 0u);
+                pending = &hello;
+                return;
+            }
+        }
+    }
+    while(sampler_Get(&index, &value)){
+        if(n != 0u && index != first + n){
+            n = 0; // conversions were lost part way; start the average over
+            sum = 0;
+        }
+        if(n == 0u){
+            first = index;
+        }
+        sum += value;
+        if(++n < (uint8_t)(1u << shift)){
+            continue;
+        }
+        // stamped at the middle of the conversions averaged
+        t = first * SAMPLER_CLOCKS + (((uint32_t)n - 1u) * SAMPLER_CLOCKS) / 2u;
+        pending = add_sample(t, (int32_t)(sum >> shift));
+        n = 0;
+        sum = 0;
+        if(pending != 0){
+            return;
+        }
+    }
+}
@@ -0,0 +1,47 @@
+// The load cell readout: conversions from sampler.h, averaged if asked,
+// go out in tsframe.h's frames as fast as the serial port takes them. The
+// main loop never waits: a finished frame is held until the serial buffer
+// has room for all of it, and the ring in sampler.c covers the wait.
+//
+// The same files build on the host against avr_mock.h (-DMK2_HOST), where
+// host/mk2sim.cpp stands in for the ADC and the serial port and reports
+// whether the link and the CPU keep up.
+#ifndef MK2_H
+#define MK2_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each sample takes 6.5 bytes on the wire, so 1 Mbaud (which the Uno's
+// USB bridge runs at) carries all 9615 conversions a second of prescaler
+// 128. At 115200 baud average 8 of them into each sample instead.
+#define MK2_BAUD 1000000UL
+#define MK2_INPUT 0u
+#define MK2_PRESCALER 128u
+#define MK2_AVERAGE 1u          // conversions per sample sent, a power of two up to 64
+#define MK2_HELLO_EVERY 256u    // sample frames between hellos, for hosts that connect late
+
+// 1 sends packed frames (tspack.h) instead: a sample then takes about a
+// byte and a half, so 115200 baud carries every conversion averaged in
+// twos, at the cost of more of the CPU.
+#ifndef MK2_PACKED
+#define MK2_PACKED 0
+#endif
+
+void mk2_Start(uint8_t input, uint8_t prescaler, uint8_t average);
+// One pass of the main loop.
+void mk2_Poll(void);
+
+// The serial port, from the sketch (or the simulator): bytes that fit in
+// the transmit buffer right now, and queueing n of them.
+uint8_t mk2_SerialRoom(void);
+void mk2_SerialWrite(const uint8_t *buf, uint8_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MK2_H
@@ -0,0 +1,95 @@
+#include "sampler.h"
+
+#if defined(MK2_HOST)
+#include "avr_mock.h"
+#else
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+#define MASK (SAMPLER_RING - 1u)
+#define GAP 0x8000u     // an entry with this bit counts lost conversions
+#define GAP_MAX 0x7FFFu
+
+static volatile uint16_t ring[SAMPLER_RING];
+static volatile uint8_t head = 0; // written by the interrupt only
+static volatile uint8_t tail = 0; // written by the main loop only
+static uint32_t lost = 0;         // not yet in the ring; interrupt only
+static volatile uint32_t overruns = 0;
+static uint32_t next_index = 0;   // main loop only
+
+uint8_t sampler_Start(uint8_t input, uint8_t prescaler)
+{
+    uint8_t bits = 1;
+
+    while(bits < 7u && (2u << bits) <= prescaler){
+        bits++;
+    }
+    cli();
+    head = tail = 0;
+    lost = overruns = next_index = 0;
+    ADMUX = (uint8_t)(_BV(REFS0) | (input & 7u)); // AVcc reference, as analogRead
+    DIDR0 = (uint8_t)_BV(input & 7u);             // no digital input buffer on the pin
+    ADCSRB = 0;                                   // free running
+    ADCSRA = (uint8_t)(_BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIF) | _BV(ADIE) | bits);
+    sei();
+    return (uint8_t)(1u << bits);
+}
+
+static uint8_t push(uint16_t v)
+{
+    uint8_t next = (uint8_t)((head + 1u) & MASK);
+
+    if(next == tail){
+        return 0;
+    }
+    ring[head] = v;
+    head = next;
+    return 1;
+}
+
+ISR(ADC_vect)
+{
+    uint16_t v = ADC;
+    uint16_t chunk;
+
+    if(lost != 0u){
+        chunk = lost > GAP_MAX ? GAP_MAX : (uint16_t)lost;
+        if(push(GAP | chunk)){
+            lost -= chunk;
+        }
+    }
+    if(lost != 0u || push(v) == 0u){
+        lost++;
+        overruns++;
+    }
+}
+
+uint8_t sampler_Get(uint32_t *index, uint16_t *value)
+{
+    uint16_t v;
+
+    while(tail != head){
+        v = ring[tail];
+        tail = (uint8_t)((tail + 1u) & MASK);
+        if(v & GAP){
+            next_index += v & GAP_MAX;
+            continue;
+        }
+        *index = next_index++;
+        *value = v;
+        return 1;
+    }
+    return 0;
+}
+
+uint32_t sampler_Overruns(void)
+{
+    uint8_t sreg = SREG;
+    uint32_t n;
+
+    cli();
+    n = overruns;
+    SREG = sreg;
+    return n;
+}
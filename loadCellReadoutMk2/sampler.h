@@ -0,0 +1,39 @@
+// Free-running ADC capture. The ADC converts back to back on one input,
+// and its conversion complete interrupt puts each result in a ring that
+// the main loop empties with sampler_Get, so nothing waits on analogRead
+// and the samples come at the ADC's own steady rate.
+//
+// A conversion takes 13 ADC clocks of F_CPU / prescaler, so with the
+// prescaler of 128 that keeps the full 10 bits at 16 MHz that is one every
+// 104 us (9615 per second). Conversions that find the ring full are
+// counted, and the count goes into the ring ahead of the next one kept, so
+// sampler_Get still numbers every sample by its conversion.
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SAMPLER_RING 256u   // entries of 2 bytes; at most 256, indices are bytes
+#define SAMPLER_CLOCKS 13u  // ADC clocks per free-running conversion
+
+// Starts converting input (0 to 7) with an ADC clock of F_CPU / prescaler;
+// prescaler is 2 to 128, rounded down to a power of two. Returns the
+// prescaler used.
+uint8_t sampler_Start(uint8_t input, uint8_t prescaler);
+
+// Returns 1 with the next conversion and its number (0 for the first,
+// counting those lost), or 0 if the ring is empty.
+uint8_t sampler_Get(uint32_t *index, uint16_t *value);
+
+// Conversions lost so far because the ring was full.
+uint32_t sampler_Overruns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMPLER_H
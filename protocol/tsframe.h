@@ -0,0 +1,398 @@
+// The stand's wire protocol: the frames the PSoC board and the Arduino
+// sketch send and the host tools read, their CRC, an encoder and an
+// incremental decoder. This one header builds as C99 or C++ into both
+// firmwares and the host, so there is a single definition of the format.
+// This file is part of the code for the SEDS test stand.
+//
+// Every frame looks like this on the wire (multi-byte fields little-endian):
+//
+//   0xA5 0x5A | type (1) | seq (2) | len (1) | payload (len) | crc16 (2)
+//
+// The sequence number counts every frame sent, so the host can spot drops.
+// The CRC is CRC-16/CCITT-FALSE over type, seq, len and payload.
+//
+// Timestamps are in ticks of the rate announced by the hello frame: the
+// PSoC firmware's are microseconds from the cycle counter (timebase.h),
+// the sketch's are ADC clocks.
+//
+// FRAME_TYPE_HELLO payload:   version (1), flags (1), tick rate in Hz (4),
+//                             board ID (2); with FRAME_HELLO_NEWTONS the
+//                             load cell's readings are milli-newtons
+// FRAME_TYPE_SAMPLES payload: t0 (4), then one record per sample:
+//                             dt (2) ticks since the previous sample, 0 for
+//                             the first one, and the reading as a signed
+//                             24-bit integer (3)
+// FRAME_TYPE_BURST payload:   trigger time (4), samples (2), samples before
+//                             the trigger (2), conversions per sample (2);
+//                             sent ahead of the sample frames of a
+//                             triggered capture (see burst.h)
+// FRAME_TYPE_TELEMETRY:       loop profile and loss counters, see profile.h
+// FRAME_TYPE_CHANNEL:         a sample frame from one input of a multiplexed
+//                             board (see hal.h): t0 (4), input (1), then
+//                             records as in FRAME_TYPE_SAMPLES
+// FRAME_TYPE_SYNC:            host to board: token (4); the board answers
+//                             with token (4) and the time in us its sync
+//                             word arrived (4), for the host to line up
+//                             the clocks of several boards
+// FRAME_TYPE_CAL:             host to board: nothing, to ask for the
+//                             calibration in EEPROM, or board ID (2),
+//                             gain (4), offset (4) and flags (1) to store
+//                             one (see calstore.h); the board answers with
+//                             seq (2), board ID (2), gain (4), offset (4),
+//                             flags (1) and a status (1)
+// FRAME_TYPE_COMMAND:         host to board: setting ID (1) and optionally
+//                             a value (4) to set it to; the board answers
+//                             with ID (1), value (4) and a status (1), see
+//                             command.h
+// FRAME_TYPE_PACKED:          the samples of a sample frame, compressed:
+//                             t0 (4), ticks per sample in 24.8 fixed point
+//                             (4), the first reading (3) and the count of
+//                             samples (1), then the rest as Rice coded
+//                             differences, see tspack.h
+// FRAME_TYPE_RATE:            the spacing of the samples from t on: t (4),
+//                             ticks per sample in 24.8 fixed point (4),
+//                             filtered samples averaged into each (2) and
+//                             flags (1); FRAME_RATE_IDLE while the board
+//                             sends the low idle rate (see activity.h). It
+//                             follows the last sample at the old spacing
+//                             and is repeated with the hello
+// FRAME_TYPE_NACK:            host to board: first seq (2) and count (2) of
+//                             frames that never arrived; the board sends
+//                             again the ones it still keeps (see history.h)
+//                             and answers with first (2) and count (2) of
+//                             each run of them it no longer has. It looks at
+//                             no more than FRAME_NACK_MAX_RUN of them and
+//                             passes over the rest; the host asks again
+//
+// A frame sent again keeps the seq it had the first time, with
+// FRAME_RESENT set in its type and the CRC taken over the new type. A
+// decoder must not count the going back of its seq as a gap.
+//
+// Versions: the hello carries FRAME_VERSION. New frame types, and new
+// fields at the end of a payload, keep the version, so readers skip types
+// they do not know and bytes past the fields they do. A change to anything
+// already sent bumps it, and a host should refuse a board whose version is
+// newer than its own.
+//
+// Everything here is static inline except the sequence counter: a program
+// that sends frames with frame_Finish defines frame_seq once.
+#ifndef TSFRAME_H
+#define TSFRAME_H
+
+#include <stdint.h>
+
+#if defined(__AVR__)
+#include <util/crc16.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_SYNC0                 (0xA5u)
+#define FRAME_SYNC1                 (0x5Au)
+#define FRAME_VERSION               (1u)
+
+#define FRAME_HEADER_SIZE           (6u)
+#define FRAME_CRC_SIZE              (2u)
+#ifndef FRAME_MAX_PAYLOAD
+#define FRAME_MAX_PAYLOAD           (255u) // a small board may define less for its frame_t
+#endif
+#define FRAME_MAX_SIZE              (FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD + FRAME_CRC_SIZE)
+
+#define FRAME_TYPE_HELLO            (0x01u)
+#define FRAME_TYPE_SAMPLES          (0x02u)
+#define FRAME_TYPE_BURST            (0x03u)
+#define FRAME_TYPE_TELEMETRY        (0x04u)
+#define FRAME_TYPE_CHANNEL          (0x05u)
+#define FRAME_TYPE_SYNC             (0x06u)
+#define FRAME_TYPE_CAL              (0x07u)
+#define FRAME_TYPE_COMMAND          (0x08u)
+#define FRAME_TYPE_PACKED           (0x09u)
+#define FRAME_TYPE_RATE             (0x0Au)
+#define FRAME_TYPE_NACK             (0x0Bu)
+
+#define FRAME_RESENT                (0x80u) // in the type of a frame sent again
+
+#define FRAME_HELLO_NEWTONS         (0x01u)
+#define FRAME_HELLO_SIZE            (8u)
+
+#define FRAME_RATE_IDLE             (0x01u)
+#define FRAME_RATE_SIZE             (11u)
+
+#define FRAME_NACK_SIZE             (4u)
+#define FRAME_NACK_MAX_RUN          (64u) // frames one NACK to the board may name
+
+#define FRAME_SAMPLE_RECORD_SIZE    (5u)
+#define FRAME_SAMPLES_PER_FRAME     (8u) // 8 samples -> 52 byte frame
+
+extern uint16_t frame_seq; // the sender's; bumped by frame_Finish
+
+typedef struct {
+    uint8_t  buf[FRAME_MAX_SIZE];
+    uint16_t size;      // bytes used in buf, header included
+    uint8_t  count;     // samples added so far
+    uint32_t last_t;    // timestamp of the last sample added
+} frame_t;
+
+// CRC-16/CCITT-FALSE: avr-libc's on the AVR, else a byte table
+#if !defined(__AVR__)
+static const uint16_t frame_crcTable[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+#endif
+
+static inline uint16_t frame_Crc16(uint16_t crc, const uint8_t *data, uint16_t len)
+{
+    while(len--){
+#if defined(__AVR__)
+        crc = _crc_xmodem_update(crc, *data++);
+#else
+        crc = (uint16_t)((crc << 8) ^ frame_crcTable[(uint8_t)(crc >> 8) ^ *data++]);
+#endif
+    }
+    return crc;
+}
+
+static inline uint16_t frame_Get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t frame_Get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void frame_Put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void frame_Put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Fields of a whole frame, from its sync word on.
+static inline uint8_t frame_Type(const uint8_t *frame) { return frame[2]; }
+static inline uint16_t frame_Seq(const uint8_t *frame) { return frame_Get16(&frame[3]); }
+static inline uint8_t frame_Len(const uint8_t *frame) { return frame[5]; }
+static inline const uint8_t *frame_Payload(const uint8_t *frame) { return &frame[FRAME_HEADER_SIZE]; }
+
+// Whether the CRC of a frame of size bytes, header to CRC, matches.
+static inline uint8_t frame_CrcOk(const uint8_t *frame, uint16_t size)
+{
+    uint16_t body = (uint16_t)(size - FRAME_CRC_SIZE);
+
+    return frame_Crc16(0xFFFFu, &frame[2], (uint16_t)(body - 2u)) == frame_Get16(&frame[body]);
+}
+
+// Marks a whole frame, header to CRC, as sent again.
+static inline void frame_MarkResent(uint8_t *frame)
+{
+    uint16_t body = (uint16_t)(FRAME_HEADER_SIZE + frame_Len(frame));
+
+    frame[2] |= FRAME_RESENT;
+    frame_Put16(&frame[body], frame_Crc16(0xFFFFu, &frame[2], (uint16_t)(body - 2u)));
+}
+
+// One sample record: dt and the sign-extended 24-bit reading.
+static inline int32_t frame_Record(const uint8_t *rec, uint16_t *dt)
+{
+    uint32_t raw = (uint32_t)rec[2] | ((uint32_t)rec[3] << 8) | ((uint32_t)rec[4] << 16);
+
+    *dt = frame_Get16(rec);
+    return (int32_t)(raw ^ 0x800000u) - 0x800000;
+}
+
+// Building frames: frame_Begin, then frame_Put for each payload field
+// (little-endian, bytes wide), then frame_Finish, or frame_FinishSeq for a
+// sender that numbers its own frames.
+static inline void frame_Begin(frame_t *f, uint8_t type)
+{
+    f->buf[0] = FRAME_SYNC0;
+    f->buf[1] = FRAME_SYNC1;
+    f->buf[2] = type;
+    f->size = FRAME_HEADER_SIZE;
+    f->count = 0;
+}
+
+static inline void frame_Put(frame_t *f, uint32_t v, uint8_t bytes)
+{
+    while(bytes--){
+        f->buf[f->size++] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+static inline void frame_FinishSeq(frame_t *f, uint16_t seq)
+{
+    frame_Put16(&f->buf[3], seq);
+    f->buf[5] = (uint8_t)(f->size - FRAME_HEADER_SIZE);
+    frame_Put16(&f->buf[f->size], frame_Crc16(0xFFFFu, &f->buf[2], (uint16_t)(f->size - 2u)));
+    f->size += FRAME_CRC_SIZE;
+}
+
+static inline void frame_Finish(frame_t *f)
+{
+    frame_FinishSeq(f, frame_seq++);
+}
+
+// Builds a complete hello frame in f, ready to be sent.
+static inline void frame_Hello(frame_t *f, uint32_t tick_hz, uint8_t flags, uint16_t board_id)
+{
+    frame_Begin(f, FRAME_TYPE_HELLO);
+    frame_Put(f, FRAME_VERSION, 1u);
+    frame_Put(f, flags, 1u);
+    frame_Put(f, tick_hz, 4u);
+    frame_Put(f, board_id, 2u);
+    frame_Finish(f);
+}
+
+static inline void frame_Burst(frame_t *f, uint32_t t, uint16_t count, uint16_t pre, uint16_t stride)
+{
+    frame_Begin(f, FRAME_TYPE_BURST);
+    frame_Put(f, t, 4u);
+    frame_Put(f, count, 2u);
+    frame_Put(f, pre, 2u);
+    frame_Put(f, stride, 2u);
+    frame_Finish(f);
+}
+
+// Sample frames: call frame_AddSample until it returns nonzero (frame full),
+// then frame_Finish and send f->buf / f->size.
+static inline void frame_BeginSamples(frame_t *f)
+{
+    frame_Begin(f, FRAME_TYPE_SAMPLES);
+    f->size += 4u; // t0, filled in by the first sample
+}
+
+static inline void frame_BeginChannel(frame_t *f, uint8_t channel)
+{
+    frame_Begin(f, FRAME_TYPE_CHANNEL);
+    f->size += 4u;
+    f->buf[f->size++] = channel;
+}
+
+static inline uint8_t frame_AddSample(frame_t *f, uint32_t t, int32_t reading)
+{
+    uint8_t *p;
+    uint32_t dt = 0;
+
+    if(f->count == 0u){
+        frame_Put32(&f->buf[FRAME_HEADER_SIZE], t);
+    }else{
+        dt = t - f->last_t;
+        if(dt > 0xFFFFu){
+            dt = 0xFFFFu; // host falls back on t0 of the next frame
+        }
+    }
+    f->last_t = t;
+
+    p = &f->buf[f->size];
+    frame_Put16(p, (uint16_t)dt);
+    p[2] = (uint8_t)reading;
+    p[3] = (uint8_t)(reading >> 8);
+    p[4] = (uint8_t)(reading >> 16);
+    f->size += FRAME_SAMPLE_RECORD_SIZE;
+    f->count++;
+
+    return (f->count >= FRAME_SAMPLES_PER_FRAME);
+}
+
+// Incremental decoding, a byte at a time, into a buffer of the caller's:
+// FRAME_HEADER_SIZE + max_payload + FRAME_CRC_SIZE bytes, so a board that
+// only takes short commands needs little RAM. Longer frames, and frames
+// whose CRC fails, are counted in bad and skipped; the decoder then hunts
+// for the next sync word. (The host's FrameDecoder rescans after a CRC
+// failure instead, and decodes whole reads in place.)
+typedef struct {
+    uint8_t  *buf;
+    uint8_t  max_payload;
+    uint16_t have;      // bytes of the frame in buf so far
+    uint16_t need;      // its size, once the header is in
+    uint32_t bad;
+} frame_decoder_t;
+
+static inline void frame_DecoderInit(frame_decoder_t *d, uint8_t *buf, uint8_t max_payload)
+{
+    d->buf = buf;
+    d->max_payload = max_payload;
+    d->have = 0;
+    d->need = 0;
+    d->bad = 0;
+}
+
+// Takes in one byte; returns 1 once it completes a frame in d->buf whose
+// CRC matches. The frame stays there until the next byte goes in.
+static inline uint8_t frame_Push(frame_decoder_t *d, uint8_t b)
+{
+    if(d->have == 0u){
+        if(b != FRAME_SYNC0){
+            return 0u;
+        }
+    }else if(d->have == 1u && b != FRAME_SYNC1){
+        d->have = (b == FRAME_SYNC0) ? 1u : 0u;
+        return 0u;
+    }
+    d->buf[d->have++] = b;
+    if(d->have == FRAME_HEADER_SIZE){
+        if(d->buf[5] > d->max_payload){
+            d->bad++;
+            d->have = 0;
+            return 0u;
+        }
+        d->need = (uint16_t)(FRAME_HEADER_SIZE + d->buf[5] + FRAME_CRC_SIZE);
+    }
+    if(d->have < FRAME_HEADER_SIZE || d->have < d->need){
+        return 0u;
+    }
+    d->have = 0;
+    if(frame_CrcOk(d->buf, d->need) == 0u){
+        d->bad++;
+        return 0u;
+    }
+    return 1u;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TSFRAME_H
@@ -0,0 +1,388 @@
+// Packed sample frames (FRAME_TYPE_PACKED): the samples of a stream whose
+// readings change little from one to the next, in about a byte each
+// instead of a sample record's five. Like tsframe.h this is one header for
+// the boards and the host, C99 or C++.
+// This file is part of the code for the SEDS test stand.
+//
+// The payload starts with t0 (4), the ticks between samples in 24.8 fixed
+// point (4), the first reading (3) and the number of samples (1), and goes
+// on as a bit stream, most significant bit first, of blocks of up to
+// PACK_BLOCK samples:
+//
+//   k (5) | samples - 1 (4) | late (1) | [timing x samples] | reading x samples
+//
+// A reading is coded as the difference from the one before, folded to
+// unsigned (zigzag: 0, -1, 1, -2, ... to 0, 1, 2, 3, ...) and Rice coded
+// with parameter k: the value >> k in unary (that many 1s, then a 0), then
+// its low k bits. A quotient of PACK_ESCAPE or more is sent as PACK_ESCAPE
+// 1s and the folded value in full instead. The encoder picks k for each
+// block, so noisy stretches and quiet ones both code near their entropy.
+//
+// Timestamps are predicted from t0 and the tick rate, and the prediction
+// locks onto the phase of the real ones as it goes (pack_Lock), so those
+// of a steady stream cost nothing. When a block has a timestamp off the
+// prediction, late is 1 and every sample of the block carries its error,
+// folded, in unary. A sample more than PACK_JITTER ticks off, or far
+// enough from t0 that the prediction would overflow, starts a new frame.
+// The coding is lossless: the host gets back exactly the timestamps and
+// 24-bit readings a sample frame would have carried.
+#ifndef TSPACK_H
+#define TSPACK_H
+
+#include <stdint.h>
+#include "tsframe.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PACK_HEAD                   (12u)  // payload bytes ahead of the bit stream
+#define PACK_BLOCK                  (16u)
+#define PACK_ESCAPE                 (16u)
+#define PACK_RAW_BITS               (25u)  // a folded 24-bit difference
+#define PACK_JITTER                 (8)    // ticks a timestamp may be off its prediction
+#define PACK_MAX_SAMPLES            (255u)
+#define PACK_MAX_SPAN               (1ul << 24) // ticks from t0; keeps the prediction in 32 bits
+
+// bits of a block header, and most a sample can take
+#define PACK_BLOCK_BITS             (10u)
+#define PACK_SAMPLE_BITS            (2u * PACK_JITTER + 1u + PACK_ESCAPE + PACK_RAW_BITS)
+
+#if FRAME_MAX_PAYLOAD < PACK_HEAD + (PACK_BLOCK_BITS + PACK_SAMPLE_BITS + 7u) / 8u
+#error "FRAME_MAX_PAYLOAD is too small for a packed frame"
+#endif
+
+typedef struct {
+    frame_t  frame;
+    uint32_t period;    // ticks per sample, 24.8 fixed point
+    uint32_t t0;
+    uint32_t pred;      // of the last sample taken, ticks after t0 in 24.8
+    int32_t  last;      // reading of the last sample taken
+    uint16_t bits;      // written after the head
+    uint16_t room;      // bits the frame can still take
+    uint8_t  count;     // samples taken, the first included
+    uint8_t  pending;   // of them, waiting in the block below
+    uint32_t zig[PACK_BLOCK];   // folded reading differences
+    int8_t   late[PACK_BLOCK];  // timing errors
+    uint8_t  carry;     // a sample that starts the next frame
+    uint32_t carry_t;
+    int32_t  carry_v;
+} pack_t;
+
+static inline uint32_t pack_Zigzag(int32_t d)
+{
+    return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+}
+
+static inline int32_t pack_Unzigzag(uint32_t z)
+{
+    return (int32_t)(z >> 1) ^ -(int32_t)(z & 1u);
+}
+
+// The reading as a sample frame carries it: the low 24 bits, sign-extended.
+static inline int32_t pack_Reading24(int32_t v)
+{
+    return (int32_t)(((uint32_t)v & 0xFFFFFFu) ^ 0x800000u) - 0x800000;
+}
+
+// Moves the prediction of a sample onto what its real time showed: a
+// timestamp later than predicted means the real time is at least that
+// tick, an earlier one that it is below the next.
+static inline uint32_t pack_Lock(uint32_t pred, uint32_t rel, int32_t late)
+{
+    if(late > 0){
+        return rel << 8;
+    }
+    if(late < 0){
+        return (rel << 8) | 0xFFu;
+    }
+    return pred;
+}
+
+// Appends the low n bits of v (n up to 25).
+static inline void pack_Bits(pack_t *p, uint32_t v, uint8_t n)
+{
+    uint8_t *b;
+    uint8_t used;
+    uint8_t take;
+
+    p->bits = (uint16_t)(p->bits + n);
+    p->room = (uint16_t)(p->room - n);
+    while(n > 0u){
+        used = (uint8_t)((p->bits - n) & 7u);
+        take = (uint8_t)(8u - used);
+        if(take > n){
+            take = n;
+        }
+        b = &p->frame.buf[FRAME_HEADER_SIZE + PACK_HEAD + ((p->bits - n) >> 3)];
+        if(used == 0u){
+            *b = 0u;
+        }
+        n = (uint8_t)(n - take);
+        *b |= (uint8_t)(((v >> n) & ((1u << take) - 1u)) << (8u - used - take));
+    }
+}
+
+static inline void pack_Unary(pack_t *p, uint8_t q)
+{
+    pack_Bits(p, ((1ul << q) - 1u) << 1, (uint8_t)(q + 1u));
+}
+
+static inline uint32_t pack_Cost(const uint32_t *zig, uint8_t n, uint8_t k)
+{
+    uint32_t bits = 0;
+    uint32_t q;
+    uint8_t i;
+
+    for(i = 0; i < n; i++){
+        q = zig[i] >> k;
+        bits += q < PACK_ESCAPE ? q + 1u + k : PACK_ESCAPE + PACK_RAW_BITS;
+    }
+    return bits;
+}
+
+// Codes the samples waiting in the block.
+static inline void pack_Block(pack_t *p)
+{
+    uint32_t sum = 0;
+    uint32_t best;
+    uint32_t cost;
+    uint8_t n = p->pending;
+    uint8_t late = 0;
+    uint8_t k = 0;
+    uint8_t try_k;
+    uint8_t i;
+    uint32_t q;
+
+    if(n == 0u){
+        return;
+    }
+    for(i = 0; i < n; i++){
+        sum += p->zig[i];
+        late |= (uint8_t)(p->late[i] != 0);
+    }
+    // the mean of the block's values puts the best k within one of this
+    while(k < 24u && ((uint32_t)n << (k + 1u)) <= sum){
+        k++;
+    }
+    best = pack_Cost(p->zig, n, k);
+    for(try_k = (uint8_t)(k > 0u ? k - 1u : 0u); try_k <= k + 1u && try_k <= 24u; try_k++){
+        cost = pack_Cost(p->zig, n, try_k);
+        if(cost < best){
+            best = cost;
+            k = try_k;
+        }
+    }
+
+    pack_Bits(p, k, 5u);
+    pack_Bits(p, (uint32_t)(n - 1u), 4u);
+    pack_Bits(p, late, 1u);
+    if(late){
+        for(i = 0; i < n; i++){
+            pack_Unary(p, (uint8_t)pack_Zigzag(p->late[i]));
+        }
+    }
+    for(i = 0; i < n; i++){
+        q = p->zig[i] >> k;
+        if(q < PACK_ESCAPE){
+            pack_Unary(p, (uint8_t)q);
+            if(k > 0u){
+                pack_Bits(p, p->zig[i], k);
+            }
+        }else{
+            pack_Bits(p, (1u << PACK_ESCAPE) - 1u, PACK_ESCAPE);
+            pack_Bits(p, p->zig[i], PACK_RAW_BITS);
+        }
+    }
+    p->pending = 0;
+}
+
+// The worst case of a block of n samples.
+static inline uint16_t pack_Worst(uint8_t n)
+{
+    return (uint16_t)(PACK_BLOCK_BITS + (uint16_t)n * PACK_SAMPLE_BITS);
+}
+
+// Takes a sample. Returns 1 when the frame is full, or when this sample
+// cannot go in it and will start the next: then pack_Finish and send
+// p->frame, and pack_Begin again.
+static inline uint8_t pack_Add(pack_t *p, uint32_t t, int32_t reading)
+{
+    int32_t v = pack_Reading24(reading);
+    uint32_t rel;
+    uint32_t pred;
+    int32_t late;
+    uint8_t *h;
+
+    if(p->count == 0u){
+        p->t0 = t;
+        p->pred = 0x80u; // half a tick: nothing is known yet of the phase
+        p->last = v;
+        p->count = 1u;
+        h = &p->frame.buf[FRAME_HEADER_SIZE];
+        frame_Put32(h, t);
+        frame_Put32(&h[4], p->period);
+        h[8] = (uint8_t)v;
+        h[9] = (uint8_t)(v >> 8);
+        h[10] = (uint8_t)(v >> 16);
+        return 0u;
+    }
+    rel = t - p->t0;
+    pred = p->pred + p->period;
+    late = (int32_t)(rel - (pred >> 8));
+    if(p->pending > 0u && pack_Worst((uint8_t)(p->pending + 1u)) > p->room){
+        pack_Block(p); // the frame is nearly full; finish the block short
+    }
+    if(rel >= PACK_MAX_SPAN || late > PACK_JITTER || late < -PACK_JITTER ||
+       p->count == PACK_MAX_SAMPLES || pack_Worst(1u) > p->room){
+        p->carry = 1u;
+        p->carry_t = t;
+        p->carry_v = v;
+        return 1u;
+    }
+    p->pred = pack_Lock(pred, rel, late);
+    p->zig[p->pending] = pack_Zigzag(v - p->last);
+    p->late[p->pending] = (int8_t)late;
+    p->last = v;
+    p->count++;
+    if(++p->pending == PACK_BLOCK){
+        pack_Block(p);
+    }
+    return (uint8_t)(p->count == PACK_MAX_SAMPLES || pack_Worst(1u) > p->room);
+}
+
+// Starts a frame of samples period / 256 ticks apart, with the sample that
+// did not fit in the last one if there was such.
+static inline void pack_Begin(pack_t *p, uint32_t period)
+{
+    frame_Begin(&p->frame, FRAME_TYPE_PACKED);
+    p->frame.size = FRAME_HEADER_SIZE + PACK_HEAD;
+    p->period = period;
+    p->bits = 0;
+    p->room = (uint16_t)((FRAME_MAX_PAYLOAD - PACK_HEAD) * 8u);
+    p->count = 0;
+    p->pending = 0;
+    if(p->carry){
+        p->carry = 0u;
+        (void)pack_Add(p, p->carry_t, p->carry_v);
+    }
+}
+
+// Codes what is left and closes the frame; p->frame.buf and size are then
+// ready to send. Does nothing but return 0 if no sample was taken.
+static inline uint8_t pack_Finish(pack_t *p)
+{
+    if(p->count == 0u){
+        return 0u;
+    }
+    pack_Block(p);
+    p->frame.buf[FRAME_HEADER_SIZE + 11u] = p->count;
+    p->frame.size = (uint16_t)(FRAME_HEADER_SIZE + PACK_HEAD + (p->bits + 7u) / 8u);
+    frame_Finish(&p->frame);
+    return 1u;
+}
+
+// pack_Begin, dropping the samples taken since the last one and any
+// carried over: after a change of tick rate, or of format.
+static inline void pack_Restart(pack_t *p, uint32_t period)
+{
+    p->carry = 0u;
+    pack_Begin(p, period);
+}
+
+// The reference decoder. Fills t and v with the samples of a payload (up
+// to PACK_MAX_SAMPLES each) and returns how many there are, or 0 if the
+// payload is not a whole packed frame. The host has a faster one.
+typedef struct {
+    const uint8_t *p;
+    uint16_t len;   // bits
+    uint16_t at;
+} pack_reader_t;
+
+static inline uint32_t pack_Read(pack_reader_t *r, uint8_t n)
+{
+    uint32_t v = 0;
+
+    if(r->at + n > r->len){
+        r->at = (uint16_t)(r->len + 1u); // marks the overrun
+        return 0u;
+    }
+    while(n--){
+        v = (v << 1) | ((r->p[r->at >> 3] >> (7u - (r->at & 7u))) & 1u);
+        r->at++;
+    }
+    return v;
+}
+
+// Counts 1s up to the 0 ending them, or up to max of them.
+static inline uint8_t pack_ReadUnary(pack_reader_t *r, uint8_t max)
+{
+    uint8_t q = 0;
+
+    while(q < max && pack_Read(r, 1u)){
+        q++;
+    }
+    return q;
+}
+
+static inline uint16_t pack_Decode(const uint8_t *payload, uint8_t len, uint32_t *t, int32_t *v)
+{
+    pack_reader_t r;
+    uint32_t period;
+    uint32_t pred = 0x80u;
+    uint32_t rel;
+    int32_t late[PACK_BLOCK];
+    uint32_t z;
+    uint16_t count;
+    uint16_t i = 1;
+    uint8_t k;
+    uint8_t n;
+    uint8_t j;
+    uint8_t q;
+
+    if(len < PACK_HEAD || payload[11] == 0u){
+        return 0u;
+    }
+    t[0] = frame_Get32(payload);
+    period = frame_Get32(&payload[4]);
+    v[0] = pack_Reading24((int32_t)((uint32_t)payload[8] | ((uint32_t)payload[9] << 8) |
+                                    ((uint32_t)payload[10] << 16)));
+    count = payload[11];
+    r.p = &payload[PACK_HEAD];
+    r.len = (uint16_t)((len - PACK_HEAD) * 8u);
+    r.at = 0;
+    while(i < count){
+        k = (uint8_t)pack_Read(&r, 5u);
+        n = (uint8_t)(pack_Read(&r, 4u) + 1u);
+        if(k > 24u || i + n > count){
+            return 0u;
+        }
+        for(j = 0; j < n; j++){
+            late[j] = 0;
+        }
+        if(pack_Read(&r, 1u)){
+            for(j = 0; j < n; j++){
+                late[j] = pack_Unzigzag(pack_ReadUnary(&r, 2u * PACK_JITTER + 1u));
+            }
+        }
+        for(j = 0; j < n; j++, i++){
+            q = pack_ReadUnary(&r, PACK_ESCAPE);
+            z = q < PACK_ESCAPE ? ((uint32_t)q << k) | pack_Read(&r, k) : pack_Read(&r, PACK_RAW_BITS);
+            v[i] = pack_Reading24(v[i - 1u] + pack_Unzigzag(z));
+            pred += period;
+            rel = (pred >> 8) + (uint32_t)late[j];
+            pred = pack_Lock(pred, rel, late[j]);
+            t[i] = t[0] + rel;
+        }
+        if(r.at > r.len){
+            return 0u;
+        }
+    }
+    return count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TSPACK_H
@@ -0,0 +1,85 @@
+function run = readRunFile( fileName )
+% This function opens a run file recorded by tsacq without parsing it. The
+% sample and timestamp columns are memory mapped, so even a long run opens
+% instantly. See host/runfile.hpp for the layout. This script is part of
+% the code for the SEDS test stand.
+%
+% Inputs:
+% fileName - String - Path to the run file (Ex: 'burn1.tsr')
+%
+% Outputs:
+% run - Struct - Header fields, plus time (seconds), reading (raw counts),
+%                channel (board input, 0 for the load cell) and load
+%                (Newtons, from the calibration in the header; only
+%                meaningful where channel is 0). Version 3 files add the
+%                calibration's higher terms (calSquare, calCube) and its
+%                temperature input (calTempInput, -1 for none)
+
+fid = fopen(fileName,'r','l');
+if(fid<0)
+    error(['Cannot open ',fileName])
+end
+magic = fread(fid,8,'*char')';
+if(~strncmp(magic,'TSRUN',5))
+    fclose(fid);
+    error([fileName,' is not a run file'])
+end
+run.version = fread(fid,1,'uint32');
+fread(fid,1,'uint32'); %header size
+run.capacity = fread(fid,1,'uint64');
+run.count = fread(fid,1,'uint64');
+timesOffset = fread(fid,1,'uint64');
+samplesOffset = fread(fid,1,'uint64');
+run.tickHz = fread(fid,1,'uint32');
+run.boardId = fread(fid,1,'uint32');
+run.sampleRate = fread(fid,1,'double');
+run.calGain = fread(fid,1,'double');
+run.calOffset = fread(fid,1,'double');
+run.startUnixNs = fread(fid,1,'int64');
+note = fread(fid,64,'*char')';
+run.note = note(1:find([note,char(0)]==0,1)-1);
+channelsOffset = fread(fid,1,'uint64');
+if(run.version<2)
+    channelsOffset = 0; %version 1 files are all load cell
+end
+run.calSquare = 0;
+run.calCube = 0;
+run.calTempGain = 0;
+run.calTempRef = 0;
+run.calTempInput = -1;
+if(run.version>=3)
+    run.calSquare = fread(fid,1,'double');
+    run.calCube = fread(fid,1,'double');
+    run.calTempGain = fread(fid,1,'double');
+    run.calTempRef = fread(fid,1,'double');
+    run.calTempInput = fread(fid,1,'int32');
+end
+fclose(fid);
+
+if(run.count==0)
+    run.time = [];
+    run.reading = [];
+    run.channel = [];
+    run.load = [];
+    return
+end
+times = memmapfile(fileName,'Offset',timesOffset,'Format',{'int64',[1 run.count],'t'},'Repeat',1);
+samples = memmapfile(fileName,'Offset',samplesOffset,'Format',{'int32',[1 run.count],'v'},'Repeat',1);
+run.time = double(times.Data.t)/run.tickHz;
+run.reading = double(samples.Data.v);
+if(channelsOffset>0)
+    channels = memmapfile(fileName,'Offset',channelsOffset,'Format',{'uint8',[1 run.count],'c'},'Repeat',1);
+    run.channel = double(channels.Data.c);
+else
+    run.channel = zeros(1,run.count);
+end
+u = run.reading-run.calOffset;
+run.load = ((run.calCube*u+run.calSquare).*u+run.calGain).*u;
+tempIndex = find(run.channel==run.calTempInput);
+if(run.calTempInput>=0 && ~isempty(tempIndex))
+    %each reading takes the temperature read last before it
+    last = max(cumsum(run.channel==run.calTempInput),1);
+    temp = run.reading(tempIndex(last));
+    run.load = run.load+run.calTempGain*(temp-run.calTempRef);
+end
+end